@@ -1327,6 +1327,38 @@ eccoplist_t* ecc_astparse_breakstatement(eccastparser_t* self, eccstrbox_t text)
     return oplist;
 }
 
+/* calls whose value is returned as is: the whole expression, both sides of ?: and the right side of && and || */
+void ecc_astparse_tailcalls(eccoperand_t* ops, uint32_t count)
+{
+    uint32_t index;
+    int32_t truecount;
+
+    if(ops[0].native == ecc_oper_call)
+        ops[0].native = ecc_oper_tailcall;
+    else if(ops[0].native == ecc_oper_callmember)
+        ops[0].native = ecc_oper_tailcallmember;
+    else if(ops[0].native == ecc_oper_callproperty)
+        ops[0].native = ecc_oper_tailcallproperty;
+    else if((ops[0].native == ecc_oper_logicaland || ops[0].native == ecc_oper_logicalor) && ops[0].opvalue.data.integer > 0)
+        ecc_astparse_tailcalls(ops + count - ops[0].opvalue.data.integer, ops[0].opvalue.data.integer);
+    else if(ops[0].native == ecc_oper_jumpifnot)
+    {
+        /* condition, true side, jump over the false side: the first jump reaching the end is that one */
+        truecount = ops[0].opvalue.data.integer;
+        for(index = truecount + 1; index < count; ++index)
+            if(ops[index].native == ecc_oper_jump && ops[index].opvalue.data.integer == (int32_t)(count - index - 1))
+            {
+                if(truecount > 1)
+                    ecc_astparse_tailcalls(ops + index - truecount + 1, truecount - 1);
+
+                if(index + 1 < count)
+                    ecc_astparse_tailcalls(ops + index + 1, count - index - 1);
+
+                break;
+            }
+    }
+}
+
 eccoplist_t* ecc_astparse_returnstatement(eccastparser_t* self, eccstrbox_t text)
 {
     eccoplist_t* oplist = NULL;
@@ -1341,6 +1373,11 @@ eccoplist_t* ecc_astparse_returnstatement(eccastparser_t* self, eccstrbox_t text
 
     if(!oplist)
         oplist = ecc_oplist_create(ecc_oper_value, ECCValConstUndefined, ecc_strbox_join(text, self->lexer->text));
+#if ECC_CONF_TAILCALLS
+    /* inside try, catch and finally must still run once the call returns */
+    else if(self->function->flags & ECC_SCRIPTFUNCFLAG_STRICTMODE && !self->trydepth)
+        ecc_astparse_tailcalls(oplist->ops, oplist->count);
+#endif
 
     oplist = ecc_oplist_unshift(ecc_oper_make(ecc_oper_result, ECCValConstUndefined, ecc_strbox_join(text, oplist->ops->text)), oplist);
     return oplist;
@@ -1458,6 +1495,7 @@ eccoplist_t* ecc_astparse_allstatement(eccastparser_t* self)
     }
     else if(ecc_astparse_accepttoken(self, ECC_TOK_TRY))
     {
+        ++self->trydepth;
         oplist = ecc_oplist_appendnoop(ecc_astparse_block(self));
         oplist = ecc_oplist_unshift(ecc_oper_make(ecc_oper_try, ecc_value_fromint(oplist->count), text), oplist);
 
@@ -1489,6 +1527,7 @@ eccoplist_t* ecc_astparse_allstatement(eccastparser_t* self)
         if(ecc_astparse_accepttoken(self, ECC_TOK_FINALLY))
             oplist = ecc_oplist_join(oplist, ecc_astparse_block(self));
 
+        --self->trydepth;
         return ecc_oplist_appendnoop(oplist);
     }
     else if(ecc_astparse_accepttoken(self, ECC_TOK_DEBUGGER))
@@ -1569,11 +1608,12 @@ eccoplist_t* ecc_astparse_function(eccastparser_t* self, int isDeclaration, int
     eccoplist_t* oplist = NULL;
     int parameterCount = 0;
 
-    eccoperand_t identifierOp = { 0, ECCValConstUndefined, {}};
+    eccoperand_t identifierOp = { 0, ECCValConstUndefined, {}, ECC_OPCODE_NATIVE, 0, 0, NULL, NULL };
     eccobjfunction_t* parentFunction;
     eccobjfunction_t* function;
     ecchashmap_t* arguments;
     uint32_t slot;
+    uint32_t trydepth;
 
     if(!isGetter && !isSetter)
     {
@@ -1625,7 +1665,10 @@ eccoplist_t* ecc_astparse_function(eccastparser_t* self, int isDeclaration, int
     if(parentFunction->flags & ECC_SCRIPTFUNCFLAG_STRICTMODE)
         self->function->flags |= ECC_SCRIPTFUNCFLAG_STRICTMODE;
 
+    trydepth = self->trydepth;
+    self->trydepth = 0;
     oplist = ecc_oplist_join(oplist, ecc_astparse_sourceelements(self));
+    self->trydepth = trydepth;
     text.length = (int32_t)(self->lexer->text.bytes - text.bytes) + 1;
     ecc_astparse_expecttoken(self, '}');
     self->function = parentFunction;
@@ -1732,14 +1775,19 @@ eccobjfunction_t* ecc_astparse_parsewithenvironment(eccastparser_t* const self,
     ecc_astparse_nexttoken(self);
     oplist = ecc_astparse_sourceelements(self);
     ecc_oplist_optimizewithenvironment(oplist, &function->funcenv, 0);
+#if ECC_CONF_BOXCAPTURES
+    ecc_oplist_boxcaptures(oplist);
+#endif
+    if(self->fusion)
+        ecc_oplist_fuse(oplist, self->fusionReport ? self->lexer->input : NULL);
 
     ecc_object_reserveslots(global, self->reserveGlobalSlots);
 
     if(self->error)
     {
         eccoperand_t errorOps[] = {
-            { ecc_oper_throw, ECCValConstUndefined, self->error->text },
-            { ecc_oper_value, ecc_value_error(self->error), {} },
+            { ecc_oper_throw, ECCValConstUndefined, self->error->text, ECC_OPCODE_NATIVE, 0, 0, NULL, NULL },
+            { ecc_oper_value, ecc_value_error(self->error), {}, ECC_OPCODE_NATIVE, 0, 0, NULL, NULL },
         };
         errorOps->text.flags |= ECC_TEXTFLAG_BREAKFLAG;
 
@@ -1747,6 +1795,7 @@ eccobjfunction_t* ecc_astparse_parsewithenvironment(eccastparser_t* const self,
         oplist = (eccoplist_t*)malloc(sizeof(*oplist));
         oplist->ops = (eccoperand_t*)malloc(sizeof(errorOps));
         oplist->count = sizeof(errorOps) / sizeof(*errorOps);
+        oplist->markepoch = 0;
         memcpy(oplist->ops, errorOps, sizeof(errorOps));
     }
 
@@ -0,0 +1,48 @@
+/*
+ * closure benchmark: functions whose inner functions capture few or none of their locals
+ * (see ecc_oplist_boxcaptures), called in loops so their environments are made once per call.
+ * usage: run boxbench.js [count]
+ */
+var count = +(arguments[0] || 300000);
+
+function doubled(a)
+{
+    var i = 0, t = 0;
+    return a.map(function (x) { return x * 2; }).length;
+}
+
+function scaled(a, k)
+{
+    var i = 0, t = 0, u = 0, v = 0;
+    return a.map(function (x) { return x * k; }).length;
+}
+
+function rare(x)
+{
+    var y = x + 1, z = y * 2;
+    if (x < 0)
+        return function () { return y; };
+    return z;
+}
+
+function counter(start)
+{
+    var n = start, step = 1, limit = 1000, name = "c";
+    return function () { return n += step; };
+}
+
+var a = [1, 2, 3], start = (new Date).getTime(), result = 0, times = [], i;
+for (i = 0; i < count; i++)
+    result += doubled(a);
+times.push((new Date).getTime() - start), start = (new Date).getTime();
+for (i = 0; i < count; i++)
+    result += scaled(a, i);
+times.push((new Date).getTime() - start), start = (new Date).getTime();
+for (i = 0; i < count; i++)
+    result += counter(i)();
+times.push((new Date).getTime() - start), start = (new Date).getTime();
+for (i = 0; i < count; i++)
+    result += rare(i);
+times.push((new Date).getTime() - start);
+
+println("no captures " + times[0] + " ms, one capture " + times[1] + " ms, counters " + times[2] + " ms, rarely closing " + times[3] + " ms (" + result + ")");
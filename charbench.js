@@ -0,0 +1,22 @@
+/*
+ * indexing benchmark: sums charCodeAt over every unit of a long ASCII string
+ * and of one with characters beyond ASCII (see ECC_STRING_CHECKPOINTUNITS in stdstring.c).
+ * usage: run charbench.js [units]
+ */
+var units = +(arguments[0] || 1000000);
+var pieces = ['abcdefgh', 'abcdéfgh', 'ab𐐷cdef'];
+var parts = [], i, s, sum, start;
+for (var p = 0; p < pieces.length; p += 2)
+{
+    parts.length = 0;
+    for (i = 0; i * 8 < units; ++i)
+        parts[i] = (i % 10 == 0) ? pieces[p] : pieces[0];
+
+    s = parts.join('');
+    sum = 0;
+    start = (new Date).getTime();
+    for (i = 0; i < s.length; ++i)
+        sum += s.charCodeAt(i);
+
+    println(s.length + " units" + (p ? " beyond ASCII" : "") + ": " + ((new Date).getTime() - start) + " ms (" + sum + ", " + s.charAt(s.length - 1) + s[s.length - 2] + ")");
+}
@@ -32,6 +32,10 @@ uint32_t ecc_strbuf_sizeforlength(uint32_t length)
         return ecc_strbuf_nextpoweroftwo(size);
 }
 
+/*
+// the buffer of an append builder belongs to it alone until ecc_strbuf_endappend registers it:
+// it grows geometrically, in place when big, and leaves no copies behind.
+*/
 eccstrbuffer_t* ecc_strbuf_reuseorcreate(eccappbuf_t* chars, uint32_t length)
 {
     eccstrbuffer_t *self = NULL, *reuse = chars ? chars->sbufvalue : NULL;
@@ -40,25 +44,17 @@ eccstrbuffer_t* ecc_strbuf_reuseorcreate(eccappbuf_t* chars, uint32_t length)
     {
         return reuse;
     }
-    /*
-    else
+    if(reuse)
     {
-        chars = ecc_mempool_reusablechars(length);
+        self = (eccstrbuffer_t*)ecc_mempool_reallocate(ECC_MEMKIND_CHARS, reuse, ecc_strbuf_sizeforlength(length));
     }
-    */
-    if(!self)
+    else
     {
         if(length < 8)
             return NULL;
 
-        self = (eccstrbuffer_t*)malloc(ecc_strbuf_sizeforlength(length));
-        ecc_mempool_addchars(self);
-    }
-
-    if(reuse)
-        memcpy(self, reuse, sizeof(*self) + reuse->length);
-    else
-    {
+        /* a fresh buffer may well be a swept one: ecc_mempool_allocate keeps freed buffers per size class */
+        self = (eccstrbuffer_t*)ecc_mempool_allocate(ECC_MEMKIND_CHARS, ecc_strbuf_sizeforlength(length));
         memset(self, 0, sizeof(eccstrbuffer_t));
         self->length = chars->units;
         memcpy(self->bytes, chars->buffer, chars->units);
@@ -97,7 +93,7 @@ eccstrbuffer_t* ecc_strbuf_create(const char* format, ...)
 
 eccstrbuffer_t* ecc_strbuf_createsized(int32_t length)
 {
-    eccstrbuffer_t* self = (eccstrbuffer_t*)malloc(ecc_strbuf_sizeforlength(length));
+    eccstrbuffer_t* self = (eccstrbuffer_t*)ecc_mempool_allocate(ECC_MEMKIND_CHARS, ecc_strbuf_sizeforlength(length));
     ecc_mempool_addchars(self);
     memset(self, 0, sizeof(eccstrbuffer_t));
 
@@ -109,7 +105,7 @@ eccstrbuffer_t* ecc_strbuf_createsized(int32_t length)
 
 eccstrbuffer_t* ecc_strbuf_createwithbytes(int32_t length, const char* bytes)
 {
-    eccstrbuffer_t* self = (eccstrbuffer_t*)malloc(ecc_strbuf_sizeforlength(length));
+    eccstrbuffer_t* self = (eccstrbuffer_t*)ecc_mempool_allocate(ECC_MEMKIND_CHARS, ecc_strbuf_sizeforlength(length));
     ecc_mempool_addchars(self);
     memset(self, 0, sizeof(eccstrbuffer_t));
 
@@ -120,6 +116,126 @@ eccstrbuffer_t* ecc_strbuf_createwithbytes(int32_t length, const char* bytes)
     return self;
 }
 
+/*
+// joins two buffers without copying their bytes; both are retained,
+// the per-statement cleanup must not free them under the rope.
+*/
+eccstrbuffer_t* ecc_strbuf_createrope(eccstrbuffer_t* left, eccstrbuffer_t* right)
+{
+    eccstrrope_t* self = (eccstrrope_t*)ecc_mempool_allocate(ECC_MEMKIND_CHARS, sizeof(*self));
+    ecc_mempool_addchars((eccstrbuffer_t*)self);
+    memset(self, 0, sizeof(*self));
+
+    self->length = left->length + right->length;
+    self->flags = ECC_CHARBUFFLAG_ROPE;
+    self->left = left;
+    self->right = right;
+    ++left->refcount;
+    ++right->refcount;
+
+    return (eccstrbuffer_t*)self;
+}
+
+/*
+// 'length' bytes of 'source' from 'offset' on, kept in place; the source is retained like rope halves.
+// short ones are copied, a slice node would not be smaller.
+*/
+eccstrbuffer_t* ecc_strbuf_createslice(eccstrbuffer_t* source, int32_t offset, int32_t length)
+{
+    eccstrslice_t* self;
+
+    source = ecc_strbuf_flatten(source);
+    if(source->flags & ECC_CHARBUFFLAG_SLICE)
+    {
+        offset += ((eccstrslice_t*)source)->offset;
+        source = ((eccstrslice_t*)source)->parent;
+    }
+
+    if(length < ECC_CONF_SLICELENGTH)
+        return ecc_strbuf_createwithbytes(length, source->bytes + offset);
+
+    self = (eccstrslice_t*)ecc_mempool_allocate(ECC_MEMKIND_CHARS, sizeof(*self));
+    ecc_mempool_addchars((eccstrbuffer_t*)self);
+    memset(self, 0, sizeof(*self));
+
+    self->length = length;
+    self->flags = ECC_CHARBUFFLAG_SLICE;
+    self->parent = source;
+    self->offset = offset;
+    ++source->refcount;
+
+    return (eccstrbuffer_t*)self;
+}
+
+/* the bytes of any string buffer; those of a slice are not followed by a null byte */
+const char* ecc_strbuf_bytes(eccstrbuffer_t* self)
+{
+    if(self->flags & ECC_CHARBUFFLAG_ROPE)
+        self = ecc_strbuf_flatten(self);
+
+    if(self->flags & ECC_CHARBUFFLAG_SLICE)
+        return ((eccstrslice_t*)self)->parent->bytes + ((eccstrslice_t*)self)->offset;
+
+    return self->bytes;
+}
+
+/* the bytes of a rope, copied once into a buffer the rope keeps; any other buffer is returned as is */
+eccstrbuffer_t* ecc_strbuf_flatten(eccstrbuffer_t* self)
+{
+    eccstrrope_t* rope = (eccstrrope_t*)self;
+    eccstrbuffer_t *flat, *part;
+    eccstrbuffer_t** stack = NULL;
+    uint32_t count = 0, capacity = 0;
+    int32_t end;
+
+    if(!(self->flags & ECC_CHARBUFFLAG_ROPE))
+        return self;
+    else if(!rope->right)
+        return rope->left;
+
+    flat = ecc_strbuf_createsized(self->length);
+    end = self->length;
+
+    /* fills from the end: repeated appends make left-deep ropes, walked here without recursion */
+    part = self;
+    for(;;)
+    {
+        while(part->flags & ECC_CHARBUFFLAG_ROPE && ((eccstrrope_t*)part)->right)
+        {
+            if(count >= capacity)
+            {
+                long needed = sizeof(*stack) * (capacity = capacity ? capacity * 2 : 16);
+                eccstrbuffer_t** grown = (eccstrbuffer_t**)realloc(stack, needed);
+                if(grown == NULL)
+                {
+                    fprintf(stderr, "in flatten: failed to reallocate for %ld bytes\n", needed);
+                    free(stack);
+                    return flat;
+                }
+                stack = grown;
+            }
+            stack[count++] = ((eccstrrope_t*)part)->left;
+            part = ((eccstrrope_t*)part)->right;
+        }
+        if(part->flags & ECC_CHARBUFFLAG_ROPE)
+            part = ((eccstrrope_t*)part)->left;
+
+        end -= part->length;
+        memcpy(flat->bytes + end, ecc_strbuf_bytes(part), part->length);
+
+        if(!count)
+            break;
+
+        part = stack[--count];
+    }
+    free(stack);
+
+    ++flat->refcount;
+    rope->left = flat;
+    rope->right = NULL;
+    return flat;
+}
+
 void ecc_strbuf_beginappend(eccappbuf_t* chars)
 {
     chars->sbufvalue = NULL;
@@ -380,6 +496,7 @@ eccvalue_t ecc_strbuf_endappend(eccappbuf_t* chars)
     if(chars->sbufvalue)
     {
         self->bytes[self->length] = '\0';
+        ecc_mempool_addchars(self);
         return ecc_value_fromchars(self);
     }
     else
@@ -390,7 +507,7 @@ void ecc_strbuf_destroy(eccstrbuffer_t* self)
 {
     assert(self);
 
-    free(self), self = NULL;
+    ecc_mempool_free(ECC_MEMKIND_CHARS, self), self = NULL;
 }
 
 uint8_t ecc_strbuf_codepointlength(uint32_t cp)
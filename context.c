@@ -110,10 +110,13 @@ void ecc_context_replaceargument(ecccontext_t* self, int argumentIndex, eccvalue
     if(self->execenv->hmapmapitems[2].hmapmapvalue.type == ECC_VALTYPE_OBJECT)
     {
         if(argumentIndex < (int)self->execenv->hmapmapitems[2].hmapmapvalue.data.object->hmapitemcount)
+        {
+            ecc_mempool_writebarrier(self->execenv->hmapmapitems[2].hmapmapvalue.data.object, value);
             self->execenv->hmapmapitems[2].hmapmapvalue.data.object->hmapitemitems[argumentIndex].hmapitemvalue = value;
+        }
     }
     else if(argumentIndex < self->execenv->hmapmapcount - 3)
-        self->execenv->hmapmapitems[argumentIndex + 3].hmapmapvalue = value;
+        ecc_object_setvalue(self->execenv, &self->execenv->hmapmapitems[argumentIndex + 3].hmapmapvalue, value);
 }
 
 eccvalue_t ecc_context_this(ecccontext_t* self)
@@ -0,0 +1,15 @@
+/*
+ * automatic collection benchmark: a long top-level loop creating cyclic garbage,
+ * which reference counting never frees. without collections from within the
+ * evaluation the heap grows with the iterations; compare peak RSS.
+ * usage: run cyclebench.js [iterations]
+ */
+var count = +(arguments[0] || 2000000);
+var start = (new Date).getTime();
+for (var i = 0; i < count; ++i)
+{
+    var a = { index: i, name: 'node' + i };
+    a.self = a;
+    a.other = { back: a };
+}
+println(count + " cycles in " + ((new Date).getTime() - start) + " ms");
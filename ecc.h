@@ -72,6 +72,103 @@
 #define ECC_CONF_MAXELEMENTS 0xffffff
 #define ECC_CONF_MAXCALLDEPTH (512*2)
 #define ECC_CONF_DEFAULTSIZE 8
+/* entries per member-access inline cache; 1 makes every cache monomorphic */
+#define ECC_CONF_INLINECACHESIZE 4
+/* int32 operand pairs in a row before an arithmetic or bitwise operator is rewritten to its int32 version, at most 127 */
+#ifndef ECC_CONF_TYPEFEEDBACK
+    #define ECC_CONF_TYPEFEEDBACK 8
+#endif
+/* objects with more members than this leave their shape for a dictionary (hashed index) */
+#define ECC_CONF_MAXSHAPEMEMBERS 32
+/* past this many shapes, objects gaining a member no shape has a transition for become dictionaries */
+#ifndef ECC_CONF_MAXSHAPES
+    #define ECC_CONF_MAXSHAPES (64 * 1024)
+#endif
+/* the mempool carves objects, functions and small string buffers out of slabs of this many bytes (a power of two) */
+#define ECC_CONF_SLABSIZE (64 * 1024)
+/* slabs are requested from the system this many at a time */
+#define ECC_CONF_SLABSPERARENA 16
+/* freed string buffers too big for the slabs are kept for reuse, up to this many bytes in all */
+#ifndef ECC_CONF_CHARSCACHE
+    #define ECC_CONF_CHARSCACHE (4 * 1024 * 1024)
+#endif
+/* string concatenations at least this many bytes long make a rope, flattened once its bytes are needed */
+#ifndef ECC_CONF_ROPELENGTH
+    #define ECC_CONF_ROPELENGTH 256
+#endif
+/* substrings at least this many bytes long share the bytes of their string instead of copying them */
+#ifndef ECC_CONF_SLICELENGTH
+    #define ECC_CONF_SLICELENGTH 32
+#endif
+/* a string left reachable through its slices alone is kept while they cover 1/this of it, else they copy out */
+#ifndef ECC_CONF_SLICEPIN
+    #define ECC_CONF_SLICEPIN 4
+#endif
+
+/* 1 = run statement chains through the flat ecc_oper_dispatch loop by default; 0 = compile it out */
+#ifndef ECC_CONF_DISPATCHLOOP
+    #define ECC_CONF_DISPATCHLOOP 1
+#endif
+/* 1 = compile hot function and loop bodies to machine code (see jit.c); 0 = compile it out */
+#ifndef ECC_CONF_JIT
+    #if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__)
+        #define ECC_CONF_JIT 1
+    #else
+        #define ECC_CONF_JIT 0
+    #endif
+#endif
+/* times a statement chain is entered by ecc_oper_dispatch before it is compiled, at most 65535 */
+#ifndef ECC_CONF_JITTHRESHOLD
+    #define ECC_CONF_JITTHRESHOLD 100
+#endif
+/* 1 = fuse frequent operand sequences into superinstructions after parsing, by default (see ecc_oplist_fuse) */
+#ifndef ECC_CONF_FUSION
+    #define ECC_CONF_FUSION 1
+#endif
+/* 1 = superinstructions count the dispatches they save in eccstate_t.fusedDispatches; 0 = compile it out */
+#ifndef ECC_CONF_FUSIONCOUNT
+    #define ECC_CONF_FUSIONCOUNT 0
+#endif
+/* 1 = calls in return position of strict functions reuse the calling frame (see ecc_oper_tailcall); 0 = always recurse */
+#ifndef ECC_CONF_TAILCALLS
+    #define ECC_CONF_TAILCALLS 1
+#endif
+/* 1 = functions box only the locals their inner functions capture, in a small heap environment (see ecc_oplist_boxcaptures) */
+#ifndef ECC_CONF_BOXCAPTURES
+    #define ECC_CONF_BOXCAPTURES 1
+#endif
+/* ... when at least this many of their locals and parameters stay uncaptured; functions capturing nothing always go */
+#ifndef ECC_CONF_BOXMINSLOTS
+    #define ECC_CONF_BOXMINSLOTS 12
+#endif
+/* 1 = full collections of big heaps mark and sweep on several threads (pthreads); 0 = compile it out */
+#ifndef ECC_CONF_PARALLELGC
+    #if defined(_WIN32) || defined(__MSDOS__)
+        #define ECC_CONF_PARALLELGC 0
+    #else
+        #define ECC_CONF_PARALLELGC 1
+    #endif
+#endif
+/* threads for a full collection by default, 0 = one per online processor */
+#ifndef ECC_CONF_GCTHREADS
+    #define ECC_CONF_GCTHREADS 0
+#endif
+/* heaps of fewer objects and functions than this are collected on the calling thread alone */
+#ifndef ECC_CONF_PARALLELGCMIN
+    #define ECC_CONF_PARALLELGCMIN (64 * 1024)
+#endif
+/* 1 = collect automatically, also from within an evaluation, once the heap outgrows the policy below */
+#ifndef ECC_CONF_GCAUTO
+    #define ECC_CONF_GCAUTO 1
+#endif
+/* the heap may grow to this percentage of what the last full collection left before the next one */
+#ifndef ECC_CONF_GCGROWTH
+    #define ECC_CONF_GCGROWTH 200
+#endif
+/* ... and never triggers a collection below this many bytes */
+#ifndef ECC_CONF_GCMINIMUMHEAP
+    #define ECC_CONF_GCMINIMUMHEAP (8 * 1024 * 1024)
+#endif
 #define ECC_VERSION ((0 << 24) | (1 << 16) | (0 << 0))
 
 
@@ -83,6 +180,8 @@ enum ecctextflags_t
 enum eccindexflags_t
 {
     ECC_INDEXFLAG_COPYONCREATE = (1 << 0),
+    /* made at runtime (property lookups, JSON): copied, and reclaimed once no live value refers to it */
+    ECC_INDEXFLAG_TRANSIENT = (1 << 1),
 };
 
 enum eccvaltype_t
@@ -174,13 +273,37 @@ enum ecccharbufflags_t
 {
     ECC_CHARBUFFLAG_MARK = 1 << 0,
     ECC_CHARBUFFLAG_ASCIIONLY = 1 << 1,
+    ECC_CHARBUFFLAG_ROPE = 1 << 2,
+    /* counted once: ASCIIONLY is known, other buffers may have checkpoints cached (see ecc_string_charsatindex) */
+    ECC_CHARBUFFLAG_INDEXED = 1 << 3,
+    ECC_CHARBUFFLAG_SLICE = 1 << 4,
 };
 
 
+enum eccmemkind_t
+{
+    ECC_MEMKIND_FUNCTION,
+    ECC_MEMKIND_OBJECT,
+    ECC_MEMKIND_CHARS,
+    ECC_MEMKIND_COUNT,
+};
+
+/* slab cell sizes go from 16 by 8 bytes up to 256, then 512 and 1024; bigger string buffers are malloc'ed */
+#define ECC_MEMPOOL_CLASSCOUNT 33
+#define ECC_MEMPOOL_MAXCELLSIZE 1024
+/* ... and rounded up to a power of two, one free list per power */
+#define ECC_MEMPOOL_LARGECLASSCOUNT 64
+
 enum eccobjflags_t
 {
     ECC_OBJFLAG_MARK = 1 << 0,
     ECC_OBJFLAG_SEALED = 1 << 1,
+    /* allocated since the last collection, or a copy living on the C stack: stores into it are not remembered */
+    ECC_OBJFLAG_YOUNG = 1 << 2,
+    /* listed in the mempool remembered set until the next collection */
+    ECC_OBJFLAG_REMEMBERED = 1 << 3,
+    /* members were retained by ecc_mempool_captureobject, for the unreferenced cleanup */
+    ECC_OBJFLAG_CAPTURED = 1 << 4,
 };
 
 enum eccrxoptions_t
@@ -194,6 +317,8 @@ enum eccobjscriptfuncflags_t
     ECC_SCRIPTFUNCFLAG_NEEDARGUMENTS = 1 << 2,
     ECC_SCRIPTFUNCFLAG_USEBOUNDTHIS = 1 << 3,
     ECC_SCRIPTFUNCFLAG_STRICTMODE = 1 << 4,
+    /* created in a function whose stack environment it skips, for that function's cells or parent */
+    ECC_SCRIPTFUNCFLAG_BOXEDPARENT = 1 << 5,
 };
 
 enum eccenvcolor_t
@@ -216,6 +341,34 @@ enum eccenvattribute_t
 };
 
 
+/*
+* opcodes handled inline by ecc_oper_dispatch.
+* everything else is ECC_OPCODE_NATIVE, and simply calls operand->native.
+*/
+enum eccopcode_t
+{
+    ECC_OPCODE_NATIVE = 0,
+    ECC_OPCODE_NOOP,
+    ECC_OPCODE_NEXT,
+    ECC_OPCODE_NEXTIF,
+    ECC_OPCODE_EXPRESSION,
+    ECC_OPCODE_DISCARD,
+    ECC_OPCODE_DISCARDN,
+    ECC_OPCODE_AUTORELEASEEXPRESSION,
+    ECC_OPCODE_AUTORELEASEDISCARD,
+    ECC_OPCODE_JUMP,
+    ECC_OPCODE_JUMPIF,
+    ECC_OPCODE_JUMPIFNOT,
+    ECC_OPCODE_JUMPIFNOTCOMPARE,
+    ECC_OPCODE_RESULT,
+    ECC_OPCODE_RESULTVOID,
+    ECC_OPCODE_REPOPULATE,
+    ECC_OPCODE_BREAKER,
+    /* statement ops that yield back to the loop instead of calling the next statement */
+    ECC_OPCODE_STATEMENT,
+    ECC_OPCODE_COUNT,
+};
+
 enum eccscriptevalflags_t
 {
     ECC_SCRIPTEVAL_SLOPPYMODE = 0x1,
@@ -307,14 +460,25 @@ typedef struct /**/eccstate_t eccstate_t;
 typedef struct /**/eccoperand_t eccoperand_t;
 typedef struct /**/eccindexkey_t eccindexkey_t;
 typedef struct /**/eccmempool_t eccmempool_t;
+typedef struct /**/eccmemslab_t eccmemslab_t;
+typedef struct /**/eccmemlarge_t eccmemlarge_t;
 typedef struct /**/eccappbuf_t eccappbuf_t;
 typedef struct /**/eccoplist_t eccoplist_t;
+typedef struct /**/eccopcacheentry_t eccopcacheentry_t;
+typedef struct /**/eccopcache_t eccopcache_t;
+typedef struct /**/eccshape_t eccshape_t;
+typedef struct /**/eccshapeentry_t eccshapeentry_t;
 typedef struct /**/eccregexnode_t eccregexnode_t;
 typedef struct /**/eccstrbuffer_t eccstrbuffer_t;
+typedef struct /**/eccstrrope_t eccstrrope_t;
+typedef struct /**/eccstrslice_t eccstrslice_t;
+typedef struct /**/eccstrcheckpoint_t eccstrcheckpoint_t;
+typedef struct /**/eccstrindex_t eccstrindex_t;
 typedef struct /**/eccobjinterntype_t eccobjinterntype_t;
 typedef struct /**/eccobjbool_t eccobjbool_t;
 typedef struct /**/eccobjstring_t eccobjstring_t;
 typedef struct /**/eccobjfunction_t eccobjfunction_t;
+typedef struct /**/eccobjcells_t eccobjcells_t;
 typedef struct /**/eccobjdate_t eccobjdate_t;
 typedef struct /**/eccobjerror_t eccobjerror_t;
 typedef struct /**/eccobjregexp_t eccobjregexp_t;
@@ -325,9 +489,11 @@ typedef union /**/ecchashitem_t ecchashitem_t;
 
 typedef enum eccastlexflags_t eccastlexflags_t;
 typedef enum eccscriptevalflags_t eccscriptevalflags_t;
+typedef enum eccopcode_t eccopcode_t;
 typedef enum eccenvattribute_t eccenvattribute_t;
 typedef enum eccenvcolor_t eccenvcolor_t;
 typedef enum eccobjflags_t eccobjflags_t;
+typedef enum eccmemkind_t eccmemkind_t;
 typedef enum ecccharbufflags_t ecccharbufflags_t;
 typedef enum eccctxoffsettype_t eccctxoffsettype_t;
 typedef enum eccctxspecialtype_t eccctxspecialtype_t;
@@ -369,7 +535,6 @@ struct eccindexkey_t
 {
     union
     {
-        uint8_t depth[4];
         uint32_t integer;
     } data;
 };
@@ -395,10 +560,17 @@ struct eccvalue_t
         eccvalue_t* reference;
     } data;
 
+    /*
+    // key, flags and check only mean something in member and element cells, and are what keeps
+    // a value from shrinking to an 8-byte NaN-boxed word: that needs them moved to the storage first.
+    */
     eccindexkey_t key;
-    eccvaltype_t type;
+    /* eccvaltype_t; the narrow fields keep a value at 16 bytes */
+    int8_t type;
     uint8_t flags;
-    uint32_t check;
+    uint8_t unused;
+    /* 1 for an actual value; last byte, see ecc_object_getslot */
+    uint8_t check;
 };
 
 struct ecccontext_t
@@ -419,6 +591,7 @@ struct ecccontext_t
     int8_t argoffset : 3;
     int8_t isstrictmode : 1;
     int8_t insideenvobject : 1;
+    uint8_t canyield : 1;
 };
 
 struct eccappbuf_t
@@ -436,6 +609,49 @@ struct eccstrbuffer_t
     char bytes[1];
 };
 
+/*
+// a string buffer flagged ECC_CHARBUFFLAG_ROPE: 'length' bytes of left then right, not copied yet.
+// once flattened, right is NULL and left holds the bytes.
+*/
+struct eccstrrope_t
+{
+    int32_t length;
+    int32_t refcount;
+    uint8_t flags;
+    eccstrbuffer_t* left;
+    eccstrbuffer_t* right;
+};
+
+/*
+// a string buffer flagged ECC_CHARBUFFLAG_SLICE: 'length' bytes of parent from 'offset' on (see ecc_strbuf_bytes).
+// the parent is a plain buffer, marked through its slices only by ecc_mempool_collect (see ECC_CONF_SLICEPIN).
+*/
+struct eccstrslice_t
+{
+    int32_t length;
+    int32_t refcount;
+    uint8_t flags;
+    eccstrbuffer_t* parent;
+    int32_t offset;
+};
+
+/* the character holding UTF-16 unit 'unit' starts 'offset' bytes into the buffer */
+struct eccstrcheckpoint_t
+{
+    int32_t unit;
+    int32_t offset;
+};
+
+/* where every ECC_STRING_CHECKPOINTUNITS'th unit of a buffer with characters beyond ASCII falls */
+struct eccstrindex_t
+{
+    const eccstrbuffer_t* chars;
+    int32_t units;
+    uint32_t pointcount;
+    uint32_t pointcapacity;
+    eccstrcheckpoint_t* pointvals;
+};
+
 struct eccobjinterntype_t
 {
     const eccstrbox_t* text;
@@ -454,13 +670,16 @@ union ecchashitem_t
 union ecchashmap_t
 {
     eccvalue_t hmapmapvalue;
-    uint32_t slot[16];
+    /* dictionary index cells, see ecc_object_getslot */
+    uint32_t slot[sizeof(eccvalue_t) / sizeof(uint32_t)];
 };
 
 struct eccobject_t
 {
     eccobject_t* prototype;
     const eccobjinterntype_t* type;
+    /* NULL when hmapmapitems holds its own key index (dictionary mode) */
+    eccshape_t* shape;
     /* these need better names ... */
     ecchashitem_t* hmapitemitems;
     ecchashmap_t* hmapmapitems;
@@ -468,6 +687,8 @@ struct eccobject_t
     uint32_t hmapitemcapacity;
     uint32_t hmapmapcount;
     uint32_t hmapmapcapacity;
+    /* one bit per member key ever added; a clear bit proves the key is not an own member */
+    uint64_t memberbloom;
     int32_t refcount;
     uint8_t flags;
     bool mustdestroymapitems;
@@ -536,6 +757,17 @@ struct eccobjfunction_t
     int argparamcount;
     /*eccobjscriptfuncflags_t*/
     int flags;
+    /* the locals inner functions capture, when boxed apart from the stack environment */
+    eccobjcells_t* cells;
+};
+
+struct eccobjcells_t
+{
+    /* template of the heap environment of each call, whose prototype is the function's parent */
+    eccobject_t environment;
+    uint32_t paramcount;
+    /* funcenv slot << 16 | environment slot of each captured parameter */
+    uint32_t params[];
 };
 
 struct eccobjnumber_t
@@ -581,8 +813,27 @@ struct eccstate_t
     eccioinput_t** inputs;
     uint32_t inputCount;
     int32_t maximumCallDepth;
+    uint32_t gcThreads;
+    uint32_t gcGrowthPercent;
+    size_t gcMinimumHeap;
+    /* oldest end of the C stack of the running evaluation, scanned by automatic collections */
+    const void* gcStackBase;
     unsigned printLastThrow : 1;
     unsigned sloppyMode : 1;
+    unsigned dispatchLoop : 1;
+    unsigned jit : 1;
+    unsigned fusion : 1;
+    unsigned fusionReport : 1;
+    unsigned gcAuto : 1;
+#if ECC_CONF_FUSIONCOUNT
+    uint64_t fusedDispatches;
+#endif
+    /* pending tail call of the returning frame, taken over by its ecc_oper_callops */
+    eccobjfunction_t* tailFunction;
+    eccvalue_t tailThis;
+    eccvalue_t* tailValues;
+    int32_t tailCount;
+    int32_t tailCapacity;
 };
 
 struct eccastlexer_t
@@ -602,12 +853,59 @@ struct eccoperand_t
     eccnativefuncptr_t native;
     eccvalue_t opvalue;
     eccstrbox_t text;
+    uint8_t opcode;
+    /* int32 operand pairs seen by an arithmetic or bitwise operator, see ecc_oper_feedback */
+    uint8_t feedback;
+    /* entries through ecc_oper_dispatch, up to ECC_CONF_JITTHRESHOLD */
+    uint16_t jitcount;
+    eccopcache_t* cache;
+    /* machine code for the chain starting here, once compiled */
+    eccnativefuncptr_t jitcode;
 };
 
 struct eccoplist_t
 {
     uint32_t count;
     eccoperand_t* ops;
+    /* the collection that last marked the values of the ops (see ecc_mempool_markoplist) */
+    uint32_t markepoch;
+};
+
+/*
+* a member found at hmapmapitems[slot] of the object reached by following
+* 'depth' prototype links; holder is only kept (and compared) when depth > 0.
+*/
+struct eccopcacheentry_t
+{
+    eccobject_t* holder;
+    uint32_t slot;
+    uint32_t depth;
+};
+
+struct eccshapeentry_t
+{
+    eccindexkey_t key;
+    uint32_t slot;
+};
+
+struct eccshape_t
+{
+    eccshape_t* parent;
+    eccindexkey_t key;
+    uint32_t count;
+    eccshape_t** transitions;
+    uint32_t transitioncount;
+    uint32_t transitionmask;
+    eccshapeentry_t* table;
+    uint32_t tablemask;
+    uint8_t marked;
+};
+
+struct eccopcache_t
+{
+    eccopcacheentry_t entries[ECC_CONF_INLINECACHESIZE];
+    uint8_t count;
+    uint8_t next;
 };
 
 struct eccastdepths_t
@@ -629,10 +927,86 @@ struct eccastparser_t
     int preferInteger;
     int isstrictmode;
     int reserveGlobalSlots;
+    int fusion;
+    int fusionReport;
+    /* try statements around the current position of the current function */
+    uint32_t trydepth;
+};
+
+/*
+// a slab is one ECC_CONF_SLABSIZE aligned block holding cells of a single kind and size;
+// this header sits at its start, so the slab of any cell is found by masking its address.
+*/
+struct eccmemslab_t
+{
+    eccmemslab_t* next;
+    uint8_t kind;
+    uint8_t sizeclass;
+    uint16_t cellsize;
+    uint16_t celloffset;
+    uint16_t cellcount;
+    uint16_t bumpcount;
+    uint16_t livecount;
+    /* one bit per cell that holds a value; cells are at least 16 bytes */
+    uint32_t livebits[ECC_CONF_SLABSIZE / 16 / 32];
+};
+
+/* header in front of string buffers too big for a slab */
+struct eccmemlarge_t
+{
+    eccmemlarge_t* prev;
+    eccmemlarge_t* next;
+    size_t size;
 };
 
 struct eccmempool_t
 {
+    /* slabs per kind and size class, plus the free cells threaded through them */
+    eccmemslab_t* slabs[ECC_MEMKIND_COUNT][ECC_MEMPOOL_CLASSCOUNT];
+    void* freecells[ECC_MEMKIND_COUNT][ECC_MEMPOOL_CLASSCOUNT];
+    eccmemslab_t* emptyslabs;
+    eccmemlarge_t* largechars;
+    /* freed big string buffers, by power of two (see ECC_CONF_CHARSCACHE) */
+    eccmemlarge_t* largefree[ECC_MEMPOOL_LARGECLASSCOUNT];
+    size_t largefreebytes;
+    char** arenalistvals;
+    uint32_t arenalistcount;
+    uint32_t arenalistcapacity;
+    char* arenanext;
+    uint32_t arenaleft;
+    /* old objects given a reference since the last collection, and young ones stored where the owner is unknown */
+    eccobject_t** remlistvals;
+    uint32_t remlistcount;
+    uint32_t remlistcapacity;
+    /* list entries from these indices on were created since the last collection */
+    uint32_t youngindices[3];
+    /* marked objects whose members are still to be looked at, and whether an incremental mark is running */
+    eccobject_t** graylistvals;
+    uint32_t graylistcount;
+    uint32_t graylistcapacity;
+    int marking;
+    /* objects whose members the outermost capture (or cleanup) still has to retain (or release) */
+    eccobject_t** capturelistvals;
+    uint32_t capturelistcount;
+    uint32_t capturelistcapacity;
+    eccobject_t** cleanuplistvals;
+    uint32_t cleanuplistcount;
+    uint32_t cleanuplistcapacity;
+    int capturing;
+    int cleaningup;
+    /* threads a full collection may use (see ECC_CONF_PARALLELGC), 0 = one per online processor */
+    uint32_t threadcount;
+    /* heap size, as slabs in use plus big string buffers, and the size past which a collection is wanted */
+    uint32_t slabcount;
+    size_t largebytes;
+    size_t collectbytes;
+    int collectpending;
+    uint32_t markepoch;
+    /* set while marking from conservatively scanned memory, with the big string buffers sorted by address (see ecc_mempool_markrange) */
+    int conservative;
+    eccmemlarge_t** largesortedvals;
+    uint32_t largesortedcount;
+    /* creation order, for the unreferenced cleanup of ecc_mempool_collectunreferencedfromindices */
     eccobjfunction_t** funclistvals;
     uint32_t funclistcount;
     uint32_t funclistcapacity;
@@ -802,6 +1176,7 @@ eccvalue_t ecc_value_buffer(const char buffer[7], uint8_t units);
 eccvalue_t ecc_value_fromkey(eccindexkey_t key);
 eccvalue_t ecc_value_fromtext(const eccstrbox_t* text);
 eccvalue_t ecc_value_fromchars(eccstrbuffer_t* chars);
+eccvalue_t ecc_value_fromslice(const eccvalue_t* value, const char* bytes, int32_t length);
 eccvalue_t ecc_value_object(eccobject_t*);
 eccvalue_t ecc_value_error(eccobjerror_t*);
 eccvalue_t ecc_value_string(eccobjstring_t*);
@@ -856,6 +1231,9 @@ void ecc_script_fatal(const char* format, ...);
 eccioinput_t* ecc_script_findinput(eccstate_t* self, eccstrbox_t text);
 void ecc_script_printtextinput(eccstate_t*, eccstrbox_t text, int fullLine);
 void ecc_script_garbagecollect(eccstate_t*);
+void ecc_script_collectyoung(eccstate_t*);
+int ecc_script_collectstep(eccstate_t*, uint32_t budget);
+void ecc_script_autocollect(eccstate_t*);
 
 void ecc_globals_setup(void);
 void ecc_globals_teardown(void);
@@ -882,6 +1260,9 @@ eccobjstring_t *ecc_string_create(eccstrbuffer_t *chars);
 eccvalue_t ecc_string_valueatindex(eccobjstring_t *self, int32_t index);
 eccstrbox_t ecc_string_textatindex(const char *chars, int32_t length, int32_t position, int enableReverse);
 int32_t ecc_string_unitindex(const char *chars, int32_t max, int32_t unit);
+int32_t ecc_string_unitcount(eccstrbuffer_t *chars);
+eccstrbox_t ecc_string_charsatindex(eccstrbuffer_t *chars, int32_t position);
+int32_t ecc_string_charsunitindex(eccstrbuffer_t *chars, int32_t offset);
 
 
 void ecc_regexp_setup(void);
@@ -905,7 +1286,9 @@ eccvalue_t ecc_oper_nextopvalue(ecccontext_t *context);
 eccvalue_t ecc_oper_replacerefvalue(eccvalue_t *ref, eccvalue_t value);
 eccvalue_t ecc_oper_callops(ecccontext_t *context, eccobject_t *environment);
 eccvalue_t ecc_oper_callvalue(ecccontext_t *context, eccvalue_t value, eccvalue_t thisval, int32_t argumentCount, int construct, const eccstrbox_t *textcall);
+eccvalue_t ecc_oper_tailcallvalue(ecccontext_t *context, eccvalue_t value, eccvalue_t thisval, int32_t argumentCount, const eccstrbox_t *textcall);
 eccvalue_t ecc_oper_callopsrelease(ecccontext_t *context, eccobject_t *environment);
+void ecc_oper_boxcells(eccobjfunction_t *function, eccobject_t *environment);
 void ecc_oper_makeenvwithargs(eccobject_t *environment, eccobject_t *arguments, int32_t parameterCount);
 void ecc_oper_makeenvandargswithva(eccobject_t *environment, int32_t parameterCount, int32_t argumentCount, va_list ap);
 void ecc_oper_populateenvwithva(eccobject_t *environment, int32_t parameterCount, int32_t argumentCount, va_list ap);
@@ -953,6 +1336,9 @@ eccvalue_t ecc_oper_getpropertyref(ecccontext_t *context);
 eccvalue_t ecc_oper_getproperty(ecccontext_t *context);
 eccvalue_t ecc_oper_setproperty(ecccontext_t *context);
 eccvalue_t ecc_oper_callproperty(ecccontext_t *context);
+eccvalue_t ecc_oper_tailcall(ecccontext_t *context);
+eccvalue_t ecc_oper_tailcallmember(ecccontext_t *context);
+eccvalue_t ecc_oper_tailcallproperty(ecccontext_t *context);
 eccvalue_t ecc_oper_deleteproperty(ecccontext_t *context);
 eccvalue_t ecc_oper_pushenvironment(ecccontext_t *context);
 eccvalue_t ecc_oper_popenvironment(ecccontext_t *context);
@@ -979,6 +1365,30 @@ eccvalue_t ecc_oper_unsignedrightshift(ecccontext_t *context);
 eccvalue_t ecc_oper_bitwiseand(ecccontext_t *context);
 eccvalue_t ecc_oper_bitwisexor(ecccontext_t *context);
 eccvalue_t ecc_oper_bitwiseor(ecccontext_t *context);
+eccvalue_t ecc_oper_addint(ecccontext_t *context);
+eccvalue_t ecc_oper_minusint(ecccontext_t *context);
+eccvalue_t ecc_oper_multiplyint(ecccontext_t *context);
+eccvalue_t ecc_oper_leftshiftint(ecccontext_t *context);
+eccvalue_t ecc_oper_rightshiftint(ecccontext_t *context);
+eccvalue_t ecc_oper_unsignedrightshiftint(ecccontext_t *context);
+eccvalue_t ecc_oper_bitwiseandint(ecccontext_t *context);
+eccvalue_t ecc_oper_bitwisexorint(ecccontext_t *context);
+eccvalue_t ecc_oper_bitwiseorint(ecccontext_t *context);
+eccvalue_t ecc_oper_addfused(ecccontext_t *context);
+eccvalue_t ecc_oper_minusfused(ecccontext_t *context);
+eccvalue_t ecc_oper_multiplyfused(ecccontext_t *context);
+eccvalue_t ecc_oper_lessfused(ecccontext_t *context);
+eccvalue_t ecc_oper_lessorequalfused(ecccontext_t *context);
+eccvalue_t ecc_oper_morefused(ecccontext_t *context);
+eccvalue_t ecc_oper_moreorequalfused(ecccontext_t *context);
+eccvalue_t ecc_oper_setlocalslotadd(ecccontext_t *context);
+eccvalue_t ecc_oper_setparentslotadd(ecccontext_t *context);
+eccvalue_t ecc_oper_getmemberslot(ecccontext_t *context);
+eccvalue_t ecc_oper_jumpifnotcompare(ecccontext_t *context);
+eccnativefuncptr_t ecc_oper_unfused(const eccnativefuncptr_t native);
+eccnativefuncptr_t ecc_oper_generic(const eccnativefuncptr_t native);
+void ecc_oper_deoptimize(const eccoperand_t *op);
+eccvalue_t ecc_oper_operatevalues(ecccontext_t *context, const eccnativefuncptr_t native, eccvalue_t a, eccvalue_t b);
 eccvalue_t ecc_oper_logicaland(ecccontext_t *context);
 eccvalue_t ecc_oper_logicalor(ecccontext_t *context);
 eccvalue_t ecc_oper_positive(ecccontext_t *context);
@@ -1016,6 +1426,7 @@ eccvalue_t ecc_oper_jumpif(ecccontext_t *context);
 eccvalue_t ecc_oper_jumpifnot(ecccontext_t *context);
 eccvalue_t ecc_oper_result(ecccontext_t *context);
 eccvalue_t ecc_oper_repopulate(ecccontext_t *context);
+void ecc_oper_repopulateframe(ecccontext_t *context);
 eccvalue_t ecc_oper_resultvoid(ecccontext_t *context);
 eccvalue_t ecc_oper_switchop(ecccontext_t *context);
 eccvalue_t ecc_oper_breaker(ecccontext_t *context);
@@ -1027,6 +1438,15 @@ eccvalue_t ecc_oper_iteratelessorequalref(ecccontext_t *context);
 eccvalue_t ecc_oper_iteratemoreref(ecccontext_t *context);
 eccvalue_t ecc_oper_iteratemoreorequalref(ecccontext_t *context);
 eccvalue_t ecc_oper_iterateinref(ecccontext_t *context);
+uint8_t ecc_oper_opcodeof(const eccnativefuncptr_t native);
+void ecc_oper_cacheinsert(eccopcache_t* cache, eccobject_t* holder, uint32_t slot, uint32_t depth);
+eccvalue_t* ecc_oper_cachedmember(eccopcache_t* cache, eccobject_t* self, eccindexkey_t key);
+void ecc_oper_cacheownmember(eccopcache_t* cache, eccobject_t* self, eccindexkey_t key);
+eccvalue_t ecc_oper_dispatch(ecccontext_t *context);
+
+int ecc_jit_compile(eccoperand_t *entry);
+void ecc_jit_release(eccnativefuncptr_t code);
+void ecc_jit_teardown(void);
 
 eccastlexer_t* ecc_astlex_createwithinput(eccioinput_t*);
 void ecc_astlex_destroy(eccastlexer_t*);
@@ -1080,6 +1500,10 @@ eccstrbuffer_t* ecc_strbuf_createva(int32_t length, const char* format, va_list
 eccstrbuffer_t* ecc_strbuf_create(const char* format, ...);
 eccstrbuffer_t* ecc_strbuf_createsized(int32_t length);
 eccstrbuffer_t* ecc_strbuf_createwithbytes(int32_t length, const char* bytes);
+eccstrbuffer_t* ecc_strbuf_createrope(eccstrbuffer_t* left, eccstrbuffer_t* right);
+eccstrbuffer_t* ecc_strbuf_flatten(eccstrbuffer_t* self);
+eccstrbuffer_t* ecc_strbuf_createslice(eccstrbuffer_t* source, int32_t offset, int32_t length);
+const char* ecc_strbuf_bytes(eccstrbuffer_t* self);
 void ecc_strbuf_beginappend(eccappbuf_t*);
 void ecc_strbuf_append(eccappbuf_t*, const char* format, ...);
 void ecc_strbuf_appendcodepoint(eccappbuf_t*, uint32_t cp);
@@ -1099,6 +1523,8 @@ eccrune_t ecc_strbox_character(eccstrbox_t);
 eccrune_t ecc_strbox_nextcharacter(eccstrbox_t* text);
 eccrune_t ecc_strbox_prevcharacter(eccstrbox_t* text);
 void ecc_strbox_advance(eccstrbox_t* text, int32_t units);
+int32_t ecc_strbox_find(eccstrbox_t text, eccstrbox_t search);
+int32_t ecc_strbox_findlast(eccstrbox_t text, eccstrbox_t search);
 uint32_t ecc_strbox_toutf16length(eccstrbox_t);
 uint32_t ecc_strbox_toutf16(eccstrbox_t, uint32_t* wbuffer);
 char* ecc_strbox_tolower(eccstrbox_t, char* x2buffer);
@@ -1123,8 +1549,11 @@ void ecc_object_destroy(eccobject_t*);
 eccvalue_t ecc_object_getmember(ecccontext_t*, eccobject_t*, eccindexkey_t key);
 eccvalue_t ecc_object_putmember(ecccontext_t*, eccobject_t*, eccindexkey_t key, eccvalue_t);
 eccvalue_t* ecc_object_member(eccobject_t*, eccindexkey_t key, int);
+uint32_t ecc_object_getslot(const eccobject_t*, eccindexkey_t key);
+#define ecc_object_bloombit(key) (((uint64_t)1) << (((key).data.integer * UINT32_C(2654435761)) >> 26))
 eccvalue_t* ecc_object_addmember(eccobject_t*, eccindexkey_t key, eccvalue_t, int);
 int ecc_object_deletemember(eccobject_t*, eccindexkey_t key);
+void ecc_object_todictionary(eccobject_t*);
 eccvalue_t ecc_object_getelement(ecccontext_t*, eccobject_t*, uint32_t index);
 eccvalue_t ecc_object_putelement(ecccontext_t*, eccobject_t*, uint32_t index, eccvalue_t);
 eccvalue_t* ecc_object_element(eccobject_t*, uint32_t index, int);
@@ -1136,6 +1565,7 @@ eccvalue_t* ecc_object_property(eccobject_t*, eccvalue_t primitive, int);
 eccvalue_t* ecc_object_addproperty(eccobject_t*, eccvalue_t primitive, eccvalue_t, int);
 int ecc_object_deleteproperty(eccobject_t*, eccvalue_t primitive);
 eccvalue_t ecc_object_putvalue(ecccontext_t*, eccobject_t*, eccvalue_t*, eccvalue_t);
+eccvalue_t ecc_object_setvalue(eccobject_t*, eccvalue_t*, eccvalue_t);
 eccvalue_t ecc_object_getvalue(ecccontext_t*, eccobject_t*, eccvalue_t*);
 void ecc_object_packvalue(eccobject_t*);
 void ecc_object_stripmap(eccobject_t*);
@@ -1160,6 +1590,8 @@ eccoplist_t* ecc_oplist_append(eccoplist_t*, eccoperand_t op);
 eccoplist_t* ecc_oplist_appendnoop(eccoplist_t*);
 eccoplist_t* ecc_oplist_createloop(eccoplist_t* initial, eccoplist_t* condition, eccoplist_t* step, eccoplist_t* body, int reverseCondition);
 void ecc_oplist_optimizewithenvironment(eccoplist_t*, eccobject_t* environment, uint32_t index);
+void ecc_oplist_fuse(eccoplist_t*, eccioinput_t* report);
+void ecc_oplist_boxcaptures(eccoplist_t*);
 void ecc_oplist_dumpto(eccoplist_t*, FILE* file);
 eccstrbox_t ecc_oplist_text(eccoplist_t* oplist);
 
@@ -1189,10 +1621,25 @@ void ecc_keyidx_setup(void);
 void ecc_keyidx_teardown(void);
 eccindexkey_t ecc_keyidx_makewithcstring(const char* cString);
 eccindexkey_t ecc_keyidx_makewithtext(const eccstrbox_t text, int flags);
+uint32_t ecc_keyidx_hashtext(const eccstrbox_t text);
 eccindexkey_t ecc_keyidx_search(const eccstrbox_t text);
 int ecc_keyidx_isequal(eccindexkey_t, eccindexkey_t);
 const eccstrbox_t* ecc_keyidx_textof(eccindexkey_t);
 void ecc_keyidx_dumpto(eccindexkey_t, FILE*);
+void ecc_keyidx_mark(eccindexkey_t);
+void ecc_keyidx_marktext(const eccstrbox_t*);
+void ecc_keyidx_collectunmarked(void);
+uint32_t ecc_keyidx_livecount(void);
+uint32_t ecc_keyidx_createdcount(void);
+
+void ecc_shape_setup(void);
+void ecc_shape_teardown(void);
+eccshape_t* ecc_shape_root(void);
+uint32_t ecc_shape_count(void);
+uint32_t ecc_shape_find(eccshape_t* self, eccindexkey_t key);
+eccshape_t* ecc_shape_transition(eccshape_t* self, eccindexkey_t key);
+void ecc_shape_mark(eccshape_t* self);
+void ecc_shape_collectunmarked(void);
 
 void ecc_mempool_markobject(eccobject_t *object);
 void ecc_mempool_markchars(eccstrbuffer_t *chars);
@@ -1201,6 +1648,9 @@ void ecc_mempool_teardown(void);
 void ecc_mempool_addfunction(eccobjfunction_t *function);
 void ecc_mempool_addobject(eccobject_t *object);
 void ecc_mempool_addchars(eccstrbuffer_t *chars);
+void *ecc_mempool_allocate(eccmemkind_t kind, size_t size);
+void ecc_mempool_free(eccmemkind_t kind, void *cell);
+void *ecc_mempool_reallocate(eccmemkind_t kind, void *cell, size_t size);
 void ecc_mempool_unmarkall(void);
 void ecc_mempool_markvalue(eccvalue_t value);
 void ecc_mempool_releaseobject(eccobject_t *object);
@@ -1212,6 +1662,31 @@ void ecc_mempool_collectunmarked(void);
 void ecc_mempool_collectunreferencedfromindices(uint32_t indices[3]);
 void ecc_mempool_unreferencefromindices(uint32_t indices[3]);
 void ecc_mempool_getindices(uint32_t indices[3]);
+void ecc_mempool_escape(eccvalue_t value);
+void ecc_mempool_remember(eccobject_t *object);
+void ecc_mempool_markroot(eccvalue_t value);
+void ecc_mempool_unmarkyoung(void);
+void ecc_mempool_collectyoung(void);
+void ecc_mempool_startmark(void);
+int ecc_mempool_markstep(uint32_t budget);
+void ecc_mempool_finishmark(void);
+int ecc_mempool_ismarking(void);
+void ecc_mempool_setthreads(uint32_t count);
+void ecc_mempool_collectunmarkedinorder(void);
+void ecc_mempool_markoplist(eccoplist_t* oplist);
+void ecc_mempool_markstack(const void* base);
+void ecc_mempool_markrange(const void* from, const void* to);
+size_t ecc_mempool_heapbytes(void);
+void ecc_mempool_setcollectbytes(size_t bytes);
+int ecc_mempool_collectpending(void);
+/* write barriers: call before storing 'value' into a member or element of 'object', or giving it a new member */
+#define ecc_mempool_ownerbarrier(object) \
+    (!((object)->flags & (ECC_OBJFLAG_YOUNG | ECC_OBJFLAG_REMEMBERED)) ? ecc_mempool_remember(object) : (void)0)
+#define ecc_mempool_writebarrier(object, value) \
+    (((value).type & (ECC_VALMASK_OBJECT | ECC_VALMASK_STRING)) ? ecc_mempool_ownerbarrier(object) : (void)0)
+/* ... or when the owner of the slot is not known: the value itself is kept, or marked during an incremental mark */
+#define ecc_mempool_escapebarrier(value) \
+    (((value).type & (ECC_VALMASK_OBJECT | ECC_VALMASK_STRING)) ? ecc_mempool_escape(value) : (void)0)
 
 
 
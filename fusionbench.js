@@ -0,0 +1,53 @@
+/*
+ * fusion benchmark: loops whose ops are fused into superinstructions (see ecc_oplist_fuse):
+ * arithmetic and comparisons on slots and constants, x = x + k and member access on a slot.
+ * usage: run [--no-jit] [--fusion | --no-fusion] fusionbench.js [count]
+ */
+var count = +(arguments[0] || 1000000);
+
+function sum(n)
+{
+    var s = 0, i = 0, k = 3;
+    while (i < n)
+    {
+        s = s + k;
+        i = i + 1;
+        if (s > 1000)
+            s = s - i;
+    }
+    return s;
+}
+
+function poly(n)
+{
+    var x = 0.5, y = 0, i;
+    for (i = 0; i < n; i = i + 1)
+    {
+        y = x * x;
+        x = y + 0.25;
+        if (x >= 2)
+            x = x - 2;
+    }
+    return x;
+}
+
+function lengths(n)
+{
+    var a = [1, 2, 3], t = 0, i = 0;
+    while (i < n)
+    {
+        t = t + a.length;
+        i = i + 1;
+    }
+    return t;
+}
+
+var start = (new Date).getTime(), result = 0, times = [];
+result += sum(count);
+times.push((new Date).getTime() - start), start = (new Date).getTime();
+result += poly(count);
+times.push((new Date).getTime() - start), start = (new Date).getTime();
+result += lengths(count);
+times.push((new Date).getTime() - start);
+
+println("sum " + times[0] + " ms, poly " + times[1] + " ms, lengths " + times[2] + " ms (" + result + ")");
@@ -0,0 +1,18 @@
+/*
+ * collector benchmark: builds a large live heap of small objects, arrays and strings
+ * hanging off a global, for the timed full collection that follows the script.
+ * usage: run --gc-threads=<count> gcbench.js [objects]
+ * (compare --gc-threads=1 against one per core; 0 = one per online processor)
+ */
+var count = +(arguments[0] || 1000000);
+var start = (new Date).getTime();
+heap = [];
+for (var i = 0; i < count; ++i)
+{
+    var node = { id: i, tag: 'n' + (i % 1000), next: i ? heap[i - 1] : null };
+    if (i % 4 == 0)
+        node.items = [i, i + 1, { parent: node }];
+
+    heap[i] = node;
+}
+println(count + " objects built in " + ((new Date).getTime() - start) + " ms");
@@ -0,0 +1,29 @@
+/*
+ * int32 benchmark: md5-style rounds of +, |, &, ^, << and >>> on int32 values,
+ * which type feedback rewrites to int32 operators (see ecc_oper_feedback).
+ * compare run --no-jit against the generic operators with ECC_CONF_TYPEFEEDBACK=127.
+ * usage: run [--jit | --no-jit] intbench.js [rounds]
+ */
+var rounds = +(arguments[0] || 200000);
+
+function rotate(x, c)
+{
+    return x << c | x >>> 32 - c;
+}
+
+function step(a, b, c, d, x, s, t)
+{
+    return rotate(a + (b & c | ~b & d) + x + t | 0, s) + b | 0;
+}
+
+var a = 0x67452301, b = 0xefcdab89 | 0, c = 0x98badcfe | 0, d = 0x10325476, t;
+var start = (new Date).getTime();
+for (var i = 0; i < rounds; ++i)
+{
+    t = step(a, b, c, d, i & 0xffff, 7, -680876936);
+    a = d;
+    d = c;
+    c = b;
+    b = t ^ (i >> 3);
+}
+println("md5 rounds " + rounds + ": " + (a ^ b ^ c ^ d) + " in " + ((new Date).getTime() - start) + " ms");
@@ -0,0 +1,1689 @@
+/*
+//  jit.c
+//  libecc
+//
+//  Licensed under MIT license, see LICENSE.txt file in project root
+*/
+
+#include "ecc.h"
+
+#if ECC_CONF_JIT
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+* baseline compiler for x86-64 (System V).
+* a statement chain entered often enough through ecc_oper_dispatch (function bodies,
+* loop bodies) is turned into machine code that does what the dispatch loop would do
+* from that operand on, statement by statement:
+* - control-flow opcodes become jumps, 'iterate' loops are compiled in place;
+* - numbers, local and parent slots, arithmetic, comparisons and bitwise operators
+*   are evaluated inline, guarded by the operand types, with a call to the generic
+*   operation when a guard fails;
+* - any other operand is called as it is, with context->ops pointing at it,
+*   and evaluates its own sub-operands by threading;
+* - a statement the compiler does not know resumes ecc_oper_dispatch at that statement.
+* the generated function has the signature of a native, and rbx holds the context.
+*/
+
+/* 1 = check after each called operand that it left context->ops where the interpreter would */
+#ifndef ECC_JIT_DEBUG
+    #define ECC_JIT_DEBUG 0
+#endif
+/* 16-byte frame slots for the operands of nested inline operators */
+#define ECC_JIT_TEMPS 32
+/* statements compiled per entry, the rest is left to the interpreter */
+#define ECC_JIT_BUDGET 1024
+
+typedef struct eccjitplace_t eccjitplace_t;
+typedef struct eccjitstmt_t eccjitstmt_t;
+typedef struct eccjitpatch_t eccjitpatch_t;
+typedef struct eccjitregion_t eccjitregion_t;
+typedef struct eccjitstate_t eccjitstate_t;
+
+enum eccjitreg_t
+{
+    ECC_JITREG_AX = 0,
+    ECC_JITREG_CX = 1,
+    ECC_JITREG_DX = 2,
+    ECC_JITREG_BX = 3,
+    ECC_JITREG_SP = 4,
+    ECC_JITREG_BP = 5,
+    ECC_JITREG_SI = 6,
+    ECC_JITREG_DI = 7,
+    ECC_JITREG_R8 = 8,
+    ECC_JITREG_R9 = 9,
+    ECC_JITREG_R11 = 11,
+    ECC_JITREG_R12 = 12,
+};
+
+/* condition codes, as in jcc rel32 (0f 80+cc); the inverse is cc ^ 1 */
+enum eccjitcond_t
+{
+    ECC_JITCC_ALWAYS = -1,
+    ECC_JITCC_O = 0x0,
+    ECC_JITCC_B = 0x2,
+    ECC_JITCC_AE = 0x3,
+    ECC_JITCC_E = 0x4,
+    ECC_JITCC_NE = 0x5,
+    ECC_JITCC_BE = 0x6,
+    ECC_JITCC_A = 0x7,
+    ECC_JITCC_S = 0x8,
+    ECC_JITCC_P = 0xa,
+    ECC_JITCC_NP = 0xb,
+    ECC_JITCC_L = 0xc,
+    ECC_JITCC_GE = 0xd,
+    ECC_JITCC_LE = 0xe,
+    ECC_JITCC_G = 0xf,
+};
+
+/* where an operand value is: [reg + disp] */
+struct eccjitplace_t
+{
+    int reg;
+    int32_t disp;
+};
+
+/* a statement compiled for a chain; 'chain' 0 returns from the generated function, others end a loop body */
+struct eccjitstmt_t
+{
+    const eccoperand_t* op;
+    uint32_t chain;
+    uint32_t label;
+    int emitted;
+};
+
+struct eccjitpatch_t
+{
+    uint32_t at;
+    uint32_t label;
+};
+
+/* pages holding the code of one compile, which starts with a pointer back to this */
+struct eccjitregion_t
+{
+    eccjitregion_t* next;
+    eccjitregion_t* previous;
+    void* memory;
+    size_t size;
+};
+
+#define ECC_JIT_REGIONHEADER 16
+
+struct eccjitstate_t
+{
+    const eccoperand_t* entry;
+    uint8_t* code;
+    uint32_t length;
+    uint32_t capacity;
+    int32_t* labels;
+    uint32_t labelcount;
+    uint32_t labelcapacity;
+    eccjitpatch_t* patches;
+    uint32_t patchcount;
+    uint32_t patchcapacity;
+    eccjitstmt_t* stmts;
+    uint32_t stmtcount;
+    uint32_t stmtcapacity;
+    /* label a loop body jumps to when done, by chain */
+    uint32_t* chainends;
+    uint32_t chaincount;
+    uint32_t chaincapacity;
+    uint32_t loops;
+    uint32_t framepatch;
+    uint32_t budget;
+    int failed;
+};
+
+static eccjitregion_t* g_jitregions = NULL;
+
+static int ecc_jit_grow(void** items, uint32_t* capacity, uint32_t count, size_t size)
+{
+    size_t needed;
+    void* tmp;
+    if(count < *capacity)
+    {
+        return 1;
+    }
+    needed = size * (*capacity ? *capacity * 2 : 64);
+    tmp = realloc(*items, needed);
+    if(tmp == NULL)
+    {
+        fprintf(stderr, "in ecc_jit_grow: failed to reallocate for %ld bytes\n", (long)needed);
+        return 0;
+    }
+    *items = tmp;
+    *capacity = needed / size;
+    return 1;
+}
+
+/* machine code */
+
+static void ecc_jit_emit(eccjitstate_t* state, const void* bytes, uint32_t count)
+{
+    while(state->length + count > state->capacity)
+    {
+        if(!ecc_jit_grow((void**)&state->code, &state->capacity, state->length + count, 1))
+        {
+            state->failed = 1;
+            return;
+        }
+    }
+    memcpy(state->code + state->length, bytes, count);
+    state->length += count;
+}
+
+static void ecc_jit_byte(eccjitstate_t* state, uint8_t byte)
+{
+    ecc_jit_emit(state, &byte, 1);
+}
+
+static void ecc_jit_int32(eccjitstate_t* state, int32_t value)
+{
+    ecc_jit_emit(state, &value, 4);
+}
+
+/*
+* [prefix] [rex] opcode modrm; 'reg' is the modrm reg field (a register or an opcode extension),
+* 'rm' a register, or the base of [rm + disp32] when 'memory'.
+* opcodes above 0xff are emitted high byte first (0x0f10 is 0f 10).
+*/
+static void ecc_jit_modrm(eccjitstate_t* state, uint8_t prefix, int wide, uint32_t opcode, int reg, int rm, int32_t disp, int memory)
+{
+    uint8_t rex;
+    rex = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0);
+    if(prefix)
+    {
+        ecc_jit_byte(state, prefix);
+    }
+    if(rex != 0x40)
+    {
+        ecc_jit_byte(state, rex);
+    }
+    if(opcode > 0xff)
+    {
+        ecc_jit_byte(state, opcode >> 8);
+    }
+    ecc_jit_byte(state, opcode & 0xff);
+    if(!memory)
+    {
+        ecc_jit_byte(state, 0xc0 | (reg & 7) << 3 | (rm & 7));
+        return;
+    }
+    ecc_jit_byte(state, 0x80 | (reg & 7) << 3 | (rm & 7));
+    if((rm & 7) == ECC_JITREG_SP)
+    {
+        ecc_jit_byte(state, 0x24);
+    }
+    ecc_jit_int32(state, disp);
+}
+
+static void ecc_jit_load(eccjitstate_t* state, int reg, int base, int32_t disp)
+{
+    ecc_jit_modrm(state, 0, 1, 0x8b, reg, base, disp, 1);
+}
+
+static void ecc_jit_store(eccjitstate_t* state, int base, int32_t disp, int reg)
+{
+    ecc_jit_modrm(state, 0, 1, 0x89, reg, base, disp, 1);
+}
+
+static void ecc_jit_load32(eccjitstate_t* state, int reg, int base, int32_t disp)
+{
+    ecc_jit_modrm(state, 0, 0, 0x8b, reg, base, disp, 1);
+}
+
+static void ecc_jit_loadbyte(eccjitstate_t* state, int reg, int base, int32_t disp)
+{
+    /* movzx r32, byte [base + disp] */
+    ecc_jit_modrm(state, 0, 0, 0x0fb6, reg, base, disp, 1);
+}
+
+static void ecc_jit_storebyte(eccjitstate_t* state, int base, int32_t disp, int reg)
+{
+    ecc_jit_modrm(state, 0, 0, 0x88, reg, base, disp, 1);
+}
+
+static void ecc_jit_storeimm32(eccjitstate_t* state, int base, int32_t disp, int32_t value)
+{
+    ecc_jit_modrm(state, 0, 0, 0xc7, 0, base, disp, 1);
+    ecc_jit_int32(state, value);
+}
+
+static void ecc_jit_cmpbyte(eccjitstate_t* state, int base, int32_t disp, uint8_t value)
+{
+    ecc_jit_modrm(state, 0, 0, 0x80, 7, base, disp, 1);
+    ecc_jit_byte(state, value);
+}
+
+static void ecc_jit_testbyte(eccjitstate_t* state, int base, int32_t disp, uint8_t value)
+{
+    ecc_jit_modrm(state, 0, 0, 0xf6, 0, base, disp, 1);
+    ecc_jit_byte(state, value);
+}
+
+static void ecc_jit_lea(eccjitstate_t* state, int reg, int base, int32_t disp)
+{
+    ecc_jit_modrm(state, 0, 1, 0x8d, reg, base, disp, 1);
+}
+
+static void ecc_jit_move(eccjitstate_t* state, int to, int from)
+{
+    ecc_jit_modrm(state, 0, 1, 0x89, from, to, 0, 0);
+}
+
+static void ecc_jit_moveimm(eccjitstate_t* state, int reg, uint64_t value)
+{
+    if(reg & 8)
+    {
+        ecc_jit_byte(state, value > UINT32_MAX ? 0x49 : 0x41);
+    }
+    else if(value > UINT32_MAX)
+    {
+        ecc_jit_byte(state, 0x48);
+    }
+    ecc_jit_byte(state, 0xb8 | (reg & 7));
+    if(value > UINT32_MAX)
+    {
+        ecc_jit_emit(state, &value, 8);
+    }
+    else
+    {
+        ecc_jit_int32(state, (int32_t)value);
+    }
+}
+
+static void ecc_jit_moveaddress(eccjitstate_t* state, int reg, const void* address)
+{
+    ecc_jit_moveimm(state, reg, (uint64_t)(uintptr_t)address);
+}
+
+static void ecc_jit_call(eccjitstate_t* state, const void* function)
+{
+    ecc_jit_moveaddress(state, ECC_JITREG_R11, function);
+    ecc_jit_modrm(state, 0, 0, 0xff, 2, ECC_JITREG_R11, 0, 0);
+}
+
+static void ecc_jit_leave(eccjitstate_t* state)
+{
+    /* lea rsp, [rbp - 16]; pop r12; pop rbx; pop rbp */
+    ecc_jit_lea(state, ECC_JITREG_SP, ECC_JITREG_BP, -16);
+    ecc_jit_byte(state, 0x41);
+    ecc_jit_byte(state, 0x5c);
+    ecc_jit_byte(state, 0x5b);
+    ecc_jit_byte(state, 0x5d);
+}
+
+/* xmm arithmetic on two registers: addsd 58, mulsd 59, subsd 5c, divsd 5e, ucomisd 66 0f 2e */
+static void ecc_jit_sse(eccjitstate_t* state, uint8_t prefix, uint32_t opcode, int to, int from)
+{
+    ecc_jit_modrm(state, prefix, 0, opcode, to, from, 0, 0);
+}
+
+static void ecc_jit_loadsd(eccjitstate_t* state, int xmm, eccjitplace_t place)
+{
+    ecc_jit_modrm(state, 0xf2, 0, 0x0f10, xmm, place.reg, place.disp, 1);
+}
+
+static void ecc_jit_movqfromxmm(eccjitstate_t* state, int reg, int xmm)
+{
+    ecc_jit_modrm(state, 0x66, 1, 0x0f7e, xmm, reg, 0, 0);
+}
+
+/* labels */
+
+static uint32_t ecc_jit_label(eccjitstate_t* state)
+{
+    if(!ecc_jit_grow((void**)&state->labels, &state->labelcapacity, state->labelcount, sizeof(*state->labels)))
+    {
+        state->failed = 1;
+        return 0;
+    }
+    state->labels[state->labelcount] = -1;
+    return state->labelcount++;
+}
+
+static void ecc_jit_bind(eccjitstate_t* state, uint32_t label)
+{
+    if(label < state->labelcount)
+    {
+        state->labels[label] = state->length;
+    }
+}
+
+static void ecc_jit_jump(eccjitstate_t* state, int cc, uint32_t label)
+{
+    if(cc == ECC_JITCC_ALWAYS)
+    {
+        ecc_jit_byte(state, 0xe9);
+    }
+    else
+    {
+        ecc_jit_byte(state, 0x0f);
+        ecc_jit_byte(state, 0x80 | cc);
+    }
+    if(!ecc_jit_grow((void**)&state->patches, &state->patchcapacity, state->patchcount, sizeof(*state->patches)))
+    {
+        state->failed = 1;
+        return;
+    }
+    state->patches[state->patchcount].at = state->length;
+    state->patches[state->patchcount].label = label;
+    ++state->patchcount;
+    ecc_jit_int32(state, 0);
+}
+
+/* frame: saved rbx and r12, temporaries, the indices of an autorelease statement, then two slots per loop */
+
+static int32_t ecc_jit_temp(uint32_t depth)
+{
+    return -16 - 16 * (int32_t)(depth + 1);
+}
+
+static int32_t ecc_jit_indicesslot(void)
+{
+    return ecc_jit_temp(ECC_JIT_TEMPS);
+}
+
+static int32_t ecc_jit_loopslot(uint32_t loop)
+{
+    return ecc_jit_indicesslot() - 32 * (int32_t)(loop + 1);
+}
+
+/* operand extents */
+
+/*
+* returns the operand following the expression starting at 'op',
+* or NULL for an operand that consumes a number of operands not known here.
+*/
+static const eccoperand_t* ecc_jit_skip(const eccoperand_t* op)
+{
+    int32_t count;
+    const eccoperand_t* end;
+    const eccoperand_t* jump;
+    eccnativefuncptr_t native;
+    native = ecc_oper_generic(op->native);
+    if(native == ecc_oper_value || native == ecc_oper_valueconstref || native == ecc_oper_text || native == ecc_oper_regexp
+       || native == ecc_oper_function || native == ecc_oper_getthis || native == ecc_oper_createlocalref
+       || native == ecc_oper_getlocalrefornull || native == ecc_oper_getlocalref || native == ecc_oper_getlocal
+       || native == ecc_oper_deletelocal || native == ecc_oper_getlocalslotref || native == ecc_oper_getlocalslot
+       || native == ecc_oper_deletelocalslot || native == ecc_oper_getparentslotref || native == ecc_oper_getparentslot
+       || native == ecc_oper_deleteparentslot)
+    {
+        return op + 1;
+    }
+    else if(native == ecc_oper_setlocal || native == ecc_oper_setlocalslot || native == ecc_oper_setparentslot
+            || native == ecc_oper_getmemberref || native == ecc_oper_getmember || native == ecc_oper_deletemember
+            || native == ecc_oper_exchange || native == ecc_oper_typeof || native == ecc_oper_positive
+            || native == ecc_oper_negative || native == ecc_oper_invert || native == ecc_oper_logicalnot
+            || native == ecc_oper_incrementref || native == ecc_oper_decrementref || native == ecc_oper_postincrementref
+            || native == ecc_oper_postdecrementref)
+    {
+        count = 1;
+    }
+    else if(native == ecc_oper_setmember || native == ecc_oper_getpropertyref || native == ecc_oper_getproperty
+            || native == ecc_oper_deleteproperty || native == ecc_oper_equal || native == ecc_oper_notequal
+            || native == ecc_oper_identical || native == ecc_oper_notidentical || native == ecc_oper_less
+            || native == ecc_oper_lessorequal || native == ecc_oper_more || native == ecc_oper_moreorequal
+            || native == ecc_oper_instanceof || native == ecc_oper_in || native == ecc_oper_add || native == ecc_oper_minus
+            || native == ecc_oper_multiply || native == ecc_oper_divide || native == ecc_oper_modulo
+            || native == ecc_oper_leftshift || native == ecc_oper_rightshift || native == ecc_oper_unsignedrightshift
+            || native == ecc_oper_bitwiseand || native == ecc_oper_bitwisexor || native == ecc_oper_bitwiseor
+            || native == ecc_oper_addassignref || native == ecc_oper_minusassignref || native == ecc_oper_multiplyassignref
+            || native == ecc_oper_divideassignref || native == ecc_oper_moduloassignref || native == ecc_oper_leftshiftassignref
+            || native == ecc_oper_rightshiftassignref || native == ecc_oper_unsignedrightshiftassignref
+            || native == ecc_oper_bitandassignref || native == ecc_oper_bitxorassignref || native == ecc_oper_bitorassignref)
+    {
+        count = 2;
+    }
+    else if(native == ecc_oper_setproperty)
+    {
+        count = 3;
+    }
+    else if(native == ecc_oper_call || native == ecc_oper_tailcall || native == ecc_oper_construct)
+    {
+        count = 1 + op->opvalue.data.integer;
+    }
+    else if(native == ecc_oper_eval || native == ecc_oper_array)
+    {
+        count = op->opvalue.data.integer;
+    }
+    else if(native == ecc_oper_object)
+    {
+        count = 2 * op->opvalue.data.integer;
+    }
+    else if(native == ecc_oper_callmember || native == ecc_oper_callproperty || native == ecc_oper_tailcallmember
+            || native == ecc_oper_tailcallproperty)
+    {
+        /* the next operand only holds the text of the member access */
+        count = (native == ecc_oper_callmember || native == ecc_oper_tailcallmember ? 1 : 2) + op->opvalue.data.integer;
+        ++op;
+    }
+    else if(native == ecc_oper_logicaland || native == ecc_oper_logicalor)
+    {
+        /* the right side is skipped by opvalue operands */
+        if(!(end = ecc_jit_skip(op + 1)) || ecc_jit_skip(end) != end + op->opvalue.data.integer)
+        {
+            return NULL;
+        }
+        return end + op->opvalue.data.integer;
+    }
+    else if(native == ecc_oper_jumpif || native == ecc_oper_jumpifnot)
+    {
+        /* conditional operator: condition, true side and a jump over the false side */
+        if(!(end = ecc_jit_skip(op + 1)) || op->opvalue.data.integer < 1)
+        {
+            return NULL;
+        }
+        jump = end + op->opvalue.data.integer - 1;
+        if(jump->native != ecc_oper_jump || ecc_jit_skip(end) != jump || ecc_jit_skip(jump + 1) != jump + 1 + jump->opvalue.data.integer)
+        {
+            return NULL;
+        }
+        return jump + 1 + jump->opvalue.data.integer;
+    }
+    else
+    {
+        return NULL;
+    }
+    for(end = op + 1; count > 0; --count)
+    {
+        if(!(end = ecc_jit_skip(end)))
+        {
+            return NULL;
+        }
+    }
+    return end;
+}
+
+/* runtime helpers, called from generated code */
+
+static eccvalue_t ecc_jit_statementop(ecccontext_t* context)
+{
+    context->canyield = 1;
+    return context->ops->native(context);
+}
+
+static int ecc_jit_iscomparison(eccnativefuncptr_t native)
+{
+    return native == ecc_oper_less || native == ecc_oper_lessorequal || native == ecc_oper_more || native == ecc_oper_moreorequal
+           || native == ecc_oper_equal || native == ecc_oper_notequal || native == ecc_oper_identical || native == ecc_oper_notidentical;
+}
+
+/* an int32 operator, rewritten by type feedback (superinstructions are not) */
+static int ecc_jit_isint32(const eccoperand_t* op)
+{
+    return ecc_oper_generic(op->native) != ecc_oper_unfused(op->native);
+}
+
+/* the operation of 'op' once its operands are evaluated, when they are not both numbers */
+static eccvalue_t ecc_jit_binary(ecccontext_t* context, const eccoperand_t* op, eccvalue_t a, eccvalue_t b)
+{
+    const eccoperand_t* opb;
+    eccnativefuncptr_t native;
+    native = ecc_oper_generic(op->native);
+    if(ecc_jit_isint32(op))
+    {
+        ecc_oper_deoptimize(op);
+    }
+    opb = ecc_jit_skip(op + 1);
+    context->ops = ecc_jit_skip(opb) - 1;
+    if(native != ecc_oper_add && !ecc_jit_iscomparison(native))
+    {
+        return ecc_oper_operatevalues(context, native, a, b);
+    }
+    ecc_context_settexts(context, &op[1].text, &opb->text);
+    if(native == ecc_oper_add)
+    {
+        return ecc_value_add(context, a, b);
+    }
+    else if(native == ecc_oper_less)
+    {
+        return ecc_value_less(context, a, b);
+    }
+    else if(native == ecc_oper_lessorequal)
+    {
+        return ecc_value_lessorequal(context, a, b);
+    }
+    else if(native == ecc_oper_more)
+    {
+        return ecc_value_more(context, a, b);
+    }
+    else if(native == ecc_oper_moreorequal)
+    {
+        return ecc_value_moreorequal(context, a, b);
+    }
+    else if(native == ecc_oper_equal)
+    {
+        return ecc_value_equals(context, a, b);
+    }
+    else if(native == ecc_oper_notequal)
+    {
+        return ecc_value_truth(!ecc_value_istrue(ecc_value_equals(context, a, b)));
+    }
+    else if(native == ecc_oper_identical)
+    {
+        return ecc_value_same(context, a, b);
+    }
+    return ecc_value_truth(!ecc_value_istrue(ecc_value_same(context, a, b)));
+}
+
+/* setlocalslot and setparentslot once the value is evaluated, when the store is not a plain number one */
+static eccvalue_t ecc_jit_storeslot(ecccontext_t* context, const eccoperand_t* op, eccvalue_t value)
+{
+    int32_t count;
+    eccvalue_t* ref;
+    eccobject_t* object;
+    context->ops = ecc_jit_skip(op + 1) - 1;
+    object = context->execenv;
+    if(ecc_oper_generic(op->native) == ecc_oper_setlocalslot)
+    {
+        ref = &object->hmapmapitems[op->opvalue.data.integer].hmapmapvalue;
+        if(ref->flags & ECC_VALFLAG_READONLY)
+        {
+            return value;
+        }
+    }
+    else
+    {
+        for(count = op->opvalue.data.integer >> 16; count--;)
+        {
+            object = object->prototype;
+        }
+        ref = &object->hmapmapitems[op->opvalue.data.integer & 0xffff].hmapmapvalue;
+        if(ref->flags & ECC_VALFLAG_READONLY)
+        {
+            if(context->isstrictmode)
+            {
+                eccstrbox_t property = *ecc_keyidx_textof(ref->key);
+                ecc_context_settext(context, &op->text);
+                ecc_context_typeerror(context, ecc_strbuf_create("'%.*s' is read-only", property.length, property.bytes));
+            }
+            return value;
+        }
+    }
+    ecc_mempool_writebarrier(object, value);
+    ecc_oper_retain(value);
+    ecc_oper_release(*ref);
+    ecc_oper_replacerefvalue(ref, value);
+    return value;
+}
+
+/* one loop step after the body ran, as mac_stepiteration: 0 to go on, 1 when the loop breaks, 2 to return the value */
+static int ecc_jit_endstep(ecccontext_t* context, uint32_t indices[3])
+{
+    if(context->breaker && --context->breaker)
+    {
+        return --context->breaker ? 2 : 1;
+    }
+    ecc_mempool_collectunreferencedfromindices(indices);
+    if(ecc_mempool_collectpending())
+    {
+        ecc_script_autocollect(context->ecc);
+    }
+    return 0;
+}
+
+#if ECC_JIT_DEBUG
+static void ecc_jit_checkops(ecccontext_t* context, const eccoperand_t* last)
+{
+    if(context->ops != last)
+    {
+        ecc_script_fatal("jit: %s left ops at %p instead of %p", ecc_oper_tochars(last->native), (const void*)context->ops, (const void*)last);
+    }
+}
+#endif
+
+/* expressions */
+
+static const eccoperand_t* ecc_jit_value(eccjitstate_t* state, const eccoperand_t* op, uint32_t depth);
+
+static void ecc_jit_setops(eccjitstate_t* state, const eccoperand_t* op)
+{
+    ecc_jit_moveaddress(state, ECC_JITREG_CX, op);
+    ecc_jit_store(state, ECC_JITREG_BX, offsetof(ecccontext_t, ops), ECC_JITREG_CX);
+}
+
+static void ecc_jit_loadvalue(eccjitstate_t* state, eccjitplace_t place)
+{
+    ecc_jit_load(state, ECC_JITREG_AX, place.reg, place.disp);
+    ecc_jit_load(state, ECC_JITREG_DX, place.reg, place.disp + 8);
+}
+
+static void ecc_jit_storevalue(eccjitstate_t* state, eccjitplace_t place)
+{
+    ecc_jit_store(state, place.reg, place.disp, ECC_JITREG_AX);
+    ecc_jit_store(state, place.reg, place.disp + 8, ECC_JITREG_DX);
+}
+
+static void ecc_jit_loadconst(eccjitstate_t* state, const eccvalue_t* value)
+{
+    eccjitplace_t place = { ECC_JITREG_CX, 0 };
+    ecc_jit_moveaddress(state, ECC_JITREG_CX, value);
+    ecc_jit_loadvalue(state, place);
+}
+
+static eccjitplace_t ecc_jit_frame(int32_t disp)
+{
+    eccjitplace_t place = { ECC_JITREG_BP, disp };
+    return place;
+}
+
+/* operands read in place: constants and slots */
+static int ecc_jit_isplain(const eccoperand_t* op)
+{
+    return op->native == ecc_oper_value || op->native == ecc_oper_getlocalslot || op->native == ecc_oper_getparentslot;
+}
+
+/* the object holding the slots of an environment 'depth' levels up, into 'reg' */
+static void ecc_jit_environment(eccjitstate_t* state, int reg, int32_t depth)
+{
+    ecc_jit_load(state, reg, ECC_JITREG_BX, offsetof(ecccontext_t, execenv));
+    while(depth-- > 0)
+    {
+        ecc_jit_load(state, reg, reg, offsetof(eccobject_t, prototype));
+    }
+    ecc_jit_load(state, reg, reg, offsetof(eccobject_t, hmapmapitems));
+}
+
+static eccjitplace_t ecc_jit_place(eccjitstate_t* state, const eccoperand_t* op, int reg)
+{
+    eccjitplace_t place;
+    place.reg = reg;
+    if(op->native == ecc_oper_value)
+    {
+        ecc_jit_moveaddress(state, reg, &op->opvalue);
+        place.disp = 0;
+    }
+    else if(op->native == ecc_oper_getlocalslot)
+    {
+        ecc_jit_environment(state, reg, 0);
+        place.disp = op->opvalue.data.integer * sizeof(ecchashmap_t);
+    }
+    else
+    {
+        ecc_jit_environment(state, reg, op->opvalue.data.integer >> 16);
+        place.disp = (op->opvalue.data.integer & 0xffff) * sizeof(ecchashmap_t);
+    }
+    return place;
+}
+
+/* calls op->native through the operand (setops leaves it in rcx), that type feedback may rewrite */
+static void ecc_jit_callnative(eccjitstate_t* state, int tail)
+{
+    ecc_jit_move(state, ECC_JITREG_DI, ECC_JITREG_BX);
+    if(tail)
+    {
+        ecc_jit_leave(state);
+    }
+    ecc_jit_modrm(state, 0, 0, 0xff, tail ? 4 : 2, ECC_JITREG_CX, offsetof(eccoperand_t, native), 1);
+}
+
+static const eccoperand_t* ecc_jit_generic(eccjitstate_t* state, const eccoperand_t* op)
+{
+    const eccoperand_t* end;
+    end = ecc_jit_skip(op);
+    ecc_jit_setops(state, op);
+    ecc_jit_callnative(state, 0);
+#if ECC_JIT_DEBUG
+    if(ecc_oper_generic(op->native) != ecc_oper_jumpif && ecc_oper_generic(op->native) != ecc_oper_jumpifnot)
+    {
+        ecc_jit_store(state, ECC_JITREG_BP, ecc_jit_temp(ECC_JIT_TEMPS - 1), ECC_JITREG_AX);
+        ecc_jit_store(state, ECC_JITREG_BP, ecc_jit_temp(ECC_JIT_TEMPS - 1) + 8, ECC_JITREG_DX);
+        ecc_jit_move(state, ECC_JITREG_DI, ECC_JITREG_BX);
+        ecc_jit_moveaddress(state, ECC_JITREG_SI, end - 1);
+        ecc_jit_call(state, (const void*)ecc_jit_checkops);
+        ecc_jit_load(state, ECC_JITREG_AX, ECC_JITREG_BP, ecc_jit_temp(ECC_JIT_TEMPS - 1));
+        ecc_jit_load(state, ECC_JITREG_DX, ECC_JITREG_BP, ecc_jit_temp(ECC_JIT_TEMPS - 1) + 8);
+    }
+#endif
+    return end;
+}
+
+/*
+* evaluates both operands of a binary operator, and tells where they are.
+* plain operands are read in place when both are plain; otherwise the left one is
+* kept in the frame, so that the right one is free to change it.
+*/
+static const eccoperand_t* ecc_jit_operands(eccjitstate_t* state, const eccoperand_t* op, uint32_t depth, eccjitplace_t* a, eccjitplace_t* b)
+{
+    const eccoperand_t* opa;
+    const eccoperand_t* opb;
+    opa = op + 1;
+    opb = ecc_jit_skip(opa);
+    if(ecc_jit_isplain(opa) && ecc_jit_isplain(opb))
+    {
+        *a = ecc_jit_place(state, opa, ECC_JITREG_SI);
+        *b = ecc_jit_place(state, opb, ECC_JITREG_DI);
+        return opb + 1;
+    }
+    *a = ecc_jit_frame(ecc_jit_temp(depth));
+    ecc_jit_value(state, opa, depth);
+    ecc_jit_storevalue(state, *a);
+    if(ecc_jit_isplain(opb))
+    {
+        *b = ecc_jit_place(state, opb, ECC_JITREG_DI);
+        return opb + 1;
+    }
+    *b = ecc_jit_frame(ecc_jit_temp(depth + 1));
+    opb = ecc_jit_value(state, opb, depth + 1);
+    ecc_jit_storevalue(state, *b);
+    return opb;
+}
+
+static void ecc_jit_callbinary(eccjitstate_t* state, const eccoperand_t* op, eccjitplace_t a, eccjitplace_t b)
+{
+    ecc_jit_load(state, ECC_JITREG_R8, b.reg, b.disp);
+    ecc_jit_load(state, ECC_JITREG_R9, b.reg, b.disp + 8);
+    ecc_jit_load(state, ECC_JITREG_DX, a.reg, a.disp);
+    ecc_jit_load(state, ECC_JITREG_CX, a.reg, a.disp + 8);
+    ecc_jit_move(state, ECC_JITREG_DI, ECC_JITREG_BX);
+    ecc_jit_moveaddress(state, ECC_JITREG_SI, op);
+    ecc_jit_call(state, (const void*)ecc_jit_binary);
+}
+
+/* the number at 'place' as a double in 'xmm', else to 'slow' */
+static void ecc_jit_loadbinary(eccjitstate_t* state, int xmm, eccjitplace_t place, uint32_t slow)
+{
+    uint32_t integer;
+    uint32_t done;
+    integer = ecc_jit_label(state);
+    done = ecc_jit_label(state);
+    ecc_jit_cmpbyte(state, place.reg, place.disp + offsetof(eccvalue_t, type), ECC_VALTYPE_BINARY);
+    ecc_jit_jump(state, ECC_JITCC_NE, integer);
+    ecc_jit_loadsd(state, xmm, place);
+    ecc_jit_jump(state, ECC_JITCC_ALWAYS, done);
+    ecc_jit_bind(state, integer);
+    ecc_jit_cmpbyte(state, place.reg, place.disp + offsetof(eccvalue_t, type), ECC_VALTYPE_INTEGER);
+    ecc_jit_jump(state, ECC_JITCC_NE, slow);
+    /* cvtsi2sd xmm, dword [place] */
+    ecc_jit_modrm(state, 0xf2, 0, 0x0f2a, xmm, place.reg, place.disp, 1);
+    ecc_jit_bind(state, done);
+}
+
+/* the number at 'place' converted as by ecc_value_tointeger in the low half of 'reg', else to 'slow' */
+static void ecc_jit_loadinteger(eccjitstate_t* state, int reg, eccjitplace_t place, uint32_t slow)
+{
+    uint32_t binary;
+    uint32_t done;
+    binary = ecc_jit_label(state);
+    done = ecc_jit_label(state);
+    ecc_jit_cmpbyte(state, place.reg, place.disp + offsetof(eccvalue_t, type), ECC_VALTYPE_INTEGER);
+    ecc_jit_jump(state, ECC_JITCC_NE, binary);
+    ecc_jit_load32(state, reg, place.reg, place.disp);
+    ecc_jit_jump(state, ECC_JITCC_ALWAYS, done);
+    ecc_jit_bind(state, binary);
+    ecc_jit_cmpbyte(state, place.reg, place.disp + offsetof(eccvalue_t, type), ECC_VALTYPE_BINARY);
+    ecc_jit_jump(state, ECC_JITCC_NE, slow);
+    /* cvttsd2si reg, qword [place]: truncated then taken modulo 2^32, unless out of range (NaN and infinities included) */
+    ecc_jit_modrm(state, 0xf2, 1, 0x0f2c, reg, place.reg, place.disp, 1);
+    ecc_jit_moveimm(state, ECC_JITREG_R11, UINT64_C(0x8000000000000000));
+    ecc_jit_modrm(state, 0, 1, 0x39, ECC_JITREG_R11, reg, 0, 0);
+    ecc_jit_jump(state, ECC_JITCC_E, slow);
+    ecc_jit_bind(state, done);
+}
+
+/* the upper half of ecc_value_fromfloat(), type and check */
+static uint64_t ecc_jit_floatupper(void)
+{
+    uint64_t upper;
+    eccvalue_t value;
+    value = ecc_value_fromfloat(0);
+    memcpy(&upper, (const char*)&value + 8, 8);
+    return upper;
+}
+
+/* the upper half of ecc_value_fromint(), type and check; the lower half is the int32 zero-extended */
+static uint64_t ecc_jit_intupper(void)
+{
+    uint64_t upper;
+    eccvalue_t value;
+    value = ecc_value_fromint(0);
+    memcpy(&upper, (const char*)&value + 8, 8);
+    return upper;
+}
+
+static const eccoperand_t* ecc_jit_arithmetic(eccjitstate_t* state, const eccoperand_t* op, uint32_t depth)
+{
+    uint32_t opcode;
+    uint32_t slow;
+    uint32_t convert;
+    uint32_t operate;
+    uint32_t done;
+    uint32_t binary;
+    eccjitplace_t a;
+    eccjitplace_t b;
+    eccnativefuncptr_t native;
+    const eccoperand_t* end;
+    native = ecc_oper_generic(op->native);
+    if(native == ecc_oper_add)
+        opcode = 0x0f58;
+    else if(native == ecc_oper_minus)
+        opcode = 0x0f5c;
+    else if(native == ecc_oper_multiply)
+        opcode = 0x0f59;
+    else
+        opcode = 0x0f5e;
+    end = ecc_jit_operands(state, op, depth, &a, &b);
+    slow = ecc_jit_label(state);
+    convert = ecc_jit_label(state);
+    operate = ecc_jit_label(state);
+    done = ecc_jit_label(state);
+    if(ecc_jit_isint32(op))
+    {
+        /* int32 operator: both integers, and no overflow (nor -0) */
+        binary = ecc_jit_label(state);
+        ecc_jit_cmpbyte(state, a.reg, a.disp + offsetof(eccvalue_t, type), ECC_VALTYPE_INTEGER);
+        ecc_jit_jump(state, ECC_JITCC_NE, binary);
+        ecc_jit_cmpbyte(state, b.reg, b.disp + offsetof(eccvalue_t, type), ECC_VALTYPE_INTEGER);
+        ecc_jit_jump(state, ECC_JITCC_NE, binary);
+        ecc_jit_load32(state, ECC_JITREG_AX, a.reg, a.disp);
+        if(native == ecc_oper_add)
+            ecc_jit_modrm(state, 0, 0, 0x03, ECC_JITREG_AX, b.reg, b.disp, 1);
+        else if(native == ecc_oper_minus)
+            ecc_jit_modrm(state, 0, 0, 0x2b, ECC_JITREG_AX, b.reg, b.disp, 1);
+        else
+            ecc_jit_modrm(state, 0, 0, 0x0faf, ECC_JITREG_AX, b.reg, b.disp, 1);
+        ecc_jit_jump(state, ECC_JITCC_O, convert);
+        if(native == ecc_oper_multiply)
+        {
+            ecc_jit_modrm(state, 0, 0, 0x85, ECC_JITREG_AX, ECC_JITREG_AX, 0, 0);
+            ecc_jit_jump(state, ECC_JITCC_E, convert);
+        }
+        ecc_jit_moveimm(state, ECC_JITREG_DX, ecc_jit_intupper());
+        ecc_jit_jump(state, ECC_JITCC_ALWAYS, done);
+        ecc_jit_bind(state, binary);
+    }
+    /* both binary: the result keeps the rest of the left operand, as the interpreter does */
+    ecc_jit_cmpbyte(state, a.reg, a.disp + offsetof(eccvalue_t, type), ECC_VALTYPE_BINARY);
+    ecc_jit_jump(state, ECC_JITCC_NE, convert);
+    ecc_jit_cmpbyte(state, b.reg, b.disp + offsetof(eccvalue_t, type), ECC_VALTYPE_BINARY);
+    ecc_jit_jump(state, ECC_JITCC_NE, convert);
+    ecc_jit_loadsd(state, 0, a);
+    ecc_jit_loadsd(state, 1, b);
+    ecc_jit_load(state, ECC_JITREG_DX, a.reg, a.disp + 8);
+    ecc_jit_jump(state, ECC_JITCC_ALWAYS, operate);
+    ecc_jit_bind(state, convert);
+    ecc_jit_loadbinary(state, 0, a, slow);
+    ecc_jit_loadbinary(state, 1, b, slow);
+    ecc_jit_moveimm(state, ECC_JITREG_DX, ecc_jit_floatupper());
+    ecc_jit_bind(state, operate);
+    ecc_jit_sse(state, 0xf2, opcode, 0, 1);
+    ecc_jit_movqfromxmm(state, ECC_JITREG_AX, 0);
+    ecc_jit_jump(state, ECC_JITCC_ALWAYS, done);
+    ecc_jit_bind(state, slow);
+    ecc_jit_callbinary(state, op, a, b);
+    ecc_jit_bind(state, done);
+    return end;
+}
+
+static const eccoperand_t* ecc_jit_bitwise(eccjitstate_t* state, const eccoperand_t* op, uint32_t depth)
+{
+    uint32_t slow;
+    uint32_t done;
+    uint32_t binary;
+    eccnativefuncptr_t native;
+    eccjitplace_t a;
+    eccjitplace_t b;
+    const eccoperand_t* end;
+    end = ecc_jit_operands(state, op, depth, &a, &b);
+    native = ecc_oper_generic(op->native);
+    slow = ecc_jit_label(state);
+    done = ecc_jit_label(state);
+    ecc_jit_loadinteger(state, ECC_JITREG_AX, a, slow);
+    ecc_jit_loadinteger(state, ECC_JITREG_CX, b, slow);
+    if(native == ecc_oper_bitwiseand)
+        ecc_jit_modrm(state, 0, 0, 0x21, ECC_JITREG_CX, ECC_JITREG_AX, 0, 0);
+    else if(native == ecc_oper_bitwiseor)
+        ecc_jit_modrm(state, 0, 0, 0x09, ECC_JITREG_CX, ECC_JITREG_AX, 0, 0);
+    else if(native == ecc_oper_bitwisexor)
+        ecc_jit_modrm(state, 0, 0, 0x31, ECC_JITREG_CX, ECC_JITREG_AX, 0, 0);
+    else if(native == ecc_oper_leftshift)
+        ecc_jit_modrm(state, 0, 0, 0xd3, 4, ECC_JITREG_AX, 0, 0);
+    else if(native == ecc_oper_rightshift)
+        ecc_jit_modrm(state, 0, 0, 0xd3, 7, ECC_JITREG_AX, 0, 0);
+    else
+        ecc_jit_modrm(state, 0, 0, 0xd3, 5, ECC_JITREG_AX, 0, 0);
+    if(ecc_jit_isint32(op))
+    {
+        /* int32 operator: the result stays an integer, unless an unsigned shift leaves it above INT32_MAX */
+        binary = ecc_jit_label(state);
+        if(native == ecc_oper_unsignedrightshift)
+        {
+            ecc_jit_modrm(state, 0, 0, 0x85, ECC_JITREG_AX, ECC_JITREG_AX, 0, 0);
+            ecc_jit_jump(state, ECC_JITCC_S, binary);
+        }
+        ecc_jit_moveimm(state, ECC_JITREG_DX, ecc_jit_intupper());
+        ecc_jit_jump(state, ECC_JITCC_ALWAYS, done);
+        ecc_jit_bind(state, binary);
+    }
+    if(native == ecc_oper_unsignedrightshift)
+    {
+        /* mov eax, eax clears the upper half, then cvtsi2sd xmm0, rax */
+        ecc_jit_modrm(state, 0, 0, 0x89, ECC_JITREG_AX, ECC_JITREG_AX, 0, 0);
+        ecc_jit_modrm(state, 0xf2, 1, 0x0f2a, 0, ECC_JITREG_AX, 0, 0);
+    }
+    else
+    {
+        ecc_jit_modrm(state, 0xf2, 0, 0x0f2a, 0, ECC_JITREG_AX, 0, 0);
+    }
+    ecc_jit_movqfromxmm(state, ECC_JITREG_AX, 0);
+    ecc_jit_moveimm(state, ECC_JITREG_DX, ecc_jit_floatupper());
+    ecc_jit_jump(state, ECC_JITCC_ALWAYS, done);
+    ecc_jit_bind(state, slow);
+    ecc_jit_callbinary(state, op, a, b);
+    ecc_jit_bind(state, done);
+    return end;
+}
+
+static int ecc_jit_iscompare(const eccoperand_t* op)
+{
+    return ecc_jit_iscomparison(ecc_oper_generic(op->native));
+}
+
+/* jumps to 'label' when the value in rax:rdx is 'jumpiftrue', as ecc_value_istrue */
+static void ecc_jit_truth(eccjitstate_t* state, int jumpiftrue, uint32_t label)
+{
+    uint32_t done;
+    uint32_t iftrue;
+    uint32_t iffalse;
+    done = ecc_jit_label(state);
+    iftrue = jumpiftrue ? label : done;
+    iffalse = jumpiftrue ? done : label;
+    /* the type byte: mov rcx, rdx; shr rcx, 32 */
+    ecc_jit_move(state, ECC_JITREG_CX, ECC_JITREG_DX);
+    ecc_jit_modrm(state, 0, 1, 0xc1, 5, ECC_JITREG_CX, 0, 0);
+    ecc_jit_byte(state, 32);
+    ecc_jit_modrm(state, 0, 0, 0x80, 7, ECC_JITREG_CX, 0, 0);
+    ecc_jit_byte(state, ECC_VALTYPE_UNDEFINED);
+    ecc_jit_jump(state, ECC_JITCC_LE, iffalse);
+    ecc_jit_modrm(state, 0, 0, 0x80, 7, ECC_JITREG_CX, 0, 0);
+    ecc_jit_byte(state, ECC_VALTYPE_TRUE);
+    ecc_jit_jump(state, ECC_JITCC_GE, iftrue);
+    ecc_jit_move(state, ECC_JITREG_DI, ECC_JITREG_AX);
+    ecc_jit_move(state, ECC_JITREG_SI, ECC_JITREG_DX);
+    ecc_jit_call(state, (const void*)ecc_value_istrue);
+    ecc_jit_modrm(state, 0, 0, 0x85, ECC_JITREG_AX, ECC_JITREG_AX, 0, 0);
+    ecc_jit_jump(state, ECC_JITCC_NE, iftrue);
+    ecc_jit_jump(state, ECC_JITCC_ALWAYS, iffalse);
+    ecc_jit_bind(state, done);
+}
+
+static const eccoperand_t* ecc_jit_compare(eccjitstate_t* state, const eccoperand_t* op, uint32_t depth, int jumpiftrue, uint32_t label)
+{
+    int cc;
+    int equality;
+    uint32_t slow;
+    uint32_t done;
+    eccjitplace_t a;
+    eccjitplace_t b;
+    eccnativefuncptr_t native;
+    const eccoperand_t* end;
+    native = ecc_oper_generic(op->native);
+    end = ecc_jit_operands(state, op, depth, &a, &b);
+    slow = ecc_jit_label(state);
+    done = ecc_jit_label(state);
+    ecc_jit_loadbinary(state, 0, a, slow);
+    ecc_jit_loadbinary(state, 1, b, slow);
+    equality = 0;
+    cc = ECC_JITCC_A;
+    if(native == ecc_oper_less || native == ecc_oper_lessorequal)
+    {
+        /* ucomisd xmm1, xmm0: unordered sets CF, so 'above' comparisons are false for NaN */
+        ecc_jit_sse(state, 0x66, 0x0f2e, 1, 0);
+        cc = native == ecc_oper_less ? ECC_JITCC_A : ECC_JITCC_AE;
+    }
+    else if(native == ecc_oper_more || native == ecc_oper_moreorequal)
+    {
+        ecc_jit_sse(state, 0x66, 0x0f2e, 0, 1);
+        cc = native == ecc_oper_more ? ECC_JITCC_A : ECC_JITCC_AE;
+    }
+    else
+    {
+        ecc_jit_sse(state, 0x66, 0x0f2e, 0, 1);
+        equality = (native == ecc_oper_equal || native == ecc_oper_identical) ? 1 : -1;
+    }
+    if(!equality)
+    {
+        ecc_jit_jump(state, jumpiftrue ? cc : cc ^ 1, label);
+    }
+    else if((equality > 0) == !!jumpiftrue)
+    {
+        /* jump if equal: ZF set and PF clear */
+        ecc_jit_jump(state, ECC_JITCC_P, done);
+        ecc_jit_jump(state, ECC_JITCC_E, label);
+    }
+    else
+    {
+        ecc_jit_jump(state, ECC_JITCC_P, label);
+        ecc_jit_jump(state, ECC_JITCC_NE, label);
+    }
+    ecc_jit_jump(state, ECC_JITCC_ALWAYS, done);
+    ecc_jit_bind(state, slow);
+    ecc_jit_callbinary(state, op, a, b);
+    ecc_jit_truth(state, jumpiftrue, label);
+    ecc_jit_bind(state, done);
+    return end;
+}
+
+/* jumps to 'label' when the expression at 'op' is 'jumpiftrue', else falls through */
+static const eccoperand_t* ecc_jit_condition(eccjitstate_t* state, const eccoperand_t* op, uint32_t depth, int jumpiftrue, uint32_t label)
+{
+    const eccoperand_t* end;
+    if(ecc_jit_iscompare(op) && depth + 1 < ECC_JIT_TEMPS - 1)
+    {
+        return ecc_jit_compare(state, op, depth, jumpiftrue, label);
+    }
+    else if(op->native == ecc_oper_logicalnot)
+    {
+        return ecc_jit_condition(state, op + 1, depth, !jumpiftrue, label);
+    }
+    end = ecc_jit_value(state, op, depth);
+    ecc_jit_truth(state, jumpiftrue, label);
+    return end;
+}
+
+static const eccoperand_t* ecc_jit_setslot(eccjitstate_t* state, const eccoperand_t* op, uint32_t depth)
+{
+    uint32_t slow;
+    uint32_t done;
+    eccjitplace_t ref;
+    eccjitplace_t value;
+    const eccoperand_t* end;
+    end = ecc_jit_value(state, op + 1, depth);
+    value = ecc_jit_frame(ecc_jit_temp(depth));
+    ecc_jit_storevalue(state, value);
+    slow = ecc_jit_label(state);
+    done = ecc_jit_label(state);
+    if(ecc_oper_generic(op->native) == ecc_oper_setlocalslot)
+    {
+        ecc_jit_environment(state, ECC_JITREG_SI, 0);
+        ref.disp = op->opvalue.data.integer * sizeof(ecchashmap_t);
+    }
+    else
+    {
+        ecc_jit_environment(state, ECC_JITREG_SI, op->opvalue.data.integer >> 16);
+        ref.disp = (op->opvalue.data.integer & 0xffff) * sizeof(ecchashmap_t);
+    }
+    ref.reg = ECC_JITREG_SI;
+    /* plain stores only: writable slot, no barrier for the new value, nothing to release in the old one */
+    ecc_jit_testbyte(state, ref.reg, ref.disp + offsetof(eccvalue_t, flags), ECC_VALFLAG_READONLY);
+    ecc_jit_jump(state, ECC_JITCC_NE, slow);
+    ecc_jit_testbyte(state, value.reg, value.disp + offsetof(eccvalue_t, type), ECC_VALMASK_OBJECT | ECC_VALMASK_STRING);
+    ecc_jit_jump(state, ECC_JITCC_NE, slow);
+    ecc_jit_cmpbyte(state, ref.reg, ref.disp + offsetof(eccvalue_t, type), ECC_VALTYPE_CHARS);
+    ecc_jit_jump(state, ECC_JITCC_E, slow);
+    ecc_jit_cmpbyte(state, ref.reg, ref.disp + offsetof(eccvalue_t, type), ECC_VALTYPE_OBJECT);
+    ecc_jit_jump(state, ECC_JITCC_GE, slow);
+    /* ecc_oper_replacerefvalue: data and type */
+    ecc_jit_load(state, ECC_JITREG_AX, value.reg, value.disp);
+    ecc_jit_store(state, ref.reg, ref.disp, ECC_JITREG_AX);
+    ecc_jit_loadbyte(state, ECC_JITREG_CX, value.reg, value.disp + offsetof(eccvalue_t, type));
+    ecc_jit_storebyte(state, ref.reg, ref.disp + offsetof(eccvalue_t, type), ECC_JITREG_CX);
+    ecc_jit_load(state, ECC_JITREG_DX, value.reg, value.disp + 8);
+    ecc_jit_jump(state, ECC_JITCC_ALWAYS, done);
+    ecc_jit_bind(state, slow);
+    ecc_jit_load(state, ECC_JITREG_DX, value.reg, value.disp);
+    ecc_jit_load(state, ECC_JITREG_CX, value.reg, value.disp + 8);
+    ecc_jit_move(state, ECC_JITREG_DI, ECC_JITREG_BX);
+    ecc_jit_moveaddress(state, ECC_JITREG_SI, op);
+    ecc_jit_call(state, (const void*)ecc_jit_storeslot);
+    ecc_jit_bind(state, done);
+    return end;
+}
+
+/* evaluates the expression at 'op' into rax:rdx, using the frame temporaries from 'depth' on */
+static const eccoperand_t* ecc_jit_value(eccjitstate_t* state, const eccoperand_t* op, uint32_t depth)
+{
+    uint32_t iftrue;
+    uint32_t done;
+    eccnativefuncptr_t native;
+    const eccoperand_t* end;
+    native = ecc_oper_generic(op->native);
+    if(ecc_jit_isplain(op))
+    {
+        ecc_jit_loadvalue(state, ecc_jit_place(state, op, ECC_JITREG_SI));
+        return op + 1;
+    }
+    else if(depth + 1 >= ECC_JIT_TEMPS - 1)
+    {
+        return ecc_jit_generic(state, op);
+    }
+    else if(native == ecc_oper_add || native == ecc_oper_minus || native == ecc_oper_multiply || native == ecc_oper_divide)
+    {
+        return ecc_jit_arithmetic(state, op, depth);
+    }
+    else if(native == ecc_oper_bitwiseand || native == ecc_oper_bitwiseor || native == ecc_oper_bitwisexor
+            || native == ecc_oper_leftshift || native == ecc_oper_rightshift || native == ecc_oper_unsignedrightshift)
+    {
+        return ecc_jit_bitwise(state, op, depth);
+    }
+    else if(ecc_jit_iscompare(op))
+    {
+        iftrue = ecc_jit_label(state);
+        done = ecc_jit_label(state);
+        end = ecc_jit_compare(state, op, depth, 1, iftrue);
+        ecc_jit_loadconst(state, &ECCValConstFalse);
+        ecc_jit_jump(state, ECC_JITCC_ALWAYS, done);
+        ecc_jit_bind(state, iftrue);
+        ecc_jit_loadconst(state, &ECCValConstTrue);
+        ecc_jit_bind(state, done);
+        return end;
+    }
+    else if(native == ecc_oper_setlocalslot || native == ecc_oper_setparentslot)
+    {
+        return ecc_jit_setslot(state, op, depth);
+    }
+    return ecc_jit_generic(state, op);
+}
+
+/* statements */
+
+static uint32_t ecc_jit_chainnew(eccjitstate_t* state, uint32_t end)
+{
+    if(!ecc_jit_grow((void**)&state->chainends, &state->chaincapacity, state->chaincount, sizeof(*state->chainends)))
+    {
+        state->failed = 1;
+        return 0;
+    }
+    state->chainends[state->chaincount] = end;
+    return state->chaincount++;
+}
+
+static uint32_t ecc_jit_stmt(eccjitstate_t* state, const eccoperand_t* op, uint32_t chain)
+{
+    uint32_t index;
+    for(index = 0; index < state->stmtcount; ++index)
+    {
+        if(state->stmts[index].op == op && state->stmts[index].chain == chain)
+        {
+            return index;
+        }
+    }
+    if(!ecc_jit_grow((void**)&state->stmts, &state->stmtcapacity, state->stmtcount, sizeof(*state->stmts)))
+    {
+        state->failed = 1;
+        return 0;
+    }
+    state->stmts[index].op = op;
+    state->stmts[index].chain = chain;
+    state->stmts[index].label = ecc_jit_label(state);
+    state->stmts[index].emitted = 0;
+    ++state->stmtcount;
+    return index;
+}
+
+static uint32_t ecc_jit_stmtlabel(eccjitstate_t* state, const eccoperand_t* op, uint32_t chain)
+{
+    uint32_t index;
+    index = ecc_jit_stmt(state, op, chain);
+    return state->failed ? 0 : state->stmts[index].label;
+}
+
+/* the value in rax:rdx is the result of the chain */
+static void ecc_jit_return(eccjitstate_t* state, uint32_t chain)
+{
+    if(chain)
+    {
+        ecc_jit_jump(state, ECC_JITCC_ALWAYS, state->chainends[chain]);
+        return;
+    }
+    ecc_jit_leave(state);
+    ecc_jit_byte(state, 0xc3);
+}
+
+/* the rest of the chain runs in ecc_oper_dispatch, from context->ops */
+static void ecc_jit_resume(eccjitstate_t* state, uint32_t chain)
+{
+    ecc_jit_move(state, ECC_JITREG_DI, ECC_JITREG_BX);
+    if(chain)
+    {
+        ecc_jit_call(state, (const void*)ecc_oper_dispatch);
+        ecc_jit_return(state, chain);
+        return;
+    }
+    ecc_jit_leave(state);
+    ecc_jit_moveaddress(state, ECC_JITREG_R11, (const void*)ecc_oper_dispatch);
+    ecc_jit_modrm(state, 0, 0, 0xff, 4, ECC_JITREG_R11, 0, 0);
+}
+
+static void ecc_jit_exit(eccjitstate_t* state, const eccoperand_t* op, uint32_t chain)
+{
+    if(!chain && op == state->entry)
+    {
+        /* nothing to compile */
+        state->failed = 1;
+    }
+    ecc_jit_setops(state, op);
+    ecc_jit_resume(state, chain);
+}
+
+/* the interpreter goes on after context->ops; compiled code if that is 'next' */
+static void ecc_jit_continue(eccjitstate_t* state, const eccoperand_t* next, uint32_t chain)
+{
+    ecc_jit_load(state, ECC_JITREG_CX, ECC_JITREG_BX, offsetof(ecccontext_t, ops));
+    ecc_jit_modrm(state, 0, 1, 0x81, 0, ECC_JITREG_CX, 0, 0);
+    ecc_jit_int32(state, sizeof(eccoperand_t));
+    ecc_jit_store(state, ECC_JITREG_BX, offsetof(ecccontext_t, ops), ECC_JITREG_CX);
+    if(next)
+    {
+        ecc_jit_moveaddress(state, ECC_JITREG_R11, next);
+        ecc_jit_modrm(state, 0, 1, 0x39, ECC_JITREG_R11, ECC_JITREG_CX, 0, 0);
+        ecc_jit_jump(state, ECC_JITCC_E, ecc_jit_stmtlabel(state, next, chain));
+    }
+    ecc_jit_resume(state, chain);
+}
+
+static void ecc_jit_chain(eccjitstate_t* state, const eccoperand_t* op, uint32_t chain);
+
+/*
+* 'iterate' with its condition and body, when the condition comes right after
+* the jump over the loop, or after the step expression (see ecc_oplist_createloop)
+*/
+static int ecc_jit_iterate(eccjitstate_t* state, const eccoperand_t* op, uint32_t chain)
+{
+    int32_t slot;
+    uint32_t body;
+    uint32_t top;
+    uint32_t endstep;
+    uint32_t step;
+    uint32_t done;
+    const eccoperand_t* condition;
+    const eccoperand_t* start;
+    condition = op + 2 + op->opvalue.data.integer;
+    if(op->opvalue.data.integer && (op[2].native != ecc_oper_discard || ecc_jit_skip(op + 3) != condition))
+    {
+        return 0;
+    }
+    if(!(start = ecc_jit_skip(condition)))
+    {
+        return 0;
+    }
+    slot = ecc_jit_loopslot(state->loops++);
+    top = ecc_jit_label(state);
+    endstep = ecc_jit_label(state);
+    step = ecc_jit_label(state);
+    done = ecc_jit_label(state);
+    body = ecc_jit_chainnew(state, endstep);
+    ecc_jit_bind(state, top);
+    ecc_jit_condition(state, condition, 0, 0, done);
+    ecc_jit_lea(state, ECC_JITREG_DI, ECC_JITREG_BP, slot + 16);
+    ecc_jit_call(state, (const void*)ecc_mempool_getindices);
+    ecc_jit_chain(state, start, body);
+    ecc_jit_bind(state, endstep);
+    ecc_jit_storevalue(state, ecc_jit_frame(slot));
+    ecc_jit_move(state, ECC_JITREG_DI, ECC_JITREG_BX);
+    ecc_jit_lea(state, ECC_JITREG_SI, ECC_JITREG_BP, slot + 16);
+    ecc_jit_call(state, (const void*)ecc_jit_endstep);
+    ecc_jit_modrm(state, 0, 0, 0x85, ECC_JITREG_AX, ECC_JITREG_AX, 0, 0);
+    ecc_jit_jump(state, ECC_JITCC_E, step);
+    ecc_jit_modrm(state, 0, 0, 0x83, 7, ECC_JITREG_AX, 0, 0);
+    ecc_jit_byte(state, 1);
+    ecc_jit_jump(state, ECC_JITCC_E, done);
+    ecc_jit_loadvalue(state, ecc_jit_frame(slot));
+    ecc_jit_return(state, chain);
+    ecc_jit_bind(state, step);
+    if(op->opvalue.data.integer)
+    {
+        ecc_jit_value(state, op + 3, 0);
+    }
+    ecc_jit_jump(state, ECC_JITCC_ALWAYS, top);
+    ecc_jit_bind(state, done);
+    return 1;
+}
+
+/* emits the statement at 'op', as ecc_oper_dispatch runs it; returns the statement that follows, if any */
+static const eccoperand_t* ecc_jit_statement(eccjitstate_t* state, const eccoperand_t* op, uint32_t chain)
+{
+    int32_t count;
+    uint32_t label;
+    uint32_t skip;
+    const eccoperand_t* end;
+    const eccoperand_t* next;
+    if(!state->budget)
+    {
+        ecc_jit_exit(state, op, chain);
+        return NULL;
+    }
+    --state->budget;
+    end = NULL;
+    switch(op->opcode)
+    {
+        case ECC_OPCODE_NATIVE:
+        case ECC_OPCODE_REPOPULATE:
+            {
+                ecc_jit_setops(state, op);
+                ecc_jit_callnative(state, !chain);
+                if(chain)
+                {
+                    ecc_jit_return(state, chain);
+                }
+                return NULL;
+            }
+        case ECC_OPCODE_NOOP:
+            {
+                ecc_jit_setops(state, op);
+                ecc_jit_loadconst(state, &ECCValConstUndefined);
+                ecc_jit_return(state, chain);
+                return NULL;
+            }
+        case ECC_OPCODE_NEXT:
+            {
+                return op + 1;
+            }
+        case ECC_OPCODE_NEXTIF:
+            {
+                if(!(end = ecc_jit_skip(op + 1)))
+                {
+                    break;
+                }
+                label = ecc_jit_label(state);
+                skip = ecc_jit_label(state);
+                ecc_jit_condition(state, op + 1, 0, 0, label);
+                ecc_jit_jump(state, ECC_JITCC_ALWAYS, skip);
+                ecc_jit_bind(state, label);
+                ecc_jit_setops(state, end - 1);
+                ecc_jit_loadconst(state, &op->opvalue);
+                ecc_jit_return(state, chain);
+                ecc_jit_bind(state, skip);
+                return end;
+            }
+        case ECC_OPCODE_EXPRESSION:
+        case ECC_OPCODE_AUTORELEASEEXPRESSION:
+        case ECC_OPCODE_DISCARD:
+        case ECC_OPCODE_AUTORELEASEDISCARD:
+            {
+                if(!(end = ecc_jit_skip(op + 1)))
+                {
+                    break;
+                }
+                if(op->opcode == ECC_OPCODE_AUTORELEASEEXPRESSION || op->opcode == ECC_OPCODE_AUTORELEASEDISCARD)
+                {
+                    ecc_jit_lea(state, ECC_JITREG_DI, ECC_JITREG_BP, ecc_jit_indicesslot());
+                    ecc_jit_call(state, (const void*)ecc_mempool_getindices);
+                }
+                if(op->opcode == ECC_OPCODE_EXPRESSION || op->opcode == ECC_OPCODE_AUTORELEASEEXPRESSION)
+                {
+                    ecc_jit_load(state, ECC_JITREG_AX, ECC_JITREG_BX, offsetof(ecccontext_t, ecc));
+                    ecc_jit_load(state, ECC_JITREG_DI, ECC_JITREG_AX, offsetof(eccstate_t, result));
+                    ecc_jit_load(state, ECC_JITREG_SI, ECC_JITREG_AX, offsetof(eccstate_t, result) + 8);
+                    ecc_jit_call(state, (const void*)ecc_oper_release);
+                    ecc_jit_value(state, op + 1, 0);
+                    ecc_jit_move(state, ECC_JITREG_DI, ECC_JITREG_AX);
+                    ecc_jit_move(state, ECC_JITREG_SI, ECC_JITREG_DX);
+                    ecc_jit_call(state, (const void*)ecc_oper_retain);
+                    ecc_jit_load(state, ECC_JITREG_CX, ECC_JITREG_BX, offsetof(ecccontext_t, ecc));
+                    ecc_jit_store(state, ECC_JITREG_CX, offsetof(eccstate_t, result), ECC_JITREG_AX);
+                    ecc_jit_store(state, ECC_JITREG_CX, offsetof(eccstate_t, result) + 8, ECC_JITREG_DX);
+                }
+                else
+                {
+                    ecc_jit_value(state, op + 1, 0);
+                }
+                if(op->opcode == ECC_OPCODE_AUTORELEASEEXPRESSION || op->opcode == ECC_OPCODE_AUTORELEASEDISCARD)
+                {
+                    ecc_jit_lea(state, ECC_JITREG_DI, ECC_JITREG_BP, ecc_jit_indicesslot());
+                    ecc_jit_call(state, (const void*)ecc_mempool_collectunreferencedfromindices);
+                }
+                return end;
+            }
+        case ECC_OPCODE_DISCARDN:
+            {
+                count = op->opvalue.data.integer;
+                if(count < 1 || count > 16)
+                {
+                    break;
+                }
+                for(end = op + 1; end && count--;)
+                {
+                    end = ecc_jit_skip(end);
+                }
+                if(!end)
+                {
+                    break;
+                }
+                for(next = op + 1; next != end;)
+                {
+                    next = ecc_jit_value(state, next, 0);
+                }
+                return end;
+            }
+        case ECC_OPCODE_JUMP:
+            {
+                ecc_jit_jump(state, ECC_JITCC_ALWAYS, ecc_jit_stmtlabel(state, op + op->opvalue.data.integer + 1, chain));
+                return NULL;
+            }
+        case ECC_OPCODE_JUMPIF:
+        case ECC_OPCODE_JUMPIFNOT:
+        case ECC_OPCODE_JUMPIFNOTCOMPARE:
+            {
+                if(!(end = ecc_jit_skip(op + 1)))
+                {
+                    break;
+                }
+                label = ecc_jit_stmtlabel(state, end + op->opvalue.data.integer, chain);
+                ecc_jit_condition(state, op + 1, 0, op->opcode == ECC_OPCODE_JUMPIF, label);
+                return end;
+            }
+        case ECC_OPCODE_RESULT:
+            {
+                if(op[1].opcode == ECC_OPCODE_REPOPULATE)
+                {
+                    /* self tail call: the arguments are rebound, and the body starts over */
+                    ecc_jit_setops(state, op + 1);
+                    ecc_jit_move(state, ECC_JITREG_DI, ECC_JITREG_BX);
+                    ecc_jit_call(state, (const void*)ecc_oper_repopulateframe);
+                    ecc_jit_continue(state, chain ? NULL : state->entry, chain);
+                    return NULL;
+                }
+                if(!(end = ecc_jit_skip(op + 1)))
+                {
+                    break;
+                }
+                ecc_jit_value(state, op + 1, 0);
+                ecc_jit_storeimm32(state, ECC_JITREG_BX, offsetof(ecccontext_t, breaker), -1);
+                ecc_jit_setops(state, end - 1);
+                ecc_jit_return(state, chain);
+                return NULL;
+            }
+        case ECC_OPCODE_RESULTVOID:
+        case ECC_OPCODE_BREAKER:
+            {
+                ecc_jit_storeimm32(state, ECC_JITREG_BX, offsetof(ecccontext_t, breaker), op->opcode == ECC_OPCODE_BREAKER ? op->opvalue.data.integer : -1);
+                ecc_jit_setops(state, op);
+                ecc_jit_loadconst(state, &ECCValConstUndefined);
+                ecc_jit_return(state, chain);
+                return NULL;
+            }
+        case ECC_OPCODE_STATEMENT:
+            {
+                if(op->native == ecc_oper_iterate && ecc_jit_iterate(state, op, chain))
+                {
+                    return op + 1;
+                }
+                label = ecc_jit_label(state);
+                ecc_jit_setops(state, op);
+                ecc_jit_move(state, ECC_JITREG_DI, ECC_JITREG_BX);
+                ecc_jit_call(state, (const void*)ecc_jit_statementop);
+                ecc_jit_load32(state, ECC_JITREG_CX, ECC_JITREG_BX, offsetof(ecccontext_t, breaker));
+                ecc_jit_modrm(state, 0, 0, 0x85, ECC_JITREG_CX, ECC_JITREG_CX, 0, 0);
+                ecc_jit_jump(state, ECC_JITCC_E, label);
+                ecc_jit_return(state, chain);
+                ecc_jit_bind(state, label);
+                /* where the loops leave context->ops */
+                if(op->native == ecc_oper_iterate)
+                {
+                    next = op + 1;
+                }
+                else if(op->native == ecc_oper_iteratelessref || op->native == ecc_oper_iteratelessorequalref
+                        || op->native == ecc_oper_iteratemoreref || op->native == ecc_oper_iteratemoreorequalref)
+                {
+                    next = op + op->opvalue.data.integer + 1;
+                }
+                else
+                {
+                    next = NULL;
+                }
+                ecc_jit_continue(state, next, chain);
+                return NULL;
+            }
+        default:
+            break;
+    }
+    ecc_jit_exit(state, op, chain);
+    return NULL;
+}
+
+static void ecc_jit_chain(eccjitstate_t* state, const eccoperand_t* op, uint32_t chain)
+{
+    uint32_t index;
+    while(op && !state->failed)
+    {
+        index = ecc_jit_stmt(state, op, chain);
+        if(state->failed)
+        {
+            return;
+        }
+        if(state->stmts[index].emitted)
+        {
+            ecc_jit_jump(state, ECC_JITCC_ALWAYS, state->stmts[index].label);
+            return;
+        }
+        state->stmts[index].emitted = 1;
+        ecc_jit_bind(state, state->stmts[index].label);
+        op = ecc_jit_statement(state, op, chain);
+    }
+}
+
+static void* ecc_jit_install(const uint8_t* code, uint32_t length)
+{
+    size_t page;
+    size_t size;
+    uint8_t* memory;
+    eccjitregion_t* region;
+    page = (size_t)sysconf(_SC_PAGESIZE);
+    size = ECC_JIT_REGIONHEADER + length;
+    size = (size + page - 1) / page * page;
+    region = (eccjitregion_t*)malloc(sizeof(*region));
+    if(region == NULL)
+    {
+        return NULL;
+    }
+    memory = (uint8_t*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == (uint8_t*)MAP_FAILED)
+    {
+        free(region);
+        return NULL;
+    }
+    memcpy(memory, &region, sizeof(region));
+    memcpy(memory + ECC_JIT_REGIONHEADER, code, length);
+    if(mprotect(memory, size, PROT_READ | PROT_EXEC))
+    {
+        munmap(memory, size);
+        free(region);
+        return NULL;
+    }
+    region->memory = memory;
+    region->size = size;
+    region->previous = NULL;
+    region->next = g_jitregions;
+    if(g_jitregions)
+    {
+        g_jitregions->previous = region;
+    }
+    g_jitregions = region;
+    return memory + ECC_JIT_REGIONHEADER;
+}
+
+/*
+* compiles the statements from 'entry' on, and sets entry->jitcode.
+* returns 0 when there is nothing worth compiling there.
+*/
+int ecc_jit_compile(eccoperand_t* entry)
+{
+    uint32_t index;
+    int32_t frame;
+    int32_t offset;
+    void* code;
+    eccjitstate_t state;
+    memset(&state, 0, sizeof(state));
+    state.entry = entry;
+    state.budget = ECC_JIT_BUDGET;
+    ecc_jit_chainnew(&state, 0);
+    /* push rbp; mov rbp, rsp; push rbx; push r12; sub rsp, frame; mov rbx, rdi */
+    ecc_jit_byte(&state, 0x55);
+    ecc_jit_move(&state, ECC_JITREG_BP, ECC_JITREG_SP);
+    ecc_jit_byte(&state, 0x53);
+    ecc_jit_byte(&state, 0x41);
+    ecc_jit_byte(&state, 0x54);
+    ecc_jit_modrm(&state, 0, 1, 0x81, 5, ECC_JITREG_SP, 0, 0);
+    state.framepatch = state.length;
+    ecc_jit_int32(&state, 0);
+    ecc_jit_move(&state, ECC_JITREG_BX, ECC_JITREG_DI);
+    ecc_jit_chain(&state, entry, 0);
+    for(index = 0; index < state.stmtcount && !state.failed; ++index)
+    {
+        if(!state.stmts[index].emitted)
+        {
+            ecc_jit_chain(&state, state.stmts[index].op, state.stmts[index].chain);
+        }
+    }
+    code = NULL;
+    if(!state.failed)
+    {
+        frame = 16 * (ECC_JIT_TEMPS + 1) + 32 * state.loops;
+        memcpy(state.code + state.framepatch, &frame, 4);
+        for(index = 0; index < state.patchcount; ++index)
+        {
+            offset = state.labels[state.patches[index].label] - (int32_t)(state.patches[index].at + 4);
+            memcpy(state.code + state.patches[index].at, &offset, 4);
+        }
+        code = ecc_jit_install(state.code, state.length);
+    }
+    free(state.code);
+    free(state.labels);
+    free(state.patches);
+    free(state.stmts);
+    free(state.chainends);
+    if(!code)
+    {
+        return 0;
+    }
+    entry->jitcode = (eccnativefuncptr_t)code;
+    return 1;
+}
+
+/* unmaps code from ecc_jit_compile, when its operands are destroyed */
+void ecc_jit_release(eccnativefuncptr_t code)
+{
+    eccjitregion_t* region;
+    memcpy(&region, (uint8_t*)(uintptr_t)code - ECC_JIT_REGIONHEADER, sizeof(region));
+    if(region->previous)
+    {
+        region->previous->next = region->next;
+    }
+    else
+    {
+        g_jitregions = region->next;
+    }
+    if(region->next)
+    {
+        region->next->previous = region->previous;
+    }
+    munmap(region->memory, region->size);
+    free(region);
+}
+
+void ecc_jit_teardown(void)
+{
+    eccjitregion_t* region;
+    while((region = g_jitregions))
+    {
+        g_jitregions = region->next;
+        munmap(region->memory, region->size);
+        free(region);
+    }
+}
+
+#endif
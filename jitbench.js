@@ -0,0 +1,48 @@
+/*
+ * baseline compiler benchmark: numeric loops, bitwise mixing and small function calls,
+ * compiled once hot (see jit.c). compare against run --no-jit.
+ * usage: run [--jit | --no-jit] jitbench.js [size] [rounds]
+ */
+var size = +(arguments[0] || 300);
+var rounds = +(arguments[1] || 200000);
+
+function mandel(size)
+{
+    var x, y, i, cr, ci, zr, zi, t, inside = 0;
+    for (y = 0; y < size; ++y)
+        for (x = 0; x < size; ++x)
+        {
+            cr = 2 * x / size - 1.5;
+            ci = 2 * y / size - 1;
+            zr = 0;
+            zi = 0;
+            for (i = 0; i < 50; ++i)
+            {
+                t = zr * zr - zi * zi + cr;
+                zi = 2 * zr * zi + ci;
+                zr = t;
+                if (zr * zr + zi * zi > 4)
+                    break;
+            }
+            if (i == 50)
+                ++inside;
+        }
+    return inside;
+}
+
+function mix(h, k)
+{
+    h = (h ^ k) * 31 & 0xffffff;
+    return (h << 5 | h >>> 19) ^ (k >> 3);
+}
+
+var start = (new Date).getTime();
+var inside = mandel(size);
+var mandelled = (new Date).getTime();
+var h = 17, r = 0;
+while (r < rounds)
+{
+    h = mix(h, r);
+    r = r + 1;
+}
+println("mandel " + inside + " in " + (mandelled - start) + " ms, mix " + h + " in " + ((new Date).getTime() - mandelled) + " ms");
@@ -0,0 +1,27 @@
+/*
+ * wide key benchmark: parses JSON payloads whose objects use generated ids
+ * as property names, pushing the number of distinct keys well past 65535,
+ * then reads every key back to check none of them collide.
+ * usage: run jsonkeybench.js [keys per round] [rounds]
+ */
+var perround = +(arguments[0] || 100000);
+var rounds = +(arguments[1] || 5);
+var total = 0;
+var start = (new Date).getTime();
+for (var r = 0; r < rounds; ++r)
+{
+    var parts = [];
+    for (var i = 0; i < perround; ++i)
+        parts[i] = '"id' + r + '_' + i + '":' + i;
+
+    var object = JSON.parse('{' + parts.join(',') + '}');
+    var sum = 0;
+    for (var i = 0; i < perround; ++i)
+        sum += object['id' + r + '_' + i];
+
+    if (sum != perround * (perround - 1) / 2)
+        throw Error('round ' + r + ': keys collide, sum ' + sum);
+
+    total += perround;
+    println(total + " keys: " + ((new Date).getTime() - start) + " ms");
+}
@@ -9,14 +9,46 @@
 #include "ecc.h"
 
 
-static eccstrbox_t* g_storedkeylist = NULL;
+/* key texts live in fixed chunks so that pointers from ecc_keyidx_textof stay valid */
+#define ECC_KEYIDX_CHUNKBITS 10
+#define ECC_KEYIDX_CHUNKSIZE (1 << ECC_KEYIDX_CHUNKBITS)
+
+enum eccstoredkeyflags_t
+{
+    /* made by a runtime lookup and referenced by nothing that outlives the heap: may be reclaimed */
+    ECC_STOREDKEYFLAG_TRANSIENT = (1 << 0),
+    /* text was copied into a malloc'd buffer owned by the key */
+    ECC_STOREDKEYFLAG_OWNSTEXT = (1 << 1),
+    ECC_STOREDKEYFLAG_MARK = (1 << 2),
+    /* number is on the free list */
+    ECC_STOREDKEYFLAG_FREE = (1 << 3),
+};
+
+static eccstrbox_t** g_storedkeychunks = NULL;
+static uint32_t g_storedkeychunkcount = 0;
+/* chunk indices ordered by address, to find the key a text pointer belongs to */
+static uint32_t* g_storedkeychunkorder = NULL;
 static uint32_t g_storedkeycount = 0;
 static uint32_t g_storedkeycapacity = 0;
 
-static char** g_storedcharslist = NULL;
-static uint32_t g_storedcharscount = 0;
+/* hash and flags of each stored key, by number - 1 */
+static uint32_t* g_storedkeyhashes = NULL;
+static uint8_t* g_storedkeyflags = NULL;
+
+/* reclaimed numbers, handed out again before new ones */
+static uint32_t* g_freekeys = NULL;
+static uint32_t g_freekeycount = 0;
+
+static uint32_t g_livekeycount = 0;
+static uint32_t g_createdkeycount = 0;
+
+/* open addressing index over the stored keys; holds key numbers, 0 = empty */
+static uint32_t* g_keytable = NULL;
+static uint32_t g_keytablemask = 0;
+
+#define ecc_keyidx_box(number) (&g_storedkeychunks[((number) - 1) >> ECC_KEYIDX_CHUNKBITS][((number) - 1) & (ECC_KEYIDX_CHUNKSIZE - 1)])
 
-eccindexkey_t ECC_ConstKey_none = { { { 0 } } };
+eccindexkey_t ECC_ConstKey_none = { { 0 } };
 
 eccindexkey_t ECC_ConstKey_prototype;
 eccindexkey_t ECC_ConstKey_constructor;
@@ -47,70 +79,161 @@ eccindexkey_t ECC_ConstKey_source;
 eccindexkey_t ecc_keyidx_makewithnumber(uint32_t number)
 {
     eccindexkey_t key;
-    key.data.depth[0] = number >> 12 & 0xf;
-    key.data.depth[1] = number >> 8 & 0xf;
-    key.data.depth[2] = number >> 4 & 0xf;
-    key.data.depth[3] = number >> 0 & 0xf;
+    key.data.integer = number;
     return key;
 }
 
-eccindexkey_t ecc_keyidx_addwithtext(const eccstrbox_t text, int flags)
+uint32_t ecc_keyidx_hashtext(const eccstrbox_t text)
+{
+    int32_t index;
+    uint32_t hash;
+    /* FNV-1a */
+    hash = UINT32_C(2166136261);
+    for(index = 0; index < text.length; ++index)
+    {
+        hash ^= (uint8_t)text.bytes[index];
+        hash *= UINT32_C(16777619);
+    }
+    return hash;
+}
+
+static void ecc_keyidx_tableinsert(uint32_t number)
+{
+    uint32_t index;
+    index = g_storedkeyhashes[number - 1] & g_keytablemask;
+    while(g_keytable[index])
+    {
+        index = (index + 1) & g_keytablemask;
+    }
+    g_keytable[index] = number;
+}
+
+static void ecc_keyidx_tablerebuild(uint32_t size)
+{
+    uint32_t number;
+    free(g_keytable);
+    g_keytable = (uint32_t*)calloc(size, sizeof(*g_keytable));
+    if(g_keytable == NULL)
+    {
+        fprintf(stderr, "in tablerebuild: failed to allocate for %ld bytes\n", (long)(size * sizeof(*g_keytable)));
+    }
+    g_keytablemask = size - 1;
+    for(number = 1; number <= g_storedkeycount; ++number)
+    {
+        if(!(g_storedkeyflags[number - 1] & ECC_STOREDKEYFLAG_FREE))
+        {
+            ecc_keyidx_tableinsert(number);
+        }
+    }
+}
+
+static void ecc_keyidx_addchunk(void)
 {
     size_t needed;
-    char* chars;
-    char** tmp;
-    eccstrbox_t* ettmp;
+    uint32_t index;
+    uint32_t* uitmp;
+    eccstrbox_t* chunk;
+    eccstrbox_t** cktmp;
+    chunk = (eccstrbox_t*)malloc(ECC_KEYIDX_CHUNKSIZE * sizeof(*chunk));
+    if(chunk == NULL)
+    {
+        fprintf(stderr, "in addchunk: failed to allocate for %ld bytes\n", (long)(ECC_KEYIDX_CHUNKSIZE * sizeof(*chunk)));
+    }
+    needed = ((g_storedkeychunkcount + 1) * sizeof(*g_storedkeychunks));
+    cktmp = (eccstrbox_t**)realloc(g_storedkeychunks, needed);
+    if(cktmp == NULL)
+    {
+        fprintf(stderr, "in addchunk: failed to reallocate for %ld bytes\n", needed);
+    }
+    g_storedkeychunks = cktmp;
+    needed = ((g_storedkeychunkcount + 1) * sizeof(*g_storedkeychunkorder));
+    uitmp = (uint32_t*)realloc(g_storedkeychunkorder, needed);
+    if(uitmp == NULL)
+    {
+        fprintf(stderr, "in addchunk: failed to reallocate for %ld bytes\n", needed);
+    }
+    g_storedkeychunkorder = uitmp;
+    g_storedkeychunks[g_storedkeychunkcount] = chunk;
+    /* insertion keeps the order sorted; chunks are rare */
+    for(index = g_storedkeychunkcount; index > 0 && g_storedkeychunks[g_storedkeychunkorder[index - 1]] > chunk; --index)
+    {
+        g_storedkeychunkorder[index] = g_storedkeychunkorder[index - 1];
+    }
+    g_storedkeychunkorder[index] = g_storedkeychunkcount++;
+}
+
+static uint32_t ecc_keyidx_reserve(void)
+{
+    size_t needed;
+    uint32_t* uitmp;
+    uint8_t* fltmp;
+    if(g_freekeycount)
+    {
+        return g_freekeys[--g_freekeycount];
+    }
     if(g_storedkeycount >= g_storedkeycapacity)
     {
-        /*
-        if(g_storedkeycapacity == UINT16_MAX)
+        if(g_storedkeycapacity == UINT32_MAX)
         {
             ecc_script_fatal("No more identifier left");
         }
-        */
-        g_storedkeycapacity += 0xff;
-        needed = (g_storedkeycapacity * sizeof(*g_storedkeylist));
-        ettmp = (eccstrbox_t*)realloc(g_storedkeylist, needed);
-        if(ettmp == NULL)
+        g_storedkeycapacity = g_storedkeycapacity ? (g_storedkeycapacity > UINT32_MAX / 2 ? UINT32_MAX : g_storedkeycapacity * 2) : 0xff;
+        needed = (g_storedkeycapacity * sizeof(*g_storedkeyhashes));
+        uitmp = (uint32_t*)realloc(g_storedkeyhashes, needed);
+        if(uitmp == NULL)
         {
             fprintf(stderr, "in addwithtext: failed to reallocate for %ld bytes\n", needed);
         }
-        g_storedkeylist = ettmp;
-
+        g_storedkeyhashes = uitmp;
+        needed = (g_storedkeycapacity * sizeof(*g_storedkeyflags));
+        fltmp = (uint8_t*)realloc(g_storedkeyflags, needed);
+        if(fltmp == NULL)
+        {
+            fprintf(stderr, "in addwithtext: failed to reallocate for %ld bytes\n", needed);
+        }
+        g_storedkeyflags = fltmp;
     }
-    /*
-    if((isdigit(text.bytes[0]) || text.bytes[0] == '-') && !isnan(ecc_astlex_scanbinary(text, 0).data.valnumfloat))
+    if(g_storedkeycount >= g_storedkeychunkcount * ECC_KEYIDX_CHUNKSIZE)
+    {
+        ecc_keyidx_addchunk();
+    }
+    return ++g_storedkeycount;
+}
+
+eccindexkey_t ecc_keyidx_addwithtext(const eccstrbox_t text, int flags)
+{
+    char* chars;
+    uint32_t number;
+    /* keep the index at most half full */
+    if((g_storedkeycount - g_freekeycount + 1) * 2 > g_keytablemask + 1)
     {
-        ecc_env_printwarning("Creating identifier '%.*s'; %u identifier(s) left. Using array of length > 0x%x, or negative-integer/floating-point as property name is discouraged",
-                              text.length, text.bytes, UINT16_MAX - g_storedkeycount, ECC_CONF_MAXELEMENTS);
+        ecc_keyidx_tablerebuild(g_keytable ? (g_keytablemask + 1) * 2 : 1024);
     }
-    */
-    if(flags & ECC_INDEXFLAG_COPYONCREATE)
+    number = ecc_keyidx_reserve();
+    g_storedkeyhashes[number - 1] = ecc_keyidx_hashtext(text);
+    g_storedkeyflags[number - 1] = (flags & ECC_INDEXFLAG_TRANSIENT) ? ECC_STOREDKEYFLAG_TRANSIENT : 0;
+    if(flags & (ECC_INDEXFLAG_COPYONCREATE | ECC_INDEXFLAG_TRANSIENT))
     {
         chars = (char*)malloc(text.length + 1);
         memcpy(chars, text.bytes, text.length);
         chars[text.length] = '\0';
-        needed = (sizeof(*g_storedcharslist) * (g_storedcharscount + 1));
-        tmp = (char**)realloc(g_storedcharslist, needed);
-        if(tmp == NULL)
-        {
-            fprintf(stderr, "in addwithtext: failed to reallocate for %ld bytes\n", needed);
-        }
-        g_storedcharslist = tmp;
-        g_storedcharslist[g_storedcharscount++] = chars;
-        g_storedkeylist[g_storedkeycount++] = ecc_strbox_make(chars, text.length);
+        g_storedkeyflags[number - 1] |= ECC_STOREDKEYFLAG_OWNSTEXT;
+        *ecc_keyidx_box(number) = ecc_strbox_make(chars, text.length);
     }
     else
     {
-        g_storedkeylist[g_storedkeycount++] = text;
+        *ecc_keyidx_box(number) = text;
     }
-    return ecc_keyidx_makewithnumber(g_storedkeycount);
+    ++g_livekeycount;
+    ++g_createdkeycount;
+    ecc_keyidx_tableinsert(number);
+    return ecc_keyidx_makewithnumber(number);
 }
 
 void ecc_keyidx_setup(void)
 {
     const char* cstr;
-    if(!g_storedkeylist)
+    if(!g_storedkeychunks)
     {
         {
             cstr = "prototype";
@@ -217,18 +340,140 @@ void ecc_keyidx_setup(void)
 
 void ecc_keyidx_teardown(void)
 {
-    while(g_storedcharscount)
+    uint32_t number;
+    for(number = 1; number <= g_storedkeycount; ++number)
+    {
+        if(g_storedkeyflags[number - 1] & ECC_STOREDKEYFLAG_OWNSTEXT)
+        {
+            free((char*)ecc_keyidx_box(number)->bytes);
+        }
+    }
+    while(g_storedkeychunkcount)
     {
-        free(g_storedcharslist[--g_storedcharscount]);
-        g_storedcharslist[g_storedcharscount] = NULL;
+        free(g_storedkeychunks[--g_storedkeychunkcount]);
     }
-    free(g_storedcharslist);
-    g_storedcharslist = NULL;
-    g_storedcharscount = 0;
-    free(g_storedkeylist);
-    g_storedkeylist = NULL;
+    free(g_storedkeychunks);
+    g_storedkeychunks = NULL;
+    free(g_storedkeychunkorder);
+    g_storedkeychunkorder = NULL;
+    free(g_storedkeyhashes);
+    g_storedkeyhashes = NULL;
+    free(g_storedkeyflags);
+    g_storedkeyflags = NULL;
+    free(g_freekeys);
+    g_freekeys = NULL;
+    g_freekeycount = 0;
+    free(g_keytable);
+    g_keytable = NULL;
+    g_keytablemask = 0;
     g_storedkeycount = 0;
     g_storedkeycapacity = 0;
+    g_livekeycount = 0;
+    g_createdkeycount = 0;
+}
+
+static void ecc_keyidx_setmark(uint32_t index)
+{
+#if ECC_CONF_PARALLELGC
+    /* parallel collections mark from several threads */
+    if(!(__atomic_load_n(&g_storedkeyflags[index], __ATOMIC_RELAXED) & ECC_STOREDKEYFLAG_MARK))
+    {
+        __atomic_fetch_or(&g_storedkeyflags[index], ECC_STOREDKEYFLAG_MARK, __ATOMIC_RELAXED);
+    }
+#else
+    g_storedkeyflags[index] |= ECC_STOREDKEYFLAG_MARK;
+#endif
+}
+
+void ecc_keyidx_mark(eccindexkey_t key)
+{
+    if(key.data.integer)
+    {
+        ecc_keyidx_setmark(key.data.integer - 1);
+    }
+}
+
+/* marks the key whose text 'text' points to, if any (see ecc_keyidx_textof) */
+void ecc_keyidx_marktext(const eccstrbox_t* text)
+{
+    uint32_t low;
+    uint32_t high;
+    uint32_t middle;
+    const eccstrbox_t* chunk;
+    if(!g_storedkeychunkcount || text < g_storedkeychunks[g_storedkeychunkorder[0]]
+       || text >= g_storedkeychunks[g_storedkeychunkorder[g_storedkeychunkcount - 1]] + ECC_KEYIDX_CHUNKSIZE)
+    {
+        return;
+    }
+    low = 0;
+    high = g_storedkeychunkcount;
+    while(high - low > 1)
+    {
+        middle = (low + high) / 2;
+        if(text < g_storedkeychunks[g_storedkeychunkorder[middle]])
+        {
+            high = middle;
+        }
+        else
+        {
+            low = middle;
+        }
+    }
+    chunk = g_storedkeychunks[g_storedkeychunkorder[low]];
+    if(text < chunk + ECC_KEYIDX_CHUNKSIZE)
+    {
+        ecc_keyidx_setmark((g_storedkeychunkorder[low] << ECC_KEYIDX_CHUNKBITS) + (uint32_t)(text - chunk));
+    }
+}
+
+/* reclaims transient keys left unmarked since the last collection, and clears every mark */
+void ecc_keyidx_collectunmarked(void)
+{
+    size_t needed;
+    uint32_t number;
+    uint32_t reclaimed;
+    uint32_t* uitmp;
+    uint8_t* flags;
+    reclaimed = 0;
+    /* pushed from the top down, so the lowest numbers are reused first */
+    for(number = g_storedkeycount; number > 0; --number)
+    {
+        flags = &g_storedkeyflags[number - 1];
+        if((*flags & (ECC_STOREDKEYFLAG_TRANSIENT | ECC_STOREDKEYFLAG_MARK | ECC_STOREDKEYFLAG_FREE)) == ECC_STOREDKEYFLAG_TRANSIENT)
+        {
+            if(!reclaimed)
+            {
+                needed = ((g_freekeycount + g_livekeycount) * sizeof(*g_freekeys));
+                uitmp = (uint32_t*)realloc(g_freekeys, needed);
+                if(uitmp == NULL)
+                {
+                    fprintf(stderr, "in collectunmarked: failed to reallocate for %ld bytes\n", needed);
+                }
+                g_freekeys = uitmp;
+            }
+            free((char*)ecc_keyidx_box(number)->bytes);
+            *ecc_keyidx_box(number) = ECC_String_Empty;
+            *flags = ECC_STOREDKEYFLAG_FREE;
+            g_freekeys[g_freekeycount++] = number;
+            ++reclaimed;
+        }
+        *flags &= ~ECC_STOREDKEYFLAG_MARK;
+    }
+    if(reclaimed)
+    {
+        g_livekeycount -= reclaimed;
+        ecc_keyidx_tablerebuild(g_keytablemask + 1);
+    }
+}
+
+uint32_t ecc_keyidx_livecount(void)
+{
+    return g_livekeycount;
+}
+
+uint32_t ecc_keyidx_createdcount(void)
+{
+    return g_createdkeycount;
 }
 
 eccindexkey_t ecc_keyidx_makewithcstring(const char* cString)
@@ -243,19 +488,33 @@ eccindexkey_t ecc_keyidx_makewithtext(const eccstrbox_t text, int flags)
     {
         key = ecc_keyidx_addwithtext(text, flags);
     }
+    else if(!(flags & ECC_INDEXFLAG_TRANSIENT))
+    {
+        /* now referenced from parsed code or native setup: keep it for good */
+        g_storedkeyflags[key.data.integer - 1] &= ~ECC_STOREDKEYFLAG_TRANSIENT;
+    }
     return key;
 }
 
 eccindexkey_t ecc_keyidx_search(const eccstrbox_t text)
 {
+    uint32_t hash;
     uint32_t index;
-    index = 0;
-    for(index = 0; index < g_storedkeycount; ++index)
+    uint32_t number;
+    if(!g_keytable)
+    {
+        return ecc_keyidx_makewithnumber(0);
+    }
+    hash = ecc_keyidx_hashtext(text);
+    index = hash & g_keytablemask;
+    while((number = g_keytable[index]))
     {
-        if(text.length == g_storedkeylist[index].length && memcmp(g_storedkeylist[index].bytes, text.bytes, text.length) == 0)
+        if(g_storedkeyhashes[number - 1] == hash && text.length == ecc_keyidx_box(number)->length
+           && memcmp(ecc_keyidx_box(number)->bytes, text.bytes, text.length) == 0)
         {
-            return ecc_keyidx_makewithnumber(index + 1);
+            return ecc_keyidx_makewithnumber(number);
         }
+        index = (index + 1) & g_keytablemask;
     }
     return ecc_keyidx_makewithnumber(0);
 }
@@ -268,10 +527,10 @@ int ecc_keyidx_isequal(eccindexkey_t self, eccindexkey_t to)
 const eccstrbox_t* ecc_keyidx_textof(eccindexkey_t key)
 {
     uint32_t number;
-    number = ((key.data.depth[0] << 12) | (key.data.depth[1] << 8) | (key.data.depth[2] << 4) | key.data.depth[3]);
+    number = key.data.integer;
     if(number)
     {
-        return &g_storedkeylist[number - 1];
+        return ecc_keyidx_box(number);
     }
     return &ECC_String_Empty;
 }
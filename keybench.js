@@ -0,0 +1,26 @@
+/*
+ * interning benchmark: time per string-keyed property access
+ * as the number of distinct keys in the process grows.
+ * should stay roughly flat; a linear key search grows with the key count.
+ */
+var lookups = 200000;
+var sizes = [ 1000, 4000, 16000, 40000 ];
+var interned = 0;
+for (var s = 0; s < sizes.length; ++s)
+{
+    var size = sizes[s];
+    var names = [];
+    var object = {};
+    for (var i = 0; i < size; ++i)
+    {
+        names[i] = 'key' + (interned + i);
+        object[names[i]] = i;
+    }
+    interned += size;
+    var sum = 0;
+    var start = (new Date).getTime();
+    for (var i = 0; i < lookups; ++i)
+        sum += object[names[i % size]];
+    var elapsed = (new Date).getTime() - start;
+    println(interned + " keys: " + (elapsed * 1e6 / lookups).toFixed(0) + " ns/lookup (" + sum + ")");
+}
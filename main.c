@@ -94,11 +94,43 @@ error:
 
 #define test(i, e, t) ecc_unittest_actuallyruntest(__func__, __LINE__, i, e, t)
 
+/*
+// collect('young' | 'step' | 'full') runs that collection from within a test.
+// 'step' marks a few objects and returns true once its cycle has swept.
+// 'full' also reclaims keys and shapes, so call it as a statement of its own.
+// collect('shapes') only counts the shapes there are.
+*/
+static eccvalue_t ecc_unittest_collect(ecccontext_t* context)
+{
+    eccvalue_t kind;
+    kind = ecc_value_tostring(context, ecc_context_argument(context, 0));
+    if(ecc_value_stringlength(&kind) == 5 && !memcmp(ecc_value_stringbytes(&kind), "young", 5))
+    {
+        ecc_script_collectyoung(ecc);
+    }
+    else if(ecc_value_stringlength(&kind) == 6 && !memcmp(ecc_value_stringbytes(&kind), "shapes", 6))
+    {
+        return ecc_value_fromint(ecc_shape_count());
+    }
+    else if(ecc_value_stringlength(&kind) == 4 && !memcmp(ecc_value_stringbytes(&kind), "step", 4))
+    {
+        return ecc_value_truth(ecc_script_collectstep(ecc, 4));
+    }
+    else
+    {
+        ecc_script_garbagecollect(ecc);
+        ecc_keyidx_collectunmarked();
+        ecc_shape_collectunmarked();
+    }
+    return ECCValConstUndefined;
+}
+
 #include "testcode.h"
 
 static int ecc_unittest_runtests(int verbosity)
 {
     g_testverbosity = verbosity;
+    ecc_script_addfunction(ecc, "collect", ecc_unittest_collect, 1, ECC_VALFLAG_HIDDEN);
     /* test("debugger", "undefined", NULL); */
     ecc_unittest_testlexer();
     ecc_unittest_testparser();
@@ -136,14 +168,14 @@ static int ecc_unittest_runtests(int verbosity)
     }
     ecc_env_newline();
     ecc_env_newline();
-    ecc_env_print("%d tests, %.2f ms", g_testtotalcount, g_testtime * 1000);
+    ecc_env_print("%d tests, %.2f ms, %u of %u keys live", g_testtotalcount, g_testtime * 1000, ecc_keyidx_livecount(), ecc_keyidx_createdcount());
     return g_testerrorcount ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 static int ecc_cli_printusage(void)
 {
     const char error[] = "Usage";
-    ecc_env_printerror(sizeof(error) - 1, error, "libecc [<filename> | --test | --test-verbose | --test-quiet]");
+    ecc_env_printerror(sizeof(error) - 1, error, "libecc [--dispatch-loop | --dispatch-call] [--jit | --no-jit] [--fusion | --no-fusion | --fusion-report] [--gc-threads=<count>] [<filename> | --test | --test-verbose | --test-quiet]");
 
     return EXIT_FAILURE;
 }
@@ -189,10 +221,36 @@ static eccvalue_t ecc_clifn_println(ecccontext_t* context)
 int main(int argc, const char* argv[])
 {
     int result;
+    int gctimed = 0;
+    double start;
     ecc = ecc_script_create();
     ecc_script_addfunction(ecc, "alert", ecc_clifn_alert, -1, 0);
     ecc_script_addfunction(ecc, "print", ecc_clifn_print, -1, 0);
     ecc_script_addfunction(ecc, "println", ecc_clifn_println, -1, 0);
+    if(argc > 1 && (!strcmp(argv[1], "--dispatch-loop") || !strcmp(argv[1], "--dispatch-call")))
+    {
+        ecc->dispatchLoop = !strcmp(argv[1], "--dispatch-loop");
+        --argc, ++argv;
+    }
+    if(argc > 1 && (!strcmp(argv[1], "--jit") || !strcmp(argv[1], "--no-jit")))
+    {
+        ecc->jit = !strcmp(argv[1], "--jit");
+        --argc, ++argv;
+    }
+    if(argc > 1 && (!strcmp(argv[1], "--fusion") || !strcmp(argv[1], "--no-fusion") || !strcmp(argv[1], "--fusion-report")))
+    {
+        /* the report lists the ops each function no longer dispatches as it is parsed */
+        ecc->fusion = !!strcmp(argv[1], "--no-fusion");
+        ecc->fusionReport = !strcmp(argv[1], "--fusion-report");
+        --argc, ++argv;
+    }
+    if(argc > 1 && !strncmp(argv[1], "--gc-threads=", 13))
+    {
+        /* also times a full collection of what the script left behind */
+        ecc->gcThreads = (uint32_t)atoi(argv[1] + 13);
+        gctimed = 1;
+        --argc, ++argv;
+    }
     if(argc <= 1 || !strcmp(argv[1], "--help"))
     {
         result = ecc_cli_printusage();
@@ -215,6 +273,18 @@ int main(int argc, const char* argv[])
         ecc_script_addvalue(ecc, "arguments", ecc_value_object(arguments), 0);
         ecc_script_addvalue(ecc, "SHELLARGV", ecc_value_object(arguments), 0);
         result = ecc_script_evalinput(ecc, ecc_ioinput_createfromfile(argv[1]), ECC_SCRIPTEVAL_SLOPPYMODE);
+        if(gctimed)
+        {
+            start = ecc_env_currenttime();
+            ecc_script_garbagecollect(ecc);
+            fprintf(stderr, "full collection: %.0f ms\n", ecc_env_currenttime() - start);
+        }
+#if ECC_CONF_FUSIONCOUNT
+        if(ecc->fusionReport)
+        {
+            fprintf(stderr, "fusion: %llu dispatches saved\n", (unsigned long long)ecc->fusedDispatches);
+        }
+#endif
     }
     ecc_script_destroy(ecc), ecc = NULL;
     return result;
@@ -0,0 +1,12 @@
+/*
+ * mark benchmark: builds one long linked list hanging off a global, plus a few wide
+ * objects, for the timed full collection that follows the script.
+ * usage: run --gc-threads=1 marklistbench.js [nodes]
+ */
+var count = +(arguments[0] || 10000000);
+var start = (new Date).getTime();
+list = null;
+for (var i = 0; i < count; ++i)
+    list = { next: list, value: i };
+
+println(count + " nodes built in " + ((new Date).getTime() - start) + " ms");
@@ -41,6 +41,18 @@
 #define opmac_value() (context->ops)->opvalue
 #define opmac_text(O) &(context->ops + O)->text
 
+#if ECC_CONF_DISPATCHLOOP
+    /* runs a statement body, either through the dispatch loop or by threading */
+    #define opmac_nextstatement() (context->ecc->dispatchLoop ? (++context->ops, ecc_oper_dispatch(context)) : opmac_next())
+    /* statement ops called by the dispatch loop return to it rather than calling the next statement */
+    #define opmac_takeyield(canyield) canyield = context->canyield, context->canyield = 0
+    #define opmac_yield(canyield) ((canyield) ? ECCValConstUndefined : opmac_next())
+#else
+    #define opmac_nextstatement() opmac_next()
+    #define opmac_takeyield(canyield) canyield = 0
+    #define opmac_yield(canyield) opmac_next()
+#endif
+
 
 #if _MSC_VER
     #define trap() __debugbreak()
@@ -166,6 +178,11 @@ eccoperand_t ecc_oper_make(const eccnativefuncptr_t native, eccvalue_t value, ec
     rt.native = native;
     rt.opvalue = value;
     rt.text = text;
+    rt.opcode = ECC_OPCODE_NATIVE;
+    rt.feedback = 0;
+    rt.jitcount = 0;
+    rt.cache = NULL;
+    rt.jitcode = NULL;
     return rt;
 }
 
@@ -208,6 +225,9 @@ const char* ecc_oper_tochars(const eccnativefuncptr_t native)
         { "getProperty", ecc_oper_getproperty },
         { "setProperty", ecc_oper_setproperty },
         { "callProperty", ecc_oper_callproperty },
+        { "tailCall", ecc_oper_tailcall },
+        { "tailCallMember", ecc_oper_tailcallmember },
+        { "tailCallProperty", ecc_oper_tailcallproperty },
         { "deleteProperty", ecc_oper_deleteproperty },
         { "pushEnvironment", ecc_oper_pushenvironment },
         { "popEnvironment", ecc_oper_popenvironment },
@@ -234,6 +254,25 @@ const char* ecc_oper_tochars(const eccnativefuncptr_t native)
         { "bitwiseAnd", ecc_oper_bitwiseand },
         { "bitwiseXor", ecc_oper_bitwisexor },
         { "bitwiseOr", ecc_oper_bitwiseor },
+        { "addInt", ecc_oper_addint },
+        { "minusInt", ecc_oper_minusint },
+        { "multiplyInt", ecc_oper_multiplyint },
+        { "leftShiftInt", ecc_oper_leftshiftint },
+        { "rightShiftInt", ecc_oper_rightshiftint },
+        { "unsignedRightShiftInt", ecc_oper_unsignedrightshiftint },
+        { "bitwiseAndInt", ecc_oper_bitwiseandint },
+        { "bitwiseXorInt", ecc_oper_bitwisexorint },
+        { "bitwiseOrInt", ecc_oper_bitwiseorint },
+        { "addFused", ecc_oper_addfused },
+        { "minusFused", ecc_oper_minusfused },
+        { "multiplyFused", ecc_oper_multiplyfused },
+        { "lessFused", ecc_oper_lessfused },
+        { "lessOrEqualFused", ecc_oper_lessorequalfused },
+        { "moreFused", ecc_oper_morefused },
+        { "moreOrEqualFused", ecc_oper_moreorequalfused },
+        { "setLocalSlotAdd", ecc_oper_setlocalslotadd },
+        { "setParentSlotAdd", ecc_oper_setparentslotadd },
+        { "getMemberSlot", ecc_oper_getmemberslot },
         { "logicalAnd", ecc_oper_logicaland },
         { "logicalOr", ecc_oper_logicalor },
         { "positive", ecc_oper_positive },
@@ -272,6 +311,7 @@ const char* ecc_oper_tochars(const eccnativefuncptr_t native)
         { "jump", ecc_oper_jump },
         { "jumpIf", ecc_oper_jumpif },
         { "jumpIfNot", ecc_oper_jumpifnot },
+        { "jumpIfNotCompare", ecc_oper_jumpifnotcompare },
         { "repopulate", ecc_oper_repopulate },
         { "result", ecc_oper_result },
         { "resultVoid", ecc_oper_resultvoid },
@@ -313,8 +353,141 @@ eccvalue_t ecc_oper_replacerefvalue(eccvalue_t* ref, eccvalue_t value)
     return value;
 }
 
+static eccvalue_t ecc_oper_runops(ecccontext_t* context)
+{
+#if ECC_CONF_DISPATCHLOOP
+    if(context->ecc->dispatchLoop)
+    {
+        return ecc_oper_dispatch(context);
+    }
+#endif
+    return context->ops->native(context);
+}
+
+/*
+* parameters and arguments are stored as they are evaluated: the ones before may have run
+* a young collection that made a heap environment or arguments object old, hence the barriers.
+*/
+static eccvalue_t ecc_oper_setparameter(eccobject_t* environment, int32_t index, eccvalue_t value)
+{
+    return ecc_object_setvalue(environment, &environment->hmapmapitems[index + 3].hmapmapvalue, value);
+}
+
+static eccvalue_t ecc_oper_setargument(eccobject_t* arguments, int32_t index, eccvalue_t value)
+{
+    ecc_mempool_writebarrier(arguments, value);
+    return arguments->hmapitemitems[index].hmapitemvalue = value;
+}
+
+/* the parameters and arguments of a pending tail call, as ecc_oper_makeenvandargswithops and ecc_oper_populateenvwithops do */
+static void ecc_oper_populateenvwithvalues(eccobject_t* environment, eccobject_t* arguments, int heap, int32_t paramcnt, int32_t argcnt, const eccvalue_t* values)
+{
+    int32_t index;
+    eccvalue_t value;
+    if(arguments)
+    {
+        ecc_oper_replacerefvalue(&environment->hmapmapitems[2].hmapmapvalue, heap ? ecc_oper_retain(ecc_value_object(arguments)) : ecc_value_object(arguments));
+    }
+    for(index = 0; index < argcnt; ++index)
+    {
+        value = (index < paramcnt || heap) ? ecc_oper_retain(values[index]) : values[index];
+        if(index < paramcnt)
+        {
+            ecc_oper_setparameter(environment, index, value);
+        }
+        if(arguments)
+        {
+            ecc_oper_setargument(arguments, index, value);
+        }
+    }
+}
+
+/* a chain of tail calls can run for good without a loop statement, so it gets the safe point of a loop step */
+static void ecc_oper_tailsafepoint(ecccontext_t* context)
+{
+    if(ecc_mempool_collectpending())
+    {
+        ecc_script_autocollect(context->ecc);
+    }
+}
+
+/*
+* runs the call left pending by ecc_oper_tailcall in the frame of 'context', whose function just returned:
+* the context is reset for the callee instead of nesting a new one, so depth and C stack stay the same.
+*/
+static eccvalue_t ecc_oper_calltail(ecccontext_t* context)
+{
+    int32_t index;
+    int32_t argcnt;
+    uint32_t count;
+    eccvalue_t result;
+    eccobject_t fnenv;
+    eccobject_t arguments;
+    eccobject_t* envobj;
+    eccobjfunction_t* function;
+    eccstate_t* ecc;
+    ecc = context->ecc;
+    function = ecc->tailFunction;
+    argcnt = ecc->tailCount;
+    ecc->tailFunction = NULL;
+    context->ops = function->oplist->ops;
+    context->thisvalue = ecc->tailThis;
+    context->refobject = function->refobject;
+    context->ctxtextfirst = NULL;
+    context->ctxtextalt = NULL;
+    context->ctxtextcall = NULL;
+    context->ctxtextindex = 0;
+    context->breaker = 0;
+    context->construct = 0;
+    context->argoffset = 0;
+    context->insideenvobject = 0;
+    context->isstrictmode = function->flags & ECC_SCRIPTFUNCFLAG_STRICTMODE;
+    if(function->flags & ECC_SCRIPTFUNCFLAG_NEEDHEAP)
+    {
+        envobj = ecc_object_copy(&function->funcenv);
+        ecc_oper_populateenvwithvalues(envobj, (function->flags & ECC_SCRIPTFUNCFLAG_NEEDARGUMENTS) ? ecc_args_createsized(argcnt) : NULL, 1,
+                                       function->argparamcount, argcnt, ecc->tailValues);
+        for(index = 0; index < argcnt; ++index)
+        {
+            ecc_oper_release(ecc->tailValues[index]);
+        }
+        context->execenv = envobj;
+        ecc_oper_tailsafepoint(context);
+        return ecc_oper_runops(context);
+    }
+    fnenv = function->funcenv;
+    fnenv.flags |= ECC_OBJFLAG_YOUNG;
+    memset(&arguments, 0, sizeof(eccobject_t));
+    arguments.flags = ECC_OBJFLAG_YOUNG;
+    ecchashmap_t hashmap[function->funcenv.hmapmapcapacity];
+    ecchashitem_t element[argcnt ? argcnt : 1];
+    memcpy(hashmap, function->funcenv.hmapmapitems, function->funcenv.hmapmapcapacity * sizeof(ecchashmap_t));
+    fnenv.hmapmapitems = hashmap;
+    arguments.hmapitemitems = element;
+    arguments.hmapitemcount = argcnt;
+    ecc_oper_populateenvwithvalues(&fnenv, (function->flags & ECC_SCRIPTFUNCFLAG_NEEDARGUMENTS) ? &arguments : NULL, 0,
+                                   function->argparamcount, argcnt, ecc->tailValues);
+    if(function->cells)
+    {
+        ecc_oper_boxcells(function, &fnenv);
+    }
+    for(index = 0; index < argcnt; ++index)
+    {
+        ecc_oper_release(ecc->tailValues[index]);
+    }
+    context->execenv = &fnenv;
+    ecc_oper_tailsafepoint(context);
+    result = ecc_oper_runops(context);
+    for(index = 2, count = fnenv.hmapmapcount; index < (int32_t)count; ++index)
+    {
+        ecc_oper_release(fnenv.hmapmapitems[index].hmapmapvalue);
+    }
+    return result;
+}
+
 eccvalue_t ecc_oper_callops(ecccontext_t* context, eccobject_t* environment)
 {
+    eccvalue_t result;
     if(context->depth >= context->ecc->maximumCallDepth)
     {
         ecc_context_rangeerror(context, ecc_strbuf_create("maximum depth exceeded"));
@@ -329,7 +502,12 @@ eccvalue_t ecc_oper_callops(ecccontext_t* context, eccobject_t* environment)
     }
     */
     context->execenv = environment;
-    return context->ops->native(context);
+    result = ecc_oper_runops(context);
+    while(context->ecc->tailFunction)
+    {
+        result = ecc_oper_calltail(context);
+    }
+    return result;
 }
 
 eccvalue_t ecc_oper_callvalue(ecccontext_t* context, eccvalue_t value, eccvalue_t thisval, int32_t argcnt, int construct, const eccstrbox_t* textcall)
@@ -355,6 +533,48 @@ eccvalue_t ecc_oper_callvalue(ecccontext_t* context, eccvalue_t value, eccvalue_
     return result;
 }
 
+/*
+* a call in return position of a strict function: the arguments are evaluated here, then the call is left
+* pending for ecc_oper_callops to run once the result operand has returned from the calling function.
+* natives (bound functions included) and non-functions go through ecc_oper_callvalue as usual.
+*/
+eccvalue_t ecc_oper_tailcallvalue(ecccontext_t* context, eccvalue_t value, eccvalue_t thisval, int32_t argcnt, const eccstrbox_t* textcall)
+{
+    int32_t index;
+    eccstate_t* ecc;
+    eccvalue_t* values;
+    const eccstrbox_t* ptextcall;
+    if(value.type != ECC_VALTYPE_FUNCTION || value.data.function->text.bytes == ECC_String_NativeCode.bytes)
+    {
+        return ecc_oper_callvalue(context, value, thisval, argcnt, 0, textcall);
+    }
+    ecc = context->ecc;
+    ptextcall = context->ctxtextcall;
+    context->ctxtextcall = textcall;
+    eccvalue_t evaluated[argcnt ? argcnt : 1];
+    for(index = 0; index < argcnt; ++index)
+    {
+        evaluated[index] = ecc_oper_retain(ecc_oper_nextopvalue(context));
+    }
+    context->ctxtextcall = ptextcall;
+    /* argument evaluation may run tail calls of its own, so the shared buffer is only filled now */
+    if(ecc->tailCapacity < argcnt)
+    {
+        values = (eccvalue_t*)realloc(ecc->tailValues, sizeof(*values) * argcnt);
+        if(!values)
+        {
+            ecc_script_fatal("Memory error");
+        }
+        ecc->tailValues = values;
+        ecc->tailCapacity = argcnt;
+    }
+    memcpy(ecc->tailValues, evaluated, sizeof(*evaluated) * argcnt);
+    ecc->tailCount = argcnt;
+    ecc->tailThis = (value.data.function->flags & ECC_SCRIPTFUNCFLAG_USEBOUNDTHIS) ? value.data.function->boundthisvalue : thisval;
+    ecc->tailFunction = value.data.function;
+    return ECCValConstUndefined;
+}
+
 eccvalue_t ecc_oper_callopsrelease(ecccontext_t* context, eccobject_t* environment)
 {
     eccvalue_t result;
@@ -368,6 +588,25 @@ eccvalue_t ecc_oper_callopsrelease(ecccontext_t* context, eccobject_t* environme
     return result;
 }
 
+/*
+* the captured locals of a call to 'function' live in a copy of its cells, between the stack 'environment'
+* and the parent: captured parameters are copied there once populated.
+*/
+void ecc_oper_boxcells(eccobjfunction_t* function, eccobject_t* environment)
+{
+    uint32_t index;
+    uint32_t param;
+    eccobject_t* cells;
+    cells = ecc_object_copy(&function->cells->environment);
+    cells->prototype = environment->prototype;
+    for(index = 0; index < function->cells->paramcount; ++index)
+    {
+        param = function->cells->params[index];
+        ecc_oper_replacerefvalue(&cells->hmapmapitems[param & 0xffff].hmapmapvalue, ecc_oper_retain(environment->hmapmapitems[param >> 16].hmapmapvalue));
+    }
+    environment->prototype = cells;
+}
+
 void ecc_oper_makeenvwithargs(eccobject_t* environment, eccobject_t* arguments, int32_t paramcnt)
 {
     int argcnt;
@@ -379,14 +618,14 @@ void ecc_oper_makeenvwithargs(eccobject_t* environment, eccobject_t* arguments,
     {
         for(; index < argcnt; ++index)
         {
-            environment->hmapmapitems[index + 3].hmapmapvalue = ecc_oper_retain(arguments->hmapitemitems[index].hmapitemvalue);
+            ecc_oper_setparameter(environment, index, ecc_oper_retain(arguments->hmapitemitems[index].hmapitemvalue));
         }
     }
     else
     {
         for(; index < paramcnt; ++index)
         {
-            environment->hmapmapitems[index + 3].hmapmapvalue = ecc_oper_retain(arguments->hmapitemitems[index].hmapitemvalue);
+            ecc_oper_setparameter(environment, index, ecc_oper_retain(arguments->hmapitemitems[index].hmapitemvalue));
         }
     }
 }
@@ -402,18 +641,18 @@ void ecc_oper_makeenvandargswithva(eccobject_t* environment, int32_t paramcnt, i
     {
         for(; index < argcnt; ++index)
         {
-            environment->hmapmapitems[index + 3].hmapmapvalue = arguments->hmapitemitems[index].hmapitemvalue = ecc_oper_retain(va_arg(ap, eccvalue_t));
+            ecc_oper_setparameter(environment, index, ecc_oper_setargument(arguments, index, ecc_oper_retain(va_arg(ap, eccvalue_t))));
         }
     }
     else
     {
         for(; index < paramcnt; ++index)
         {
-            environment->hmapmapitems[index + 3].hmapmapvalue = arguments->hmapitemitems[index].hmapitemvalue = ecc_oper_retain(va_arg(ap, eccvalue_t));
+            ecc_oper_setparameter(environment, index, ecc_oper_setargument(arguments, index, ecc_oper_retain(va_arg(ap, eccvalue_t))));
         }
         for(; index < argcnt; ++index)
         {
-            arguments->hmapitemitems[index].hmapitemvalue = ecc_oper_retain(va_arg(ap, eccvalue_t));
+            ecc_oper_setargument(arguments, index, ecc_oper_retain(va_arg(ap, eccvalue_t)));
         }
     }
 }
@@ -426,14 +665,14 @@ void ecc_oper_populateenvwithva(eccobject_t* environment, int32_t paramcnt, int3
     {
         for(; index < argcnt; ++index)
         {
-            environment->hmapmapitems[index + 3].hmapmapvalue = ecc_oper_retain(va_arg(ap, eccvalue_t));
+            ecc_oper_setparameter(environment, index, ecc_oper_retain(va_arg(ap, eccvalue_t)));
         }
     }
     else
     {
         for(; index < paramcnt; ++index)
         {
-            environment->hmapmapitems[index + 3].hmapmapvalue = ecc_oper_retain(va_arg(ap, eccvalue_t));
+            ecc_oper_setparameter(environment, index, ecc_oper_retain(va_arg(ap, eccvalue_t)));
         }
     }
 }
@@ -447,18 +686,18 @@ void ecc_oper_makestackenvandargswithops(ecccontext_t* context, eccobject_t* env
     {
         for(; index < argcnt; ++index)
         {
-            environment->hmapmapitems[index + 3].hmapmapvalue = arguments->hmapitemitems[index].hmapitemvalue = ecc_oper_retain(ecc_oper_nextopvalue(context));
+            ecc_oper_setparameter(environment, index, ecc_oper_setargument(arguments, index, ecc_oper_retain(ecc_oper_nextopvalue(context))));
         }
     }
     else
     {
         for(; index < paramcnt; ++index)
         {
-            environment->hmapmapitems[index + 3].hmapmapvalue = arguments->hmapitemitems[index].hmapitemvalue = ecc_oper_retain(ecc_oper_nextopvalue(context));
+            ecc_oper_setparameter(environment, index, ecc_oper_setargument(arguments, index, ecc_oper_retain(ecc_oper_nextopvalue(context))));
         }
         for(; index < argcnt; ++index)
         {
-            arguments->hmapitemitems[index].hmapitemvalue = ecc_oper_nextopvalue(context);
+            ecc_oper_setargument(arguments, index, ecc_oper_nextopvalue(context));
         }
     }
 }
@@ -485,13 +724,13 @@ void ecc_oper_populateenvwithops(ecccontext_t* context, eccobject_t* environment
     if(argcnt <= paramcnt)
     {
         for(; index < argcnt; ++index)
-            environment->hmapmapitems[index + 3].hmapmapvalue = ecc_oper_retain(ecc_oper_nextopvalue(context));
+            ecc_oper_setparameter(environment, index, ecc_oper_retain(ecc_oper_nextopvalue(context)));
     }
     else
     {
         for(; index < paramcnt; ++index)
         {
-            environment->hmapmapitems[index + 3].hmapmapvalue = ecc_oper_retain(ecc_oper_nextopvalue(context));
+            ecc_oper_setparameter(environment, index, ecc_oper_retain(ecc_oper_nextopvalue(context)));
         }
         for(; index < argcnt; ++index)
         {
@@ -529,6 +768,7 @@ eccvalue_t ecc_oper_callfunctionarguments(ecccontext_t* context, int offset, ecc
     else
     {
         funcenv = function->funcenv;
+        funcenv.flags |= ECC_OBJFLAG_YOUNG;
         #if 1
             ecchashmap_t hashmap[function->funcenv.hmapmapcapacity];
         #else
@@ -537,6 +777,10 @@ eccvalue_t ecc_oper_callfunctionarguments(ecccontext_t* context, int offset, ecc
         memcpy(hashmap, function->funcenv.hmapmapitems, function->funcenv.hmapmapcapacity * sizeof(ecchashmap_t));
         funcenv.hmapmapitems = hashmap;
         ecc_oper_makeenvwithargs(&funcenv, arguments, function->argparamcount);
+        if(function->cells)
+        {
+            ecc_oper_boxcells(function, &funcenv);
+        }
         return ecc_oper_callopsrelease(&subctx, &funcenv);
     }
 }
@@ -578,10 +822,15 @@ eccvalue_t ecc_oper_callfunctionva(ecccontext_t* context, int offset, eccobjfunc
     else
     {
         funcenv = function->funcenv;
+        funcenv.flags |= ECC_OBJFLAG_YOUNG;
         ecchashmap_t hashmap[function->funcenv.hmapmapcapacity+1];
         memcpy(hashmap, function->funcenv.hmapmapitems, function->funcenv.hmapmapcapacity * sizeof(ecchashmap_t));
         funcenv.hmapmapitems = hashmap;
         ecc_oper_populateenvwithva(&funcenv, function->argparamcount, argcnt, ap);
+        if(function->cells)
+        {
+            ecc_oper_boxcells(function, &funcenv);
+        }
         return ecc_oper_callopsrelease(&subctx, &funcenv);
     }
 }
@@ -624,7 +873,9 @@ eccvalue_t ecc_oper_callfunction(ecccontext_t* context, eccobjfunction_t* const
     else if(function->flags & ECC_SCRIPTFUNCFLAG_NEEDARGUMENTS)
     {
         fnenv = function->funcenv;
+        fnenv.flags |= ECC_OBJFLAG_YOUNG;
         memset(&arguments, 0, sizeof(eccobject_t));
+        arguments.flags = ECC_OBJFLAG_YOUNG;
         ecchashmap_t hashmap[function->funcenv.hmapmapcapacity];
         ecchashitem_t element[argcnt];
         memcpy(hashmap, function->funcenv.hmapmapitems, function->funcenv.hmapmapcapacity * sizeof(ecchashmap_t));
@@ -632,15 +883,24 @@ eccvalue_t ecc_oper_callfunction(ecccontext_t* context, eccobjfunction_t* const
         arguments.hmapitemitems = element;
         arguments.hmapitemcount = argcnt;
         ecc_oper_makestackenvandargswithops(context, &fnenv, &arguments, function->argparamcount, argcnt);
+        if(function->cells)
+        {
+            ecc_oper_boxcells(function, &fnenv);
+        }
         return ecc_oper_callopsrelease(&subctx, &fnenv);
     }
     else
     {
         fnenv = function->funcenv;
+        fnenv.flags |= ECC_OBJFLAG_YOUNG;
         ecchashmap_t hashmap[function->funcenv.hmapmapcapacity];
         memcpy(hashmap, function->funcenv.hmapmapitems, function->funcenv.hmapmapcapacity * sizeof(ecchashmap_t));
         fnenv.hmapmapitems = hashmap;
         ecc_oper_populateenvwithops(context, &fnenv, function->argparamcount, argcnt);
+        if(function->cells)
+        {
+            ecc_oper_boxcells(function, &fnenv);
+        }
         return ecc_oper_callopsrelease(&subctx, &fnenv);
     }
 }
@@ -703,7 +963,7 @@ eccvalue_t ecc_oper_construct(ecccontext_t* context)
     return ECCValConstUndefined;
 }
 
-eccvalue_t ecc_oper_call(ecccontext_t* context)
+static eccvalue_t ecc_oper_docall(ecccontext_t* context, int tail)
 {
     int32_t argcnt;
     eccvalue_t value;
@@ -730,9 +990,23 @@ eccvalue_t ecc_oper_call(ecccontext_t* context)
         thisval = ECCValConstUndefined;
     }
     ecc_context_settext(context, text);
+    if(tail)
+    {
+        return ecc_oper_tailcallvalue(context, value, thisval, argcnt, textcall);
+    }
     return ecc_oper_callvalue(context, value, thisval, argcnt, 0, textcall);
 }
 
+eccvalue_t ecc_oper_call(ecccontext_t* context)
+{
+    return ecc_oper_docall(context, 0);
+}
+
+eccvalue_t ecc_oper_tailcall(ecccontext_t* context)
+{
+    return ecc_oper_docall(context, 1);
+}
+
 eccvalue_t ecc_oper_eval(ecccontext_t* context)
 {
     int32_t argcnt;
@@ -812,11 +1086,14 @@ eccvalue_t ecc_oper_function(ecccontext_t* context)
     eccvalue_t value;
     eccvalue_t result;
     eccobject_t* prototype;
+    eccobject_t* environment;
     eccobjfunction_t* function;
     value = opmac_value();
     function = ecc_function_copy(value.data.function);
     function->object.prototype = &value.data.function->object;
-    function->funcenv.prototype = context->execenv;
+    /* closing over the cells (or the parent) of a function that boxed its captured locals */
+    environment = (value.data.function->flags & ECC_SCRIPTFUNCFLAG_BOXEDPARENT) ? context->execenv->prototype : context->execenv;
+    function->funcenv.prototype = environment;
     if(context->refobject)
     {
         context->refobject->refcount++;
@@ -825,7 +1102,7 @@ eccvalue_t ecc_oper_function(ecccontext_t* context)
     prototype = ecc_object_create(ECC_Prototype_Object);
     ecc_function_linkprototype(function, ecc_value_object(prototype), ECC_VALFLAG_SEALED);
     prototype->refcount++;
-    context->execenv->refcount++;
+    environment->refcount++;
     function->object.refcount++;
     result = ecc_value_function(function);
     result.flags = value.flags;
@@ -839,7 +1116,7 @@ eccvalue_t ecc_oper_object(ecccontext_t* context)
     eccvalue_t property;
     eccobject_t* object;
     object = ecc_object_create(ECC_Prototype_Object);
-    object->flags |= ECC_OBJFLAG_MARK;
+    object->flags |= ECC_OBJFLAG_CAPTURED;
     for(count = opmac_value().data.integer; count--;)
     {
         property = opmac_next();
@@ -864,10 +1141,12 @@ eccvalue_t ecc_oper_array(ecccontext_t* context)
     eccobject_t* object;
     length = opmac_value().data.integer;
     object = ecc_array_createsized(length);
-    object->flags |= ECC_OBJFLAG_MARK;
+    object->flags |= ECC_OBJFLAG_CAPTURED;
     for(index = 0; index < length; ++index)
     {
         value = ecc_oper_retain(ecc_oper_nextopvalue(context));
+        /* the elements may have run a collection that made the array old */
+        ecc_mempool_writebarrier(object, value);
         object->hmapitemitems[index].hmapitemvalue = value;
     }
     return ecc_value_object(object);
@@ -947,6 +1226,7 @@ eccvalue_t ecc_oper_setlocal(ecccontext_t* context)
     {
         return value;
     }
+    ecc_mempool_escapebarrier(value);
     ecc_oper_retain(value);
     ecc_oper_release(*ref);
     ecc_oper_replacerefvalue(ref, value);
@@ -991,6 +1271,7 @@ eccvalue_t ecc_oper_setlocalslot(ecccontext_t* context)
     {
         return value;
     }
+    ecc_mempool_writebarrier(context->execenv, value);
     ecc_oper_retain(value);
     ecc_oper_release(*ref);
     ecc_oper_replacerefvalue(ref, value);
@@ -1027,11 +1308,19 @@ eccvalue_t ecc_oper_getparentslot(ecccontext_t* context)
 
 eccvalue_t ecc_oper_setparentslot(ecccontext_t* context)
 {
+    int32_t count;
     eccvalue_t value;
     eccvalue_t* ref;
+    eccobject_t* object;
     const eccstrbox_t* text;
     text = opmac_text(0);
-    ref = ecc_oper_getparentslotref(context).data.reference;
+    count = opmac_value().data.integer >> 16;
+    object = context->execenv;
+    while(count--)
+    {
+        object = object->prototype;
+    }
+    ref = &object->hmapmapitems[opmac_value().data.integer & 0xffff].hmapmapvalue;
     value = opmac_next();
     if(ref->flags & ECC_VALFLAG_READONLY)
     {
@@ -1044,6 +1333,7 @@ eccvalue_t ecc_oper_setparentslot(ecccontext_t* context)
     }
     else
     {
+        ecc_mempool_writebarrier(object, value);
         ecc_oper_retain(value);
         ecc_oper_release(*ref);
         ecc_oper_replacerefvalue(ref, value);
@@ -1092,43 +1382,173 @@ eccvalue_t ecc_oper_getmemberref(ecccontext_t* context)
     return ecc_value_reference(ref);
 }
 
+void ecc_oper_cacheinsert(eccopcache_t* cache, eccobject_t* holder, uint32_t slot, uint32_t depth)
+{
+    eccopcacheentry_t* entry;
+    if(cache->count < ECC_CONF_INLINECACHESIZE)
+    {
+        entry = &cache->entries[cache->count++];
+    }
+    else
+    {
+        entry = &cache->entries[cache->next];
+        cache->next = (cache->next + 1) % ECC_CONF_INLINECACHESIZE;
+    }
+    entry->holder = depth ? holder : NULL;
+    entry->slot = slot;
+    entry->depth = depth;
+}
+
+/*
+* same result as ecc_object_member(self, key, 0).
+* an entry is only trusted if every object skipped on the way to the holder
+* cannot have the key (memberbloom), and the cached slot still holds the key.
+*/
+eccvalue_t* ecc_oper_cachedmember(eccopcache_t* cache, eccobject_t* self, eccindexkey_t key)
+{
+    uint8_t index;
+    uint32_t slot;
+    uint32_t depth;
+    uint64_t bloombit;
+    eccvalue_t* ref;
+    eccobject_t* object;
+    const eccopcacheentry_t* entry;
+    bloombit = ecc_object_bloombit(key);
+    for(index = 0; index < cache->count; ++index)
+    {
+        entry = &cache->entries[index];
+        object = self;
+        for(depth = 0; depth < entry->depth && object && !(object->memberbloom & bloombit); ++depth)
+        {
+            object = object->prototype;
+        }
+        if(depth != entry->depth || !object || (depth && object != entry->holder) || entry->slot >= object->hmapmapcount)
+        {
+            continue;
+        }
+        ref = &object->hmapmapitems[entry->slot].hmapmapvalue;
+        if(ref->check == 1 && ecc_keyidx_isequal(ref->key, key))
+        {
+            return ref;
+        }
+    }
+    /* miss: regular lookup, remembering where the member was found */
+    for(object = self, depth = 0; object; object = object->prototype, ++depth)
+    {
+        if((slot = ecc_object_getslot(object, key)))
+        {
+            ref = &object->hmapmapitems[slot].hmapmapvalue;
+            if(ref->check == 1)
+            {
+                ecc_oper_cacheinsert(cache, object, slot, depth);
+                return ref;
+            }
+        }
+    }
+    return NULL;
+}
+
+void ecc_oper_cacheownmember(eccopcache_t* cache, eccobject_t* self, eccindexkey_t key)
+{
+    uint32_t slot;
+    if((slot = ecc_object_getslot(self, key)) && self->hmapmapitems[slot].hmapmapvalue.check == 1)
+    {
+        ecc_oper_cacheinsert(cache, self, slot, 0);
+    }
+}
+
 eccvalue_t ecc_oper_getmember(ecccontext_t* context)
 {
     eccvalue_t object;
     eccindexkey_t key;
+    eccopcache_t* cache;
     key = opmac_value().data.key;
+    cache = context->ops->cache;
     ecc_oper_prepareobject(context, &object);
+    if(cache)
+    {
+        return ecc_object_getvalue(context, object.data.object, ecc_oper_cachedmember(cache, object.data.object, key));
+    }
     return ecc_object_getmember(context, object.data.object, key);
 }
 
 eccvalue_t ecc_oper_setmember(ecccontext_t* context)
 {
+    uint8_t index;
     eccvalue_t object;
     eccvalue_t value;
+    eccvalue_t* ref;
     eccindexkey_t key;
+    eccopcache_t* cache;
     const eccstrbox_t* text = opmac_text(0);
     key = opmac_value().data.key;
+    cache = context->ops->cache;
     ecc_oper_prepareobject(context, &object);
     value = ecc_oper_retain(opmac_next());
     ecc_context_settext(context, text);
+    if(cache)
+    {
+        /* only own members are cached for stores; anything else takes the putmember path */
+        for(index = 0; index < cache->count; ++index)
+        {
+            if(cache->entries[index].slot < object.data.object->hmapmapcount)
+            {
+                ref = &object.data.object->hmapmapitems[cache->entries[index].slot].hmapmapvalue;
+                if(ref->check == 1 && ecc_keyidx_isequal(ref->key, key))
+                {
+                    value.flags = 0;
+                    ecc_object_putvalue(context, object.data.object, ref, value);
+                    return value;
+                }
+            }
+        }
+        ecc_object_putmember(context, object.data.object, key, value);
+        ecc_oper_cacheownmember(cache, object.data.object, key);
+        return value;
+    }
     ecc_object_putmember(context, object.data.object, key, value);
     return value;
 }
 
-eccvalue_t ecc_oper_callmember(ecccontext_t* context)
+static eccvalue_t ecc_oper_docallmember(ecccontext_t* context, int tail)
 {
     int32_t argcnt;
     eccvalue_t object;
+    eccvalue_t function;
     eccindexkey_t key;
+    eccopcache_t* cache;
     const eccstrbox_t* text;
     const eccstrbox_t* textcall;
     textcall = opmac_text(0);
     argcnt = opmac_value().data.integer;
+    cache = context->ops->cache;
     text = &(++context->ops)->text;
     key = opmac_value().data.key;
     ecc_oper_prepareobject(context, &object);
     ecc_context_settext(context, text);
-    return ecc_oper_callvalue(context, ecc_object_getmember(context, object.data.object, key), object, argcnt, 0, textcall);
+    if(cache)
+    {
+        function = ecc_object_getvalue(context, object.data.object, ecc_oper_cachedmember(cache, object.data.object, key));
+    }
+    else
+    {
+        function = ecc_object_getmember(context, object.data.object, key);
+    }
+    if(tail)
+    {
+        return ecc_oper_tailcallvalue(context, function, object, argcnt, textcall);
+    }
+    return ecc_oper_callvalue(context, function, object, argcnt, 0, textcall);
+}
+
+eccvalue_t ecc_oper_callmember(ecccontext_t* context)
+{
+    return ecc_oper_docallmember(context, 0);
+}
+
+eccvalue_t ecc_oper_tailcallmember(ecccontext_t* context)
+{
+    return ecc_oper_docallmember(context, 1);
 }
 
 eccvalue_t ecc_oper_deletemember(ecccontext_t* context)
@@ -1207,7 +1627,7 @@ eccvalue_t ecc_oper_setproperty(ecccontext_t* context)
     return value;
 }
 
-eccvalue_t ecc_oper_callproperty(ecccontext_t* context)
+static eccvalue_t ecc_oper_docallproperty(ecccontext_t* context, int tail)
 {
     int32_t argcnt;
     eccvalue_t object;
@@ -1220,9 +1640,23 @@ eccvalue_t ecc_oper_callproperty(ecccontext_t* context)
 
     ecc_oper_prepareobjectproperty(context, &object, &property);
     ecc_context_settext(context, text);
+    if(tail)
+    {
+        return ecc_oper_tailcallvalue(context, ecc_object_getproperty(context, object.data.object, property), object, argcnt, textcall);
+    }
     return ecc_oper_callvalue(context, ecc_object_getproperty(context, object.data.object, property), object, argcnt, 0, textcall);
 }
 
+eccvalue_t ecc_oper_callproperty(ecccontext_t* context)
+{
+    return ecc_oper_docallproperty(context, 0);
+}
+
+eccvalue_t ecc_oper_tailcallproperty(ecccontext_t* context)
+{
+    return ecc_oper_docallproperty(context, 1);
+}
+
 eccvalue_t ecc_oper_deleteproperty(ecccontext_t* context)
 {
     int result;
@@ -1495,16 +1929,120 @@ eccvalue_t ecc_oper_in(ecccontext_t* context)
     return ecc_value_truth(ref != NULL);
 }
 
+/*
+* int32 type feedback.
+* the generic add, minus, multiply, shift and bitwise operators count the times both of
+* their operands were int32 values (integers, or binaries holding one). the first pair that
+* is not makes the operand generic for good; after ECC_CONF_TYPEFEEDBACK int32 pairs,
+* it is rewritten to its int32 version, which deoptimizes back on the first operand
+* that is not an int32 or result that overflows.
+*/
+#define ECC_OPFEEDBACK_GENERIC 0x80
+
+static int ecc_oper_int32of(eccvalue_t value, int32_t* integer)
+{
+    if(value.type == ECC_VALTYPE_INTEGER)
+    {
+        *integer = value.data.integer;
+        return 1;
+    }
+    if(value.type == ECC_VALTYPE_BINARY && value.data.valnumfloat >= INT32_MIN && value.data.valnumfloat <= INT32_MAX)
+    {
+        *integer = (int32_t)value.data.valnumfloat;
+        return *integer == value.data.valnumfloat && (*integer || !signbit(value.data.valnumfloat));
+    }
+    return 0;
+}
+
+static void ecc_oper_feedback(const eccoperand_t* op, eccvalue_t a, eccvalue_t b, const eccnativefuncptr_t specialized)
+{
+    int32_t integer;
+    eccoperand_t* self;
+    self = (eccoperand_t*)op;
+    if(self->feedback & ECC_OPFEEDBACK_GENERIC)
+    {
+        return;
+    }
+    if(!ecc_oper_int32of(a, &integer) || !ecc_oper_int32of(b, &integer))
+    {
+        self->feedback = ECC_OPFEEDBACK_GENERIC;
+    }
+    else if(++self->feedback >= ECC_CONF_TYPEFEEDBACK)
+    {
+        self->native = specialized;
+    }
+}
+
+/* back to the generic operator, for good */
+void ecc_oper_deoptimize(const eccoperand_t* op)
+{
+    eccoperand_t* self;
+    self = (eccoperand_t*)op;
+    self->native = ecc_oper_generic(self->native);
+    self->feedback = ECC_OPFEEDBACK_GENERIC;
+}
+
+/* the generic operator of an int32 one or of a superinstruction, or 'native' itself */
+eccnativefuncptr_t ecc_oper_generic(const eccnativefuncptr_t native)
+{
+    if(ecc_oper_unfused(native) != native)
+        return ecc_oper_unfused(native);
+    else if(native == ecc_oper_addint)
+        return ecc_oper_add;
+    else if(native == ecc_oper_minusint)
+        return ecc_oper_minus;
+    else if(native == ecc_oper_multiplyint)
+        return ecc_oper_multiply;
+    else if(native == ecc_oper_leftshiftint)
+        return ecc_oper_leftshift;
+    else if(native == ecc_oper_rightshiftint)
+        return ecc_oper_rightshift;
+    else if(native == ecc_oper_unsignedrightshiftint)
+        return ecc_oper_unsignedrightshift;
+    else if(native == ecc_oper_bitwiseandint)
+        return ecc_oper_bitwiseand;
+    else if(native == ecc_oper_bitwisexorint)
+        return ecc_oper_bitwisexor;
+    else if(native == ecc_oper_bitwiseorint)
+        return ecc_oper_bitwiseor;
+    return native;
+}
+
+/* the generic minus, multiply, divide, shift or bitwise operator 'native' on evaluated operands */
+eccvalue_t ecc_oper_operatevalues(ecccontext_t* context, const eccnativefuncptr_t native, eccvalue_t a, eccvalue_t b)
+{
+    if(native == ecc_oper_minus)
+        return ecc_value_fromfloat(ecc_value_tobinary(context, a).data.valnumfloat - ecc_value_tobinary(context, b).data.valnumfloat);
+    else if(native == ecc_oper_multiply)
+        return ecc_value_fromfloat(ecc_value_tobinary(context, a).data.valnumfloat * ecc_value_tobinary(context, b).data.valnumfloat);
+    else if(native == ecc_oper_divide)
+        return ecc_value_fromfloat(ecc_value_tobinary(context, a).data.valnumfloat / ecc_value_tobinary(context, b).data.valnumfloat);
+    else if(native == ecc_oper_leftshift)
+        return ecc_value_fromfloat(ecc_value_tointeger(context, a).data.integer << (uint32_t)ecc_value_tointeger(context, b).data.integer);
+    else if(native == ecc_oper_rightshift)
+        return ecc_value_fromfloat(ecc_value_tointeger(context, a).data.integer >> (uint32_t)ecc_value_tointeger(context, b).data.integer);
+    else if(native == ecc_oper_unsignedrightshift)
+        return ecc_value_fromfloat((uint32_t)ecc_value_tointeger(context, a).data.integer >> (uint32_t)ecc_value_tointeger(context, b).data.integer);
+    else if(native == ecc_oper_bitwiseand)
+        return ecc_value_fromfloat(ecc_value_tointeger(context, a).data.integer & ecc_value_tointeger(context, b).data.integer);
+    else if(native == ecc_oper_bitwisexor)
+        return ecc_value_fromfloat(ecc_value_tointeger(context, a).data.integer ^ ecc_value_tointeger(context, b).data.integer);
+    assert(native == ecc_oper_bitwiseor);
+    return ecc_value_fromfloat(ecc_value_tointeger(context, a).data.integer | ecc_value_tointeger(context, b).data.integer);
+}
 eccvalue_t ecc_oper_add(ecccontext_t* context)
 {
     eccvalue_t a;
     eccvalue_t b;
+    const eccoperand_t* op;
     const eccstrbox_t* text;
     const eccstrbox_t* textalt;
+    op = context->ops;
     text = opmac_text(1);
     a = opmac_next();
     textalt = opmac_text(1);
     b = opmac_next();
+    ecc_oper_feedback(op, a, b, ecc_oper_addint);
     if(a.type == ECC_VALTYPE_BINARY && b.type == ECC_VALTYPE_BINARY)
     {
         a.data.valnumfloat += b.data.valnumfloat;
@@ -1518,8 +2056,11 @@ eccvalue_t ecc_oper_minus(ecccontext_t* context)
 {
     eccvalue_t a;
     eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
     a = opmac_next();
     b = opmac_next();
+    ecc_oper_feedback(op, a, b, ecc_oper_minusint);
     if(a.type == ECC_VALTYPE_BINARY && b.type == ECC_VALTYPE_BINARY)
     {
         a.data.valnumfloat -= b.data.valnumfloat;
@@ -1532,8 +2073,11 @@ eccvalue_t ecc_oper_multiply(ecccontext_t* context)
 {
     eccvalue_t a;
     eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
     a = opmac_next();
     b = opmac_next();
+    ecc_oper_feedback(op, a, b, ecc_oper_multiplyint);
     if(a.type == ECC_VALTYPE_BINARY && b.type == ECC_VALTYPE_BINARY)
     {
         a.data.valnumfloat *= b.data.valnumfloat;
@@ -1574,8 +2118,11 @@ eccvalue_t ecc_oper_leftshift(ecccontext_t* context)
 {
     eccvalue_t a;
     eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
     a = opmac_next();
     b = opmac_next();
+    ecc_oper_feedback(op, a, b, ecc_oper_leftshiftint);
     return ecc_value_fromfloat(ecc_value_tointeger(context, a).data.integer << (uint32_t)ecc_value_tointeger(context, b).data.integer);
 }
 
@@ -1583,8 +2130,11 @@ eccvalue_t ecc_oper_rightshift(ecccontext_t* context)
 {
     eccvalue_t a;
     eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
     a = opmac_next();
     b = opmac_next();
+    ecc_oper_feedback(op, a, b, ecc_oper_rightshiftint);
     return ecc_value_fromfloat(ecc_value_tointeger(context, a).data.integer >> (uint32_t)ecc_value_tointeger(context, b).data.integer);
 }
 
@@ -1592,8 +2142,11 @@ eccvalue_t ecc_oper_unsignedrightshift(ecccontext_t* context)
 {
     eccvalue_t a;
     eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
     a = opmac_next();
     b = opmac_next();
+    ecc_oper_feedback(op, a, b, ecc_oper_unsignedrightshiftint);
     return ecc_value_fromfloat((uint32_t)ecc_value_tointeger(context, a).data.integer >> (uint32_t)ecc_value_tointeger(context, b).data.integer);
 }
 
@@ -1601,8 +2154,11 @@ eccvalue_t ecc_oper_bitwiseand(ecccontext_t* context)
 {
     eccvalue_t a;
     eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
     a = opmac_next();
     b = opmac_next();
+    ecc_oper_feedback(op, a, b, ecc_oper_bitwiseandint);
     return ecc_value_fromfloat(ecc_value_tointeger(context, a).data.integer & ecc_value_tointeger(context, b).data.integer);
 }
 
@@ -1610,8 +2166,11 @@ eccvalue_t ecc_oper_bitwisexor(ecccontext_t* context)
 {
     eccvalue_t a;
     eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
     a = opmac_next();
     b = opmac_next();
+    ecc_oper_feedback(op, a, b, ecc_oper_bitwisexorint);
     return ecc_value_fromfloat(ecc_value_tointeger(context, a).data.integer ^ ecc_value_tointeger(context, b).data.integer);
 }
 
@@ -1619,34 +2178,515 @@ eccvalue_t ecc_oper_bitwiseor(ecccontext_t* context)
 {
     eccvalue_t a;
     eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
     a = opmac_next();
     b = opmac_next();
+    ecc_oper_feedback(op, a, b, ecc_oper_bitwiseorint);
     return ecc_value_fromfloat(ecc_value_tointeger(context, a).data.integer | ecc_value_tointeger(context, b).data.integer);
 }
 
-eccvalue_t ecc_oper_logicaland(ecccontext_t* context)
+eccvalue_t ecc_oper_addint(ecccontext_t* context)
 {
-    int32_t opcount;
-    eccvalue_t value;
-    opcount = opmac_value().data.integer;
-    value = opmac_next();
-    if(!ecc_value_istrue(value))
+    int32_t x;
+    int32_t y;
+    int64_t result;
+    eccvalue_t a;
+    eccvalue_t b;
+    const eccoperand_t* op;
+    const eccstrbox_t* text;
+    const eccstrbox_t* textalt;
+    op = context->ops;
+    text = opmac_text(1);
+    a = opmac_next();
+    textalt = opmac_text(1);
+    b = opmac_next();
+    if(ecc_oper_int32of(a, &x) && ecc_oper_int32of(b, &y))
     {
-        context->ops += opcount;
-        return value;
+        result = (int64_t)x + y;
+        if(result >= INT32_MIN && result <= INT32_MAX)
+        {
+            return ecc_value_fromint((int32_t)result);
+        }
     }
-    return opmac_next();
+    ecc_oper_deoptimize(op);
+    ecc_context_settexts(context, text, textalt);
+    return ecc_value_add(context, a, b);
 }
 
-eccvalue_t ecc_oper_logicalor(ecccontext_t* context)
+eccvalue_t ecc_oper_minusint(ecccontext_t* context)
 {
-    int32_t opcount;
-    eccvalue_t value;
-    opcount = opmac_value().data.integer;
-    value = opmac_next();
-    if(ecc_value_istrue(value))
+    int32_t x;
+    int32_t y;
+    int64_t result;
+    eccvalue_t a;
+    eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
+    a = opmac_next();
+    b = opmac_next();
+    if(ecc_oper_int32of(a, &x) && ecc_oper_int32of(b, &y))
+    {
+        result = (int64_t)x - y;
+        if(result >= INT32_MIN && result <= INT32_MAX)
+        {
+            return ecc_value_fromint((int32_t)result);
+        }
+    }
+    ecc_oper_deoptimize(op);
+    return ecc_oper_operatevalues(context, ecc_oper_minus, a, b);
+}
+
+eccvalue_t ecc_oper_multiplyint(ecccontext_t* context)
+{
+    int32_t x;
+    int32_t y;
+    int64_t result;
+    eccvalue_t a;
+    eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
+    a = opmac_next();
+    b = opmac_next();
+    if(ecc_oper_int32of(a, &x) && ecc_oper_int32of(b, &y))
+    {
+        result = (int64_t)x * y;
+        /* a zero with a negative operand is -0 */
+        if(result >= INT32_MIN && result <= INT32_MAX && (result || (x >= 0 && y >= 0)))
+        {
+            return ecc_value_fromint((int32_t)result);
+        }
+    }
+    ecc_oper_deoptimize(op);
+    return ecc_oper_operatevalues(context, ecc_oper_multiply, a, b);
+}
+
+eccvalue_t ecc_oper_leftshiftint(ecccontext_t* context)
+{
+    int32_t x;
+    int32_t y;
+    eccvalue_t a;
+    eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
+    a = opmac_next();
+    b = opmac_next();
+    if(ecc_oper_int32of(a, &x) && ecc_oper_int32of(b, &y))
+    {
+        return ecc_value_fromint((int32_t)((uint32_t)x << (y & 31)));
+    }
+    ecc_oper_deoptimize(op);
+    return ecc_oper_operatevalues(context, ecc_oper_leftshift, a, b);
+}
+
+eccvalue_t ecc_oper_rightshiftint(ecccontext_t* context)
+{
+    int32_t x;
+    int32_t y;
+    eccvalue_t a;
+    eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
+    a = opmac_next();
+    b = opmac_next();
+    if(ecc_oper_int32of(a, &x) && ecc_oper_int32of(b, &y))
+    {
+        return ecc_value_fromint(x >> (y & 31));
+    }
+    ecc_oper_deoptimize(op);
+    return ecc_oper_operatevalues(context, ecc_oper_rightshift, a, b);
+}
+
+eccvalue_t ecc_oper_unsignedrightshiftint(ecccontext_t* context)
+{
+    int32_t x;
+    int32_t y;
+    uint32_t result;
+    eccvalue_t a;
+    eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
+    a = opmac_next();
+    b = opmac_next();
+    if(ecc_oper_int32of(a, &x) && ecc_oper_int32of(b, &y))
+    {
+        result = (uint32_t)x >> (y & 31);
+        /* not a deoptimization: the result is a number either way */
+        return result <= INT32_MAX ? ecc_value_fromint((int32_t)result) : ecc_value_fromfloat(result);
+    }
+    ecc_oper_deoptimize(op);
+    return ecc_oper_operatevalues(context, ecc_oper_unsignedrightshift, a, b);
+}
+
+eccvalue_t ecc_oper_bitwiseandint(ecccontext_t* context)
+{
+    int32_t x;
+    int32_t y;
+    eccvalue_t a;
+    eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
+    a = opmac_next();
+    b = opmac_next();
+    if(ecc_oper_int32of(a, &x) && ecc_oper_int32of(b, &y))
+    {
+        return ecc_value_fromint(x & y);
+    }
+    ecc_oper_deoptimize(op);
+    return ecc_oper_operatevalues(context, ecc_oper_bitwiseand, a, b);
+}
+
+eccvalue_t ecc_oper_bitwisexorint(ecccontext_t* context)
+{
+    int32_t x;
+    int32_t y;
+    eccvalue_t a;
+    eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
+    a = opmac_next();
+    b = opmac_next();
+    if(ecc_oper_int32of(a, &x) && ecc_oper_int32of(b, &y))
+    {
+        return ecc_value_fromint(x ^ y);
+    }
+    ecc_oper_deoptimize(op);
+    return ecc_oper_operatevalues(context, ecc_oper_bitwisexor, a, b);
+}
+
+eccvalue_t ecc_oper_bitwiseorint(ecccontext_t* context)
+{
+    int32_t x;
+    int32_t y;
+    eccvalue_t a;
+    eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
+    a = opmac_next();
+    b = opmac_next();
+    if(ecc_oper_int32of(a, &x) && ecc_oper_int32of(b, &y))
+    {
+        return ecc_value_fromint(x | y);
+    }
+    ecc_oper_deoptimize(op);
+    return ecc_oper_operatevalues(context, ecc_oper_bitwiseor, a, b);
+}
+
+/*
+* superinstructions, see ecc_oplist_fuse.
+* a fused operand reads its constant and slot operands in place instead of calling them,
+* and leaves context->ops on its last operand as the calls would have; the operands stay
+* in the list, so offsets, texts and the jit see the same tree as before.
+*/
+#if ECC_CONF_FUSIONCOUNT
+    #define opmac_fused(count) (context->ecc->fusedDispatches += (count))
+#else
+    #define opmac_fused(count)
+#endif
+
+/* the value of a getlocalslot, getparentslot or value operand */
+static eccvalue_t ecc_oper_leaf(ecccontext_t* context, const eccoperand_t* op)
+{
+    int32_t count;
+    eccobject_t* object;
+    if(op->native == ecc_oper_getlocalslot)
+    {
+        return context->execenv->hmapmapitems[op->opvalue.data.integer].hmapmapvalue;
+    }
+    else if(op->native == ecc_oper_value)
+    {
+        return op->opvalue;
+    }
+    object = context->execenv;
+    for(count = op->opvalue.data.integer >> 16; count--;)
+    {
+        object = object->prototype;
+    }
+    return object->hmapmapitems[op->opvalue.data.integer & 0xffff].hmapmapvalue;
+}
+
+/* the fused add at context->ops */
+static eccvalue_t ecc_oper_addleaves(ecccontext_t* context)
+{
+    int64_t result;
+    eccvalue_t a;
+    eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
+    a = ecc_oper_leaf(context, op + 1);
+    b = ecc_oper_leaf(context, op + 2);
+    context->ops = op + 2;
+    opmac_fused(2);
+    if(a.type == ECC_VALTYPE_BINARY && b.type == ECC_VALTYPE_BINARY)
+    {
+        a.data.valnumfloat += b.data.valnumfloat;
+        return a;
+    }
+    else if(a.type == ECC_VALTYPE_INTEGER && b.type == ECC_VALTYPE_INTEGER)
+    {
+        result = (int64_t)a.data.integer + b.data.integer;
+        if(result >= INT32_MIN && result <= INT32_MAX)
+        {
+            return ecc_value_fromint((int32_t)result);
+        }
+        return ecc_value_fromfloat((double)result);
+    }
+    ecc_context_settexts(context, &op[1].text, &op[2].text);
+    return ecc_value_add(context, a, b);
+}
+
+/* the truth of the fused comparison at context->ops */
+static int ecc_oper_testleaves(ecccontext_t* context)
+{
+    eccvalue_t a;
+    eccvalue_t b;
+    eccvalue_t result;
+    const eccoperand_t* op;
+    op = context->ops;
+    a = ecc_oper_leaf(context, op + 1);
+    b = ecc_oper_leaf(context, op + 2);
+    context->ops = op + 2;
+    opmac_fused(2);
+    if(a.type == ECC_VALTYPE_BINARY && b.type == ECC_VALTYPE_BINARY)
+    {
+        if(op->native == ecc_oper_lessfused)
+            return a.data.valnumfloat < b.data.valnumfloat;
+        else if(op->native == ecc_oper_lessorequalfused)
+            return a.data.valnumfloat <= b.data.valnumfloat;
+        else if(op->native == ecc_oper_morefused)
+            return a.data.valnumfloat > b.data.valnumfloat;
+        return a.data.valnumfloat >= b.data.valnumfloat;
+    }
+    else if(a.type == ECC_VALTYPE_INTEGER && b.type == ECC_VALTYPE_INTEGER)
+    {
+        if(op->native == ecc_oper_lessfused)
+            return a.data.integer < b.data.integer;
+        else if(op->native == ecc_oper_lessorequalfused)
+            return a.data.integer <= b.data.integer;
+        else if(op->native == ecc_oper_morefused)
+            return a.data.integer > b.data.integer;
+        return a.data.integer >= b.data.integer;
+    }
+    ecc_context_settexts(context, &op[1].text, &op[2].text);
+    if(op->native == ecc_oper_lessfused)
+        result = ecc_value_less(context, a, b);
+    else if(op->native == ecc_oper_lessorequalfused)
+        result = ecc_value_lessorequal(context, a, b);
+    else if(op->native == ecc_oper_morefused)
+        result = ecc_value_more(context, a, b);
+    else
+        result = ecc_value_moreorequal(context, a, b);
+    return ecc_value_istrue(result);
+}
+
+eccvalue_t ecc_oper_addfused(ecccontext_t* context)
+{
+    return ecc_oper_addleaves(context);
+}
+
+eccvalue_t ecc_oper_minusfused(ecccontext_t* context)
+{
+    eccvalue_t a;
+    eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
+    a = ecc_oper_leaf(context, op + 1);
+    b = ecc_oper_leaf(context, op + 2);
+    context->ops = op + 2;
+    opmac_fused(2);
+    if(a.type == ECC_VALTYPE_BINARY && b.type == ECC_VALTYPE_BINARY)
+    {
+        a.data.valnumfloat -= b.data.valnumfloat;
+        return a;
+    }
+    return ecc_oper_operatevalues(context, ecc_oper_minus, a, b);
+}
+
+eccvalue_t ecc_oper_multiplyfused(ecccontext_t* context)
+{
+    eccvalue_t a;
+    eccvalue_t b;
+    const eccoperand_t* op;
+    op = context->ops;
+    a = ecc_oper_leaf(context, op + 1);
+    b = ecc_oper_leaf(context, op + 2);
+    context->ops = op + 2;
+    opmac_fused(2);
+    if(a.type == ECC_VALTYPE_BINARY && b.type == ECC_VALTYPE_BINARY)
+    {
+        a.data.valnumfloat *= b.data.valnumfloat;
+        return a;
+    }
+    return ecc_oper_operatevalues(context, ecc_oper_multiply, a, b);
+}
+
+eccvalue_t ecc_oper_lessfused(ecccontext_t* context)
+{
+    return ecc_value_truth(ecc_oper_testleaves(context));
+}
+
+eccvalue_t ecc_oper_lessorequalfused(ecccontext_t* context)
+{
+    return ecc_value_truth(ecc_oper_testleaves(context));
+}
+
+eccvalue_t ecc_oper_morefused(ecccontext_t* context)
+{
+    return ecc_value_truth(ecc_oper_testleaves(context));
+}
+
+eccvalue_t ecc_oper_moreorequalfused(ecccontext_t* context)
+{
+    return ecc_value_truth(ecc_oper_testleaves(context));
+}
+
+/* x = y + z, with a fused add */
+eccvalue_t ecc_oper_setlocalslotadd(ecccontext_t* context)
+{
+    int32_t slot;
+    eccvalue_t value;
+    eccvalue_t* ref;
+    slot = opmac_value().data.integer;
+    ++context->ops;
+    opmac_fused(1);
+    value = ecc_oper_addleaves(context);
+    ref = &context->execenv->hmapmapitems[slot].hmapmapvalue;
+    if(ref->flags & ECC_VALFLAG_READONLY)
     {
-        context->ops += opcount;
+        return value;
+    }
+    ecc_mempool_writebarrier(context->execenv, value);
+    ecc_oper_retain(value);
+    ecc_oper_release(*ref);
+    ecc_oper_replacerefvalue(ref, value);
+    return value;
+}
+
+eccvalue_t ecc_oper_setparentslotadd(ecccontext_t* context)
+{
+    int32_t count;
+    eccvalue_t value;
+    eccvalue_t* ref;
+    eccobject_t* object;
+    const eccstrbox_t* text;
+    text = opmac_text(0);
+    count = opmac_value().data.integer >> 16;
+    object = context->execenv;
+    while(count--)
+    {
+        object = object->prototype;
+    }
+    ref = &object->hmapmapitems[opmac_value().data.integer & 0xffff].hmapmapvalue;
+    ++context->ops;
+    opmac_fused(1);
+    value = ecc_oper_addleaves(context);
+    if(ref->flags & ECC_VALFLAG_READONLY)
+    {
+        if(context->isstrictmode)
+        {
+            eccstrbox_t property = *ecc_keyidx_textof(ref->key);
+            ecc_context_settext(context, text);
+            ecc_context_typeerror(context, ecc_strbuf_create("'%.*s' is read-only", property.length, property.bytes));
+        }
+        return value;
+    }
+    ecc_mempool_writebarrier(object, value);
+    ecc_oper_retain(value);
+    ecc_oper_release(*ref);
+    ecc_oper_replacerefvalue(ref, value);
+    return value;
+}
+
+/* getmember on a slot */
+eccvalue_t ecc_oper_getmemberslot(ecccontext_t* context)
+{
+    eccvalue_t object;
+    eccindexkey_t key;
+    eccopcache_t* cache;
+    const eccoperand_t* op;
+    op = context->ops;
+    key = op->opvalue.data.key;
+    cache = op->cache;
+    object = ecc_oper_leaf(context, op + 1);
+    context->ops = op + 1;
+    opmac_fused(1);
+    if(ecc_value_isprimitive(object))
+    {
+        ecc_context_settext(context, &op[1].text);
+        object = ecc_value_toobject(context, object);
+    }
+    if(cache)
+    {
+        return ecc_object_getvalue(context, object.data.object, ecc_oper_cachedmember(cache, object.data.object, key));
+    }
+    return ecc_object_getmember(context, object.data.object, key);
+}
+
+/* jumpifnot on a fused comparison; ecc_oper_dispatch runs it inline */
+eccvalue_t ecc_oper_jumpifnotcompare(ecccontext_t* context)
+{
+    int32_t offset;
+    offset = opmac_value().data.integer;
+    ++context->ops;
+    opmac_fused(1);
+    if(!ecc_oper_testleaves(context))
+    {
+        context->ops += offset;
+    }
+    return opmac_next();
+}
+
+/* the operator a superinstruction stands for, or 'native' itself */
+eccnativefuncptr_t ecc_oper_unfused(const eccnativefuncptr_t native)
+{
+    if(native == ecc_oper_addfused)
+        return ecc_oper_add;
+    else if(native == ecc_oper_minusfused)
+        return ecc_oper_minus;
+    else if(native == ecc_oper_multiplyfused)
+        return ecc_oper_multiply;
+    else if(native == ecc_oper_lessfused)
+        return ecc_oper_less;
+    else if(native == ecc_oper_lessorequalfused)
+        return ecc_oper_lessorequal;
+    else if(native == ecc_oper_morefused)
+        return ecc_oper_more;
+    else if(native == ecc_oper_moreorequalfused)
+        return ecc_oper_moreorequal;
+    else if(native == ecc_oper_setlocalslotadd)
+        return ecc_oper_setlocalslot;
+    else if(native == ecc_oper_setparentslotadd)
+        return ecc_oper_setparentslot;
+    else if(native == ecc_oper_getmemberslot)
+        return ecc_oper_getmember;
+    else if(native == ecc_oper_jumpifnotcompare)
+        return ecc_oper_jumpifnot;
+    return native;
+}
+
+eccvalue_t ecc_oper_logicaland(ecccontext_t* context)
+{
+    int32_t opcount;
+    eccvalue_t value;
+    opcount = opmac_value().data.integer;
+    value = opmac_next();
+    if(!ecc_value_istrue(value))
+    {
+        context->ops += opcount;
+        return value;
+    }
+    return opmac_next();
+}
+
+eccvalue_t ecc_oper_logicalor(ecccontext_t* context)
+{
+    int32_t opcount;
+    eccvalue_t value;
+    opcount = opmac_value().data.integer;
+    value = opmac_next();
+    if(ecc_value_istrue(value))
+    {
+        context->ops += opcount;
         return value;
     }
     return opmac_next();
@@ -1851,6 +2891,7 @@ eccvalue_t ecc_oper_try(ecccontext_t* context)
 {
     int rethrow;
     int breaker;
+    int canyield;
     uint32_t indices[3];
     eccvalue_t value;
     eccvalue_t finallyval;
@@ -1859,6 +2900,7 @@ eccvalue_t ecc_oper_try(ecccontext_t* context)
     eccindexkey_t key;
     const eccoperand_t* end;
     const eccoperand_t*  rethrowops;
+    opmac_takeyield(canyield);
     environment = context->execenv;
     refo = context->refobject;
     end = context->ops + opmac_value().data.integer;
@@ -1870,7 +2912,7 @@ eccvalue_t ecc_oper_try(ecccontext_t* context)
     /* try */
     if(!setjmp(*ecc_script_pushenv(context->ecc)))
     {
-        value = opmac_next();
+        value = opmac_nextstatement();
     }
     else
     {
@@ -1896,7 +2938,7 @@ eccvalue_t ecc_oper_try(ecccontext_t* context)
                 }
                 ecc_object_addmember(context->execenv, key, value, ECC_VALFLAG_SEALED);
                 /* execute until noop */
-                value = opmac_next();
+                value = opmac_nextstatement();
                 rethrow = 0;
                 if(context->breaker)
                 {
@@ -1916,7 +2958,7 @@ eccvalue_t ecc_oper_try(ecccontext_t* context)
     /* op[end] = ecc_oper_jump, to after catch */
     context->ops = end;
     /* jump to after catch, and execute until noop */
-    finallyval = opmac_next();
+    finallyval = opmac_nextstatement();
     /* return breaker */
     if(context->breaker)
     {
@@ -1932,7 +2974,7 @@ eccvalue_t ecc_oper_try(ecccontext_t* context)
         context->breaker = breaker;
         return value;
     }
-    return opmac_next();
+    return opmac_yield(canyield);
 }
 
 eccvalue_t ecc_oper_throw(ecccontext_t * context)
@@ -1944,10 +2986,12 @@ eccvalue_t ecc_oper_throw(ecccontext_t * context)
 
 eccvalue_t ecc_oper_with(ecccontext_t* context)
 {
+    int canyield;
     eccvalue_t value;
     eccobject_t* refo;
     eccobject_t* object;
     eccobject_t* environment;
+    opmac_takeyield(canyield);
     environment = context->execenv;
     refo = context->refobject;
     object = ecc_value_toobject(context, opmac_next()).data.object;
@@ -1956,14 +3000,14 @@ eccvalue_t ecc_oper_with(ecccontext_t* context)
         context->refobject = context->execenv;
     }
     context->execenv = object;
-    value = opmac_next();
+    value = opmac_nextstatement();
     context->execenv = environment;
     context->refobject = refo;
     if(context->breaker)
     {
         return value;
     }
-    return opmac_next();
+    return opmac_yield(canyield);
 }
 
 eccvalue_t ecc_oper_next(ecccontext_t* context)
@@ -2150,6 +3194,12 @@ eccvalue_t ecc_oper_result(ecccontext_t* context)
 }
 
 eccvalue_t ecc_oper_repopulate(ecccontext_t* context)
+{
+    ecc_oper_repopulateframe(context);
+    return opmac_next();
+}
+
+void ecc_oper_repopulateframe(ecccontext_t* context)
 {
     size_t hmsz;
     int32_t offset;
@@ -2164,21 +3214,19 @@ eccvalue_t ecc_oper_repopulate(ecccontext_t* context)
     hmsz = context->execenv->hmapmapcapacity;
     ecchashmap_t hashmap[context->execenv->hmapmapcapacity];
     count = arguments <= context->execenv->hmapmapcapacity ? arguments : context->execenv->hmapmapcapacity;
-    for(index = 0; index < 3; ++index)
-    {
-        hashmap[index].hmapmapvalue = context->execenv->hmapmapitems[index].hmapmapvalue;
-    }
-    for(; index < count; ++index)
+    /* the parameters keep their keys and flags, only the values are replaced */
+    memcpy(hashmap, context->execenv->hmapmapitems, hmsz * sizeof(ecchashmap_t));
+    for(index = 3; index < count; ++index)
     {
         ecc_oper_release(context->execenv->hmapmapitems[index].hmapmapvalue);
-        hashmap[index].hmapmapvalue = ecc_oper_retain(opmac_next());
+        ecc_object_setvalue(context->execenv, &hashmap[index].hmapmapvalue, ecc_oper_retain(opmac_next()));
     }
     if(index < context->execenv->hmapmapcapacity)
     {
         for(; index < context->execenv->hmapmapcapacity; ++index)
         {
             ecc_oper_release(context->execenv->hmapmapitems[index].hmapmapvalue);
-            hashmap[index].hmapmapvalue = ECCValConstNone;
+            ecc_object_setvalue(context->execenv, &hashmap[index].hmapmapvalue, ECCValConstNone);
         }
     }
     else
@@ -2193,12 +3241,12 @@ eccvalue_t ecc_oper_repopulate(ecccontext_t* context)
         argvals = context->execenv->hmapmapitems[2].hmapmapvalue.data.object;
         for(index = 3; index < context->execenv->hmapmapcapacity; ++index)
         {
+            ecc_mempool_writebarrier(argvals, hashmap[index].hmapmapvalue);
             argvals->hmapitemitems[index - 3].hmapitemvalue = hashmap[index].hmapmapvalue;
         }
     }
     memcpy(context->execenv->hmapmapitems, hashmap, hmsz * sizeof(ecchashmap_t));
     context->ops = nextops;
-    return opmac_next();
 }
 
 eccvalue_t ecc_oper_resultvoid(ecccontext_t* context)
@@ -2211,12 +3259,14 @@ eccvalue_t ecc_oper_resultvoid(ecccontext_t* context)
 
 eccvalue_t ecc_oper_switchop(ecccontext_t* context)
 {
+    int canyield;
     int32_t offset;
     const eccoperand_t* nextops;
     eccvalue_t value;
     eccvalue_t caseval;
     const eccstrbox_t* text;
     const eccstrbox_t* textalt;
+    opmac_takeyield(canyield);
     offset = opmac_value().data.integer;
     nextops = context->ops + offset;
     text = opmac_text(1);
@@ -2237,7 +3287,7 @@ eccvalue_t ecc_oper_switchop(ecccontext_t* context)
             ++context->ops;
         }
     }
-    value = opmac_next();
+    value = opmac_nextstatement();
     if(context->breaker && --context->breaker)
     {
         return value;
@@ -2245,7 +3295,7 @@ eccvalue_t ecc_oper_switchop(ecccontext_t* context)
     else
     {
         context->ops = nextops + 2 + nextops[2].opvalue.data.integer;
-        return opmac_next();
+        return opmac_yield(canyield);
     }
 }
 
@@ -2253,7 +3303,7 @@ eccvalue_t ecc_oper_switchop(ecccontext_t* context)
     { \
         uint32_t indices[3]; \
         ecc_mempool_getindices(indices); \
-        value = opmac_next(); \
+        value = opmac_nextstatement(); \
         if(context->breaker && --context->breaker) \
         { \
             /* return breaker */ \
@@ -2269,6 +3319,11 @@ eccvalue_t ecc_oper_switchop(ecccontext_t* context)
         else \
         { \
             ecc_mempool_collectunreferencedfromindices(indices); \
+            /* safe point for automatic collections */ \
+            if(ecc_mempool_collectpending()) \
+            { \
+                ecc_script_autocollect(context->ecc); \
+            } \
             context->ops = nextops; \
         } \
     }
@@ -2281,11 +3336,13 @@ eccvalue_t ecc_oper_breaker(ecccontext_t* context)
 
 eccvalue_t ecc_oper_iterate(ecccontext_t* context)
 {
+    int canyield;
     int32_t skipop;
     eccvalue_t value;
     const eccoperand_t* startops;
     const eccoperand_t* endops;
     const eccoperand_t* nextops;
+    opmac_takeyield(canyield);
     startops = context->ops;
     endops = startops;
     nextops = startops + 1;
@@ -2296,11 +3353,12 @@ eccvalue_t ecc_oper_iterate(ecccontext_t* context)
         mac_stepiteration(value, nextops, { break; });
     }
     context->ops = endops;
-    return opmac_next();
+    return opmac_yield(canyield);
 }
 
 eccvalue_t ecc_oper_iterintref(ecccontext_t *context, eccopfncmpint_t cmpint, eccopfnwontover_t wof, eccopfncmpval_t cmpval, eccopfnstep_t valstep)
 {
+    int canyield;
     int32_t step;
     eccvalue_t value;
     eccvalue_t intval;
@@ -2310,6 +3368,7 @@ eccvalue_t ecc_oper_iterintref(ecccontext_t *context, eccopfncmpint_t cmpint, ec
     eccobject_t* refo;
     const eccoperand_t* endops;
     const eccoperand_t* nextops;
+    opmac_takeyield(canyield);
     refo = context->refobject;
     endops = context->ops + opmac_value().data.integer;
     stepval = opmac_next();
@@ -2356,7 +3415,7 @@ done:
         context->refobject = refo;
         context->ops = endops;
     }
-    return opmac_next();
+    return opmac_yield(canyield);
 }
 
 eccvalue_t ecc_oper_iteratelessref(ecccontext_t* context)
@@ -2381,6 +3440,7 @@ eccvalue_t ecc_oper_iteratemoreorequalref(ecccontext_t* context)
 
 eccvalue_t ecc_oper_iterateinref(ecccontext_t* context)
 {
+    int canyield;
     uint32_t index;
     uint32_t count;
     eccvalue_t key;
@@ -2393,6 +3453,7 @@ eccvalue_t ecc_oper_iterateinref(ecccontext_t* context)
     ecchashitem_t* element;
     const eccoperand_t* startops;
     const eccoperand_t* endops;
+    opmac_takeyield(canyield);
     refo = context->refobject;
     ref = opmac_next().data.reference;
     target = opmac_next();
@@ -2447,5 +3508,258 @@ eccvalue_t ecc_oper_iterateinref(ecccontext_t* context)
     }
     context->refobject = refo;
     context->ops = endops;
-    return opmac_next();
+    return opmac_yield(canyield);
+}
+
+uint8_t ecc_oper_opcodeof(const eccnativefuncptr_t native)
+{
+    const struct
+    {
+        eccnativefuncptr_t native;
+        eccopcode_t opcode;
+    } opcodelist[] = {
+        { ecc_oper_noop, ECC_OPCODE_NOOP },
+        { ecc_oper_next, ECC_OPCODE_NEXT },
+        { ecc_oper_nextif, ECC_OPCODE_NEXTIF },
+        { ecc_oper_expression, ECC_OPCODE_EXPRESSION },
+        { ecc_oper_discard, ECC_OPCODE_DISCARD },
+        { ecc_oper_discardn, ECC_OPCODE_DISCARDN },
+        { ecc_oper_autoreleaseexpression, ECC_OPCODE_AUTORELEASEEXPRESSION },
+        { ecc_oper_autoreleasediscard, ECC_OPCODE_AUTORELEASEDISCARD },
+        { ecc_oper_jump, ECC_OPCODE_JUMP },
+        { ecc_oper_jumpif, ECC_OPCODE_JUMPIF },
+        { ecc_oper_jumpifnot, ECC_OPCODE_JUMPIFNOT },
+        { ecc_oper_jumpifnotcompare, ECC_OPCODE_JUMPIFNOTCOMPARE },
+        { ecc_oper_result, ECC_OPCODE_RESULT },
+        { ecc_oper_resultvoid, ECC_OPCODE_RESULTVOID },
+        { ecc_oper_repopulate, ECC_OPCODE_REPOPULATE },
+        { ecc_oper_breaker, ECC_OPCODE_BREAKER },
+        { ecc_oper_try, ECC_OPCODE_STATEMENT },
+        { ecc_oper_with, ECC_OPCODE_STATEMENT },
+        { ecc_oper_switchop, ECC_OPCODE_STATEMENT },
+        { ecc_oper_iterate, ECC_OPCODE_STATEMENT },
+        { ecc_oper_iteratelessref, ECC_OPCODE_STATEMENT },
+        { ecc_oper_iteratelessorequalref, ECC_OPCODE_STATEMENT },
+        { ecc_oper_iteratemoreref, ECC_OPCODE_STATEMENT },
+        { ecc_oper_iteratemoreorequalref, ECC_OPCODE_STATEMENT },
+        { ecc_oper_iterateinref, ECC_OPCODE_STATEMENT },
+    };
+    size_t index;
+    for(index = 0; index < sizeof(opcodelist) / sizeof(*opcodelist); ++index)
+    {
+        if(opcodelist[index].native == native)
+        {
+            return opcodelist[index].opcode;
+        }
+    }
+    return ECC_OPCODE_NATIVE;
+}
+
+/*
+* flat dispatch for statement chains.
+* the control-flow ops that would otherwise tail-call the next operand are
+* executed inline, so a statement list runs in a single C frame.
+* anything not listed falls back to operand->native, which is always correct;
+* expression operands are still evaluated by threading, as before.
+*/
+eccvalue_t ecc_oper_dispatch(ecccontext_t* context)
+{
+    int32_t offset;
+    int32_t count;
+    uint32_t indices[3];
+    eccvalue_t value;
+#if ECC_CONF_JIT
+    eccoperand_t* entry;
+    /* chains entered often enough run as machine code */
+    if(context->ecc->jit)
+    {
+        entry = (eccoperand_t*)context->ops;
+        if(entry->jitcode)
+        {
+            return entry->jitcode(context);
+        }
+        if(entry->jitcount < ECC_CONF_JITTHRESHOLD && ++entry->jitcount == ECC_CONF_JITTHRESHOLD && ecc_jit_compile(entry))
+        {
+            return entry->jitcode(context);
+        }
+    }
+#endif
+#if defined(__GNUC__)
+    static const void* const labels[ECC_OPCODE_COUNT] = {
+        [ECC_OPCODE_NATIVE] = &&op_NATIVE,
+        [ECC_OPCODE_NOOP] = &&op_NOOP,
+        [ECC_OPCODE_NEXT] = &&op_NEXT,
+        [ECC_OPCODE_NEXTIF] = &&op_NEXTIF,
+        [ECC_OPCODE_EXPRESSION] = &&op_EXPRESSION,
+        [ECC_OPCODE_DISCARD] = &&op_DISCARD,
+        [ECC_OPCODE_DISCARDN] = &&op_DISCARDN,
+        [ECC_OPCODE_AUTORELEASEEXPRESSION] = &&op_AUTORELEASEEXPRESSION,
+        [ECC_OPCODE_AUTORELEASEDISCARD] = &&op_AUTORELEASEDISCARD,
+        [ECC_OPCODE_JUMP] = &&op_JUMP,
+        [ECC_OPCODE_JUMPIF] = &&op_JUMPIF,
+        [ECC_OPCODE_JUMPIFNOT] = &&op_JUMPIFNOT,
+        [ECC_OPCODE_JUMPIFNOTCOMPARE] = &&op_JUMPIFNOTCOMPARE,
+        [ECC_OPCODE_RESULT] = &&op_RESULT,
+        [ECC_OPCODE_RESULTVOID] = &&op_RESULTVOID,
+        [ECC_OPCODE_REPOPULATE] = &&op_NATIVE,
+        [ECC_OPCODE_BREAKER] = &&op_BREAKER,
+        [ECC_OPCODE_STATEMENT] = &&op_STATEMENT,
+    };
+    #define opmac_dispatch() goto *labels[context->ops->opcode]
+    #define opmac_case(NAME) op_##NAME
+    opmac_dispatch();
+#else
+    #define opmac_dispatch() continue
+    #define opmac_case(NAME) case ECC_OPCODE_##NAME
+    for(;;)
+    {
+        switch(context->ops->opcode)
+        {
+            default:
+#endif
+    opmac_case(NATIVE):
+        {
+            return context->ops->native(context);
+        }
+    opmac_case(NOOP):
+        {
+            return ECCValConstUndefined;
+        }
+    opmac_case(NEXT):
+        {
+            ++context->ops;
+            opmac_dispatch();
+        }
+    opmac_case(NEXTIF):
+        {
+            value = opmac_value();
+            if(!ecc_value_istrue(ecc_oper_trapop(context, 1)))
+            {
+                return value;
+            }
+            ++context->ops;
+            opmac_dispatch();
+        }
+    opmac_case(EXPRESSION):
+        {
+            ecc_oper_release(context->ecc->result);
+            context->ecc->result = ecc_oper_retain(ecc_oper_trapop(context, 1));
+            ++context->ops;
+            opmac_dispatch();
+        }
+    opmac_case(DISCARD):
+        {
+            ecc_oper_trapop(context, 1);
+            ++context->ops;
+            opmac_dispatch();
+        }
+    opmac_case(DISCARDN):
+        {
+            count = opmac_value().data.integer;
+            if(count < 1 || count > 16)
+            {
+                ecc_script_fatal("Invalid discardN : %d", count);
+            }
+            while(count--)
+            {
+                ecc_oper_trapop(context, 1);
+            }
+            ++context->ops;
+            opmac_dispatch();
+        }
+    opmac_case(AUTORELEASEEXPRESSION):
+        {
+            ecc_mempool_getindices(indices);
+            ecc_oper_release(context->ecc->result);
+            context->ecc->result = ecc_oper_retain(ecc_oper_trapop(context, 1));
+            ecc_mempool_collectunreferencedfromindices(indices);
+            ++context->ops;
+            opmac_dispatch();
+        }
+    opmac_case(AUTORELEASEDISCARD):
+        {
+            ecc_mempool_getindices(indices);
+            ecc_oper_trapop(context, 1);
+            ecc_mempool_collectunreferencedfromindices(indices);
+            ++context->ops;
+            opmac_dispatch();
+        }
+    opmac_case(JUMP):
+        {
+            context->ops += opmac_value().data.integer + 1;
+            opmac_dispatch();
+        }
+    opmac_case(JUMPIF):
+        {
+            offset = opmac_value().data.integer;
+            if(ecc_value_istrue(ecc_oper_trapop(context, 1)))
+            {
+                context->ops += offset;
+            }
+            ++context->ops;
+            opmac_dispatch();
+        }
+    opmac_case(JUMPIFNOT):
+        {
+            offset = opmac_value().data.integer;
+            if(!ecc_value_istrue(ecc_oper_trapop(context, 1)))
+            {
+                context->ops += offset;
+            }
+            ++context->ops;
+            opmac_dispatch();
+        }
+    opmac_case(JUMPIFNOTCOMPARE):
+        {
+            offset = opmac_value().data.integer;
+            ++context->ops;
+            opmac_fused(1);
+            if(!ecc_oper_testleaves(context))
+            {
+                context->ops += offset;
+            }
+            ++context->ops;
+            opmac_dispatch();
+        }
+    opmac_case(RESULT):
+        {
+            /* self tail call: rebind the arguments and loop instead of recursing */
+            if(context->ops[1].opcode == ECC_OPCODE_REPOPULATE)
+            {
+                ++context->ops;
+                ecc_oper_repopulateframe(context);
+                ++context->ops;
+                opmac_dispatch();
+            }
+            value = ecc_oper_trapop(context, 0);
+            context->breaker = -1;
+            return value;
+        }
+    opmac_case(RESULTVOID):
+        {
+            context->breaker = -1;
+            return ECCValConstUndefined;
+        }
+    opmac_case(BREAKER):
+        {
+            context->breaker = opmac_value().data.integer;
+            return ECCValConstUndefined;
+        }
+    opmac_case(STATEMENT):
+        {
+            context->canyield = 1;
+            value = context->ops->native(context);
+            if(context->breaker)
+            {
+                return value;
+            }
+            ++context->ops;
+            opmac_dispatch();
+        }
+#if !defined(__GNUC__)
+        }
+    }
+#endif
+    #undef opmac_dispatch
+    #undef opmac_case
 }
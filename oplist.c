@@ -15,12 +15,24 @@ eccoplist_t* ecc_oplist_create(const eccnativefuncptr_t native, eccvalue_t value
     self->ops = (eccoperand_t*)malloc(sizeof(*self->ops) * 1);
     self->ops[0] = ecc_oper_make(native, value, text);
     self->count = 1;
+    self->markepoch = 0;
     return self;
 }
 
 void ecc_oplist_destroy(eccoplist_t* self)
 {
+    uint32_t index;
     assert(self);
+    for(index = 0; index < self->count; ++index)
+    {
+        free(self->ops[index].cache), self->ops[index].cache = NULL;
+#if ECC_CONF_JIT
+        if(self->ops[index].jitcode)
+        {
+            ecc_jit_release(self->ops[index].jitcode), self->ops[index].jitcode = NULL;
+        }
+#endif
+    }
     free(self->ops), self->ops = NULL;
     free(self), self = NULL;
 }
@@ -421,7 +433,7 @@ void ecc_oplist_optimizewithenvironment(eccoplist_t* self, eccobject_t* environm
                             if(index > 1 && level == 1 && slot == selfIndex)
                             {
                                 eccoperand_t op = self->ops[index - 1];
-                                if(op.native == ecc_oper_call && self->ops[index - 2].native == ecc_oper_result)
+                                if((op.native == ecc_oper_call || op.native == ecc_oper_tailcall) && self->ops[index - 2].native == ecc_oper_result)
                                 {
                                     self->ops[index - 1] = ecc_oper_make(ecc_oper_repopulate, op.opvalue, op.text);
                                     self->ops[index] = ecc_oper_make(ecc_oper_value, ecc_value_fromint(-index - 1), self->ops[index].text);
@@ -445,6 +457,358 @@ void ecc_oplist_optimizewithenvironment(eccoplist_t* self, eccobject_t* environm
 
     if(!haveLocal)
         ecc_object_stripmap(environment);
+
+    /* ops are patched in place up to this point, so opcodes and caches are resolved last */
+    for(index = 0, count = self->count; index < count; ++index)
+    {
+        self->ops[index].opcode = ecc_oper_opcodeof(self->ops[index].native);
+        if(!self->ops[index].cache && (
+            (self->ops[index].native == ecc_oper_getmember) ||
+            (self->ops[index].native == ecc_oper_setmember) ||
+            (self->ops[index].native == ecc_oper_callmember) ||
+            (self->ops[index].native == ecc_oper_tailcallmember)))
+        {
+            self->ops[index].cache = (eccopcache_t*)calloc(1, sizeof(eccopcache_t));
+        }
+    }
+}
+
+/*
+* escape analysis, once ecc_oplist_optimizewithenvironment resolved the slots: a function with inner functions
+* keeps its environment on the stack, and only the locals the inner functions reach are boxed in cells,
+* a small heap environment between it and its parent (see ecc_oper_boxcells). inner functions close over
+* those cells, or over the parent directly when nothing is captured, instead of over the whole frame.
+* functions where names may be looked up at run time (with, catch, eval) or that use arguments keep a heap environment.
+*/
+
+static int ecc_oplist_isslotop(eccnativefuncptr_t native)
+{
+    return native == ecc_oper_getlocalslotref || native == ecc_oper_getlocalslot || native == ecc_oper_setlocalslot
+           || native == ecc_oper_deletelocalslot;
+}
+
+static int ecc_oplist_isparentslotop(eccnativefuncptr_t native)
+{
+    return native == ecc_oper_getparentslotref || native == ecc_oper_getparentslot || native == ecc_oper_setparentslot
+           || native == ecc_oper_deleteparentslot;
+}
+
+static int ecc_oplist_iskeyop(eccnativefuncptr_t native)
+{
+    return native == ecc_oper_createlocalref || native == ecc_oper_getlocalrefornull || native == ecc_oper_getlocalref
+           || native == ecc_oper_getlocal || native == ecc_oper_setlocal || native == ecc_oper_deletelocal;
+}
+
+static eccnativefuncptr_t ecc_oplist_parentslotof(eccnativefuncptr_t native)
+{
+    return native == ecc_oper_getlocalslotref ? ecc_oper_getparentslotref :
+           native == ecc_oper_getlocalslot    ? ecc_oper_getparentslot :
+           native == ecc_oper_setlocalslot    ? ecc_oper_setparentslot :
+                                                ecc_oper_deleteparentslot;
+}
+
+/* marks the slots of 'environment' reached from functions 'depth' levels down; 0 if its names can be reached otherwise */
+static int ecc_oplist_findcaptures(eccoplist_t* self, uint32_t depth, eccobject_t* environment, uint8_t* captured)
+{
+    uint32_t index;
+    uint32_t slot;
+    const eccoperand_t* op;
+    if(!self)
+    {
+        return 1;
+    }
+    for(index = 0; index < self->count; ++index)
+    {
+        op = &self->ops[index];
+        if(op->native == ecc_oper_with || op->native == ecc_oper_eval || op->native == ecc_oper_pushenvironment)
+        {
+            return 0;
+        }
+        else if(ecc_oplist_iskeyop(op->native))
+        {
+            for(slot = 2; slot < environment->hmapmapcount; ++slot)
+            {
+                if(environment->hmapmapitems[slot].hmapmapvalue.check == 1
+                   && ecc_keyidx_isequal(environment->hmapmapitems[slot].hmapmapvalue.key, op->opvalue.data.key))
+                {
+                    return 0;
+                }
+            }
+        }
+        else if(depth && ecc_oplist_isparentslotop(op->native) && (uint32_t)(op->opvalue.data.integer >> 16) == depth)
+        {
+            captured[op->opvalue.data.integer & 0xffff] = 1;
+        }
+        else if(op->native == ecc_oper_function && !ecc_oplist_findcaptures(op->opvalue.data.function->oplist, depth + 1, environment, captured))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* moves the references of functions 'depth' levels down to the cells, or one level up without cells */
+static void ecc_oplist_relinkcaptures(eccoplist_t* self, uint32_t depth, const uint32_t* cellof, int hascells)
+{
+    uint32_t index;
+    int32_t level;
+    int32_t slot;
+    eccoperand_t* op;
+    if(!self)
+    {
+        return;
+    }
+    for(index = 0; index < self->count; ++index)
+    {
+        op = &self->ops[index];
+        if(ecc_oplist_isparentslotop(op->native))
+        {
+            level = op->opvalue.data.integer >> 16;
+            slot = op->opvalue.data.integer & 0xffff;
+            if((uint32_t)level == depth)
+            {
+                op->opvalue = ecc_value_fromint((level << 16) | cellof[slot]);
+            }
+            else if((uint32_t)level > depth && !hascells)
+            {
+                op->opvalue = ecc_value_fromint(((level - 1) << 16) | slot);
+            }
+        }
+        else if(op->native == ecc_oper_function)
+        {
+            ecc_oplist_relinkcaptures(op->opvalue.data.function->oplist, depth + 1, cellof, hascells);
+        }
+    }
+}
+
+static void ecc_oplist_boxfunction(eccobjfunction_t* function)
+{
+    uint32_t index;
+    uint32_t slot;
+    uint32_t count;
+    uint32_t params;
+    uint32_t cellcount;
+    int hascells;
+    int haverepopulate;
+    eccoperand_t* op;
+    eccobject_t* environment;
+    eccoplist_t* self;
+    self = function->oplist;
+    environment = &function->funcenv;
+    count = environment->hmapmapcount;
+    if(!self || !(function->flags & ECC_SCRIPTFUNCFLAG_NEEDHEAP) || function->flags & ECC_SCRIPTFUNCFLAG_NEEDARGUMENTS || count > 0xffff)
+    {
+        return;
+    }
+    uint8_t captured[count];
+    uint32_t cellof[count];
+    memset(captured, 0, sizeof(captured));
+    if(!ecc_oplist_findcaptures(self, 0, environment, captured))
+    {
+        return;
+    }
+    for(slot = 0, hascells = 0, params = 0, cellcount = 0; slot < count; ++slot)
+    {
+        if(captured[slot])
+        {
+            hascells = 1;
+            ++cellcount;
+            if(slot >= 3 && slot < 3 + (uint32_t)function->argparamcount)
+            {
+                ++params;
+            }
+        }
+    }
+    for(index = 0, haverepopulate = 0; index < self->count; ++index)
+    {
+        if(self->ops[index].native == ecc_oper_repopulate)
+        {
+            haverepopulate = 1;
+        }
+        else if(hascells && ecc_oplist_isparentslotop(self->ops[index].native) && (self->ops[index].opvalue.data.integer >> 16) >= INT16_MAX)
+        {
+            /* levels past the function grow by one with cells */
+            return;
+        }
+    }
+    /* a self tail call rebinds the stack slots in place */
+    if(hascells && haverepopulate)
+    {
+        return;
+    }
+    /*
+    * with cells, a call copies the frame to the stack and the cells to the heap: that only beats
+    * copying the frame to the heap when enough locals stay behind (boxbench.js, one capture).
+    */
+    if(hascells && count - 3 - cellcount < ECC_CONF_BOXMINSLOTS)
+    {
+        return;
+    }
+    if(hascells)
+    {
+        function->cells = (eccobjcells_t*)malloc(sizeof(*function->cells) + sizeof(*function->cells->params) * params);
+        ecc_object_initialize(&function->cells->environment, NULL);
+        function->cells->paramcount = 0;
+        for(slot = 0; slot < count; ++slot)
+        {
+            if(captured[slot])
+            {
+                cellof[slot] = (uint32_t)((ecchashmap_t*)ecc_object_addmember(&function->cells->environment, environment->hmapmapitems[slot].hmapmapvalue.key,
+                                          environment->hmapmapitems[slot].hmapmapvalue, environment->hmapmapitems[slot].hmapmapvalue.flags)
+                                          - function->cells->environment.hmapmapitems);
+                if(slot >= 3 && slot < 3 + (uint32_t)function->argparamcount)
+                {
+                    function->cells->params[function->cells->paramcount++] = (slot << 16) | cellof[slot];
+                }
+            }
+        }
+    }
+    for(index = 0; index < self->count; ++index)
+    {
+        op = &self->ops[index];
+        if(ecc_oplist_isslotop(op->native) && captured[op->opvalue.data.integer])
+        {
+            op->native = ecc_oplist_parentslotof(op->native);
+            op->opvalue = ecc_value_fromint((1 << 16) | cellof[op->opvalue.data.integer]);
+            op->opcode = ecc_oper_opcodeof(op->native);
+        }
+        else if(ecc_oplist_isparentslotop(op->native) && hascells)
+        {
+            op->opvalue = ecc_value_fromint(op->opvalue.data.integer + (1 << 16));
+        }
+        else if(op->native == ecc_oper_function)
+        {
+            op->opvalue.data.function->flags |= ECC_SCRIPTFUNCFLAG_BOXEDPARENT;
+            ecc_oplist_relinkcaptures(op->opvalue.data.function->oplist, 1, cellof, hascells);
+        }
+    }
+    function->flags &= ~ECC_SCRIPTFUNCFLAG_NEEDHEAP;
+}
+
+static void ecc_oplist_boxfunctions(eccoplist_t* self)
+{
+    uint32_t index;
+    if(!self)
+    {
+        return;
+    }
+    for(index = 0; index < self->count; ++index)
+    {
+        if(self->ops[index].native == ecc_oper_function)
+        {
+            /* outer functions first, so that the levels seen from inner ones are still plain nesting depths */
+            ecc_oplist_boxfunction(self->ops[index].opvalue.data.function);
+            ecc_oplist_boxfunctions(self->ops[index].opvalue.data.function->oplist);
+        }
+    }
+}
+
+void ecc_oplist_boxcaptures(eccoplist_t* self)
+{
+    ecc_oplist_boxfunctions(self);
+}
+
+static int ecc_oplist_isleaf(const eccoperand_t* op)
+{
+    return op->native == ecc_oper_getlocalslot || op->native == ecc_oper_getparentslot || op->native == ecc_oper_value;
+}
+
+static eccnativefuncptr_t ecc_oplist_fusedof(const eccnativefuncptr_t native)
+{
+    if(native == ecc_oper_add)
+        return ecc_oper_addfused;
+    else if(native == ecc_oper_minus)
+        return ecc_oper_minusfused;
+    else if(native == ecc_oper_multiply)
+        return ecc_oper_multiplyfused;
+    else if(native == ecc_oper_less)
+        return ecc_oper_lessfused;
+    else if(native == ecc_oper_lessorequal)
+        return ecc_oper_lessorequalfused;
+    else if(native == ecc_oper_more)
+        return ecc_oper_morefused;
+    else if(native == ecc_oper_moreorequal)
+        return ecc_oper_moreorequalfused;
+    return NULL;
+}
+
+static void ecc_oplist_fuseops(eccoplist_t* self, eccioinput_t* report, eccstrbox_t text)
+{
+    uint32_t index;
+    uint32_t count;
+    uint32_t fused;
+    uint32_t removed;
+    int32_t line;
+    eccoperand_t* op;
+    eccnativefuncptr_t native;
+    fused = 0;
+    removed = 0;
+    for(index = 0, count = self->count; index < count; ++index)
+    {
+        op = &self->ops[index];
+        if(op->native == ecc_oper_function && op->opvalue.data.function->oplist)
+        {
+            ecc_oplist_fuseops(op->opvalue.data.function->oplist, report, op->text);
+        }
+        else if(index + 3 < count && (op->native == ecc_oper_setlocalslot || op->native == ecc_oper_setparentslot)
+                && op[1].native == ecc_oper_add && ecc_oplist_isleaf(op + 2) && ecc_oplist_isleaf(op + 3))
+        {
+            /* x = x + k, or any store of a sum of slots and constants */
+            op->native = op->native == ecc_oper_setlocalslot ? ecc_oper_setlocalslotadd : ecc_oper_setparentslotadd;
+            op[1].native = ecc_oper_addfused;
+            fused += 1;
+            removed += 3;
+        }
+        else if(index + 3 < count && op->native == ecc_oper_jumpifnot && (native = ecc_oplist_fusedof(op[1].native))
+                && native != ecc_oper_addfused && native != ecc_oper_minusfused && native != ecc_oper_multiplyfused
+                && ecc_oplist_isleaf(op + 2) && ecc_oplist_isleaf(op + 3))
+        {
+            op->native = ecc_oper_jumpifnotcompare;
+            op->opcode = ecc_oper_opcodeof(op->native);
+            op[1].native = native;
+            fused += 1;
+            removed += 3;
+        }
+        else if(index + 1 < count && op->native == ecc_oper_getmember
+                && (op[1].native == ecc_oper_getlocalslot || op[1].native == ecc_oper_getparentslot))
+        {
+            op->native = ecc_oper_getmemberslot;
+            fused += 1;
+            removed += 1;
+        }
+        else if(index + 2 < count && (native = ecc_oplist_fusedof(op->native)) && ecc_oplist_isleaf(op + 1) && ecc_oplist_isleaf(op + 2))
+        {
+            op->native = native;
+            fused += 1;
+            removed += 2;
+        }
+    }
+    if(report && fused)
+    {
+        /* functions by the line they start at, the program by its input alone */
+        line = text.length ? ecc_ioinput_findline(report, text) : 0;
+        if(line > 0)
+            fprintf(stderr, "fusion: %s:%d: ", report->name, line);
+        else
+            fprintf(stderr, "fusion: %s: ", report->name);
+        fprintf(stderr, "%u superinstructions, %u of %u ops no longer dispatched\n", fused, removed, self->count);
+    }
+}
+
+/*
+* fuses frequent operand sequences into superinstructions: binary operators on two
+* slots or constants, comparisons of those under a jumpifnot, stores of their sum to a
+* slot, and member access on a slot.
+* runs on lists already through ecc_oplist_optimizewithenvironment, that resolves the slots;
+* with 'report', prints how many ops each function no longer dispatches to stderr.
+*/
+void ecc_oplist_fuse(eccoplist_t* self, eccioinput_t* report)
+{
+    if(!self)
+    {
+        return;
+    }
+    ecc_oplist_fuseops(self, report, ECC_String_Empty);
 }
 
 void ecc_oplist_dumpto(eccoplist_t* self, FILE* file)
@@ -9,38 +9,502 @@
 
 #include "ecc.h"
 
+#if ECC_CONF_PARALLELGC
+    #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__GNUC__)
+    #define ecc_mempool_prefetch(address) __builtin_prefetch(address)
+#else
+    #define ecc_mempool_prefetch(address) ((void)0)
+#endif
+
 static eccmempool_t* self = NULL;
 
-void ecc_mempool_markobject(eccobject_t* object)
+#if ECC_CONF_PARALLELGC
+/*
+// full collections of big heaps are shared among worker threads, the calling one being the first:
+// each marks from a private stack, and hands the older half of it over to a shared one
+// when another worker ran dry and its own shared stack is empty. sweeping is split by size class.
+*/
+typedef struct eccgcworker_t eccgcworker_t;
+
+struct eccgcworker_t
 {
-    uint32_t index, count;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    int started;
+    uint32_t index;
+    eccobject_t** stackvals;
+    uint32_t stackcount;
+    uint32_t stackcapacity;
+    /* only touched under the lock, but the count is read without it to find work */
+    eccobject_t** sharedvals;
+    uint32_t sharedcount;
+    uint32_t sharedcapacity;
+    eccmemslab_t* emptyslabs;
+};
 
-    if(object->flags & ECC_OBJFLAG_MARK)
+static eccgcworker_t* g_gcworkers = NULL;
+static uint32_t g_gcworkercount = 0;
+static uint32_t g_gcidlecount = 0;
+static uint32_t g_gcnextunit = 0;
+static int g_gcrelist = 0;
+static __thread eccgcworker_t* g_gcworker = NULL;
+#endif
+
+static void ecc_mempool_growstack(eccobject_t*** vals, uint32_t* capacity, uint32_t count)
+{
+    size_t needed;
+    eccobject_t** tmp;
+
+    if(count <= *capacity)
         return;
 
-    object->flags |= ECC_OBJFLAG_MARK;
+    while(*capacity < count)
+        *capacity = *capacity ? *capacity * 2 : 256;
+
+    needed = (*capacity * sizeof(**vals));
+    tmp = (eccobject_t**)realloc(*vals, needed);
+    if(tmp == NULL)
+    {
+        fprintf(stderr, "in growstack: failed to reallocate for %ld bytes\n", needed);
+    }
+    *vals = tmp;
+}
+
+static int ecc_mempool_isliveobject(eccobject_t* object);
+static int ecc_mempool_islivechars(eccstrbuffer_t* chars);
+
+static void ecc_mempool_markmembers(eccobject_t* object)
+{
+    uint32_t index, count;
+
+    /* have the headers of the member objects on their way before testing their marks one by one */
+    for(index = 0, count = object->hmapitemcount; index < count; ++index)
+        if(object->hmapitemitems[index].hmapitemvalue.type >= ECC_VALTYPE_OBJECT)
+            ecc_mempool_prefetch(object->hmapitemitems[index].hmapitemvalue.data.object);
+
+    for(index = 2, count = object->hmapmapcount; index < count; ++index)
+        if(object->hmapmapitems[index].hmapmapvalue.type >= ECC_VALTYPE_OBJECT)
+            ecc_mempool_prefetch(object->hmapmapitems[index].hmapmapvalue.data.object);
 
     if(object->prototype)
         ecc_mempool_markobject(object->prototype);
 
+    if(object->shape)
+        ecc_shape_mark(object->shape);
+
     for(index = 0, count = object->hmapitemcount; index < count; ++index)
         if(object->hmapitemitems[index].hmapitemvalue.check == 1)
             ecc_mempool_markvalue(object->hmapitemitems[index].hmapitemvalue);
 
     for(index = 2, count = object->hmapmapcount; index < count; ++index)
         if(object->hmapmapitems[index].hmapmapvalue.check == 1)
+        {
+            ecc_keyidx_mark(object->hmapmapitems[index].hmapmapvalue.key);
             ecc_mempool_markvalue(object->hmapmapitems[index].hmapmapvalue);
+        }
 
     if(object->type->fnmark)
         object->type->fnmark(object);
 }
 
+/* marked objects are pushed on the gray list and looked at by ecc_mempool_markstep, not recursively */
+void ecc_mempool_markobject(eccobject_t* object)
+{
+#if ECC_CONF_PARALLELGC
+    eccgcworker_t* worker = g_gcworker;
+#endif
+
+    if(self->conservative && !ecc_mempool_isliveobject(object))
+        return;
+
+#if ECC_CONF_PARALLELGC
+
+    if(worker)
+    {
+        if((__atomic_load_n(&object->flags, __ATOMIC_RELAXED) & ECC_OBJFLAG_MARK)
+           || (__atomic_fetch_or(&object->flags, ECC_OBJFLAG_MARK, __ATOMIC_RELAXED) & ECC_OBJFLAG_MARK))
+            return;
+
+        ecc_mempool_prefetch(object->hmapitemitems);
+        ecc_mempool_prefetch(object->hmapmapitems);
+        ecc_mempool_growstack(&worker->stackvals, &worker->stackcapacity, worker->stackcount + 1);
+        worker->stackvals[worker->stackcount++] = object;
+        return;
+    }
+#endif
+
+    if(object->flags & ECC_OBJFLAG_MARK)
+        return;
+
+    object->flags |= ECC_OBJFLAG_MARK;
+
+    /* the header is at hand: start loading the member arrays markmembers is going to walk */
+    ecc_mempool_prefetch(object->hmapitemitems);
+    ecc_mempool_prefetch(object->hmapmapitems);
+    ecc_mempool_growstack(&self->graylistvals, &self->graylistcapacity, self->graylistcount + 1);
+    self->graylistvals[self->graylistcount++] = object;
+}
+
+/* looks at up to 'budget' gray objects, returns whether none is left */
+int ecc_mempool_markstep(uint32_t budget)
+{
+    while(self->graylistcount && budget--)
+        ecc_mempool_markmembers(self->graylistvals[--self->graylistcount]);
+
+    return !self->graylistcount;
+}
+
 void ecc_mempool_markchars(eccstrbuffer_t* chars)
 {
-    if(chars->flags & ECC_CHARBUFFLAG_MARK)
+    eccstrrope_t* rope;
+
+    if(self->conservative && !ecc_mempool_islivechars(chars))
+        return;
+
+    /* ropes are marked down their left side in this loop, where += makes them deep, the right side recursively */
+    for(;;)
+    {
+#if ECC_CONF_PARALLELGC
+        if(g_gcworker)
+        {
+            if(__atomic_load_n(&chars->flags, __ATOMIC_RELAXED) & ECC_CHARBUFFLAG_MARK)
+                return;
+
+            if(__atomic_fetch_or(&chars->flags, ECC_CHARBUFFLAG_MARK, __ATOMIC_RELAXED) & ECC_CHARBUFFLAG_MARK)
+                return;
+        }
+        else
+#endif
+        {
+            if(chars->flags & ECC_CHARBUFFLAG_MARK)
+                return;
+
+            chars->flags |= ECC_CHARBUFFLAG_MARK;
+        }
+
+        /* a slice leaves its parent to ecc_mempool_unpinslices */
+        if(!(chars->flags & ECC_CHARBUFFLAG_ROPE))
+            return;
+
+        rope = (eccstrrope_t*)chars;
+        if(!rope->right)
+            chars = rope->left;
+        else if(rope->left->flags & ECC_CHARBUFFLAG_ROPE || !(rope->right->flags & ECC_CHARBUFFLAG_ROPE))
+        {
+            ecc_mempool_markchars(rope->right);
+            chars = rope->left;
+        }
+        else
+        {
+            /* prepended to: the left is a leaf, the rope goes on to the right */
+            ecc_mempool_markchars(rope->left);
+            chars = rope->right;
+        }
+    }
+}
+
+#define ecc_mempool_slabof(cell) ((eccmemslab_t*)((uintptr_t)(cell) & ~(uintptr_t)(ECC_CONF_SLABSIZE - 1)))
+#define ecc_mempool_cellat(slab, index) ((char*)(slab) + (slab)->celloffset + (size_t)(index) * (slab)->cellsize)
+#define ecc_mempool_islive(slab, index) ((slab)->livebits[(index) >> 5] & (UINT32_C(1) << ((index) & 31)))
+
+static uint32_t ecc_mempool_sizeclass(size_t size)
+{
+    if(size <= 16)
+        return 0;
+    else if(size <= 256)
+        return (uint32_t)((size + 7) / 8 - 2);
+    else if(size <= 512)
+        return 31;
+    else
+        return 32;
+}
+
+static uint32_t ecc_mempool_cellsize(uint32_t sizeclass)
+{
+    if(sizeclass < 31)
+        return (sizeclass + 2) * 8;
+    else
+        return 512 << (sizeclass - 31);
+}
+
+static char* ecc_mempool_arenabase(char* arena)
+{
+    return (char*)(((uintptr_t)arena + ECC_CONF_SLABSIZE - 1) & ~(uintptr_t)(ECC_CONF_SLABSIZE - 1));
+}
+
+static int ecc_mempool_isslabcell(const void* cell)
+{
+    uint32_t lower = 0, upper = self->arenalistcount, middle;
+    const char* base;
+
+    /* arenas are kept sorted by address */
+    while(lower < upper)
+    {
+        middle = (lower + upper) / 2;
+        base = ecc_mempool_arenabase(self->arenalistvals[middle]);
+        if((const char*)cell < base)
+            upper = middle;
+        else if((const char*)cell >= base + (size_t)ECC_CONF_SLABSIZE * ECC_CONF_SLABSPERARENA)
+            lower = middle + 1;
+        else
+            return 1;
+    }
+    return 0;
+}
+
+static void ecc_mempool_addarena(void)
+{
+    size_t needed;
+    char* arena;
+    char** tmp;
+    uint32_t index;
+
+    /* one extra slab worth of bytes so the slabs can be aligned; the unused part is never touched */
+    needed = (size_t)ECC_CONF_SLABSIZE * (ECC_CONF_SLABSPERARENA + 1);
+    arena = (char*)malloc(needed);
+    if(arena == NULL)
+    {
+        fprintf(stderr, "in addarena: failed to allocate for %ld bytes\n", (long)needed);
+        abort();
+    }
+    if(self->arenalistcount >= self->arenalistcapacity)
+    {
+        self->arenalistcapacity = self->arenalistcapacity ? self->arenalistcapacity * 2 : 8;
+        needed = (self->arenalistcapacity * sizeof(*self->arenalistvals));
+        tmp = (char**)realloc(self->arenalistvals, needed);
+        if(tmp == NULL)
+        {
+            fprintf(stderr, "in addarena: failed to reallocate for %ld bytes\n", needed);
+        }
+        self->arenalistvals = tmp;
+    }
+    index = self->arenalistcount++;
+    while(index && self->arenalistvals[index - 1] > arena)
+    {
+        self->arenalistvals[index] = self->arenalistvals[index - 1];
+        --index;
+    }
+    self->arenalistvals[index] = arena;
+    self->arenanext = ecc_mempool_arenabase(arena);
+    self->arenaleft = ECC_CONF_SLABSPERARENA;
+}
+
+size_t ecc_mempool_heapbytes(void)
+{
+    return (size_t)self->slabcount * ECC_CONF_SLABSIZE + self->largebytes;
+}
+
+/* 0 = never */
+void ecc_mempool_setcollectbytes(size_t bytes)
+{
+    self->collectbytes = bytes;
+    self->collectpending = 0;
+}
+
+/* whether the heap outgrew the size given to ecc_mempool_setcollectbytes since the last full collection */
+int ecc_mempool_collectpending(void)
+{
+    return self->collectpending;
+}
+
+static void ecc_mempool_checkgrowth(void)
+{
+    if(self->collectbytes && ecc_mempool_heapbytes() > self->collectbytes)
+        self->collectpending = 1;
+}
+
+static eccmemslab_t* ecc_mempool_addslab(eccmemkind_t kind, uint32_t sizeclass)
+{
+    eccmemslab_t* slab;
+
+    if(self->emptyslabs)
+    {
+        slab = self->emptyslabs;
+        self->emptyslabs = slab->next;
+    }
+    else
+    {
+        if(!self->arenaleft)
+            ecc_mempool_addarena();
+
+        slab = (eccmemslab_t*)self->arenanext;
+        self->arenanext += ECC_CONF_SLABSIZE;
+        --self->arenaleft;
+    }
+    memset(slab, 0, sizeof(*slab));
+    slab->kind = kind;
+    slab->sizeclass = sizeclass;
+    slab->cellsize = ecc_mempool_cellsize(sizeclass);
+    slab->celloffset = (sizeof(*slab) + 15) & ~15;
+    slab->cellcount = (ECC_CONF_SLABSIZE - slab->celloffset) / slab->cellsize;
+    slab->next = self->slabs[kind][sizeclass];
+    self->slabs[kind][sizeclass] = slab;
+    ++self->slabcount;
+    ecc_mempool_checkgrowth();
+    return slab;
+}
+
+static uint32_t ecc_mempool_largeclass(size_t size)
+{
+    uint32_t largeclass = 0;
+
+    while(((size_t)1 << largeclass) < size)
+        ++largeclass;
+
+    return largeclass;
+}
+
+void* ecc_mempool_allocate(eccmemkind_t kind, size_t size)
+{
+    uint32_t sizeclass, index;
+    eccmemslab_t* slab;
+    eccmemlarge_t* large;
+    void* cell;
+
+    if(size > ECC_MEMPOOL_MAXCELLSIZE)
+    {
+        assert(kind == ECC_MEMKIND_CHARS);
+        sizeclass = ecc_mempool_largeclass(size);
+        size = (size_t)1 << sizeclass;
+        if((large = self->largefree[sizeclass]))
+        {
+            self->largefree[sizeclass] = large->next;
+            self->largefreebytes -= size;
+        }
+        else
+        {
+            large = (eccmemlarge_t*)malloc(sizeof(*large) + size);
+            if(large == NULL)
+            {
+                fprintf(stderr, "in allocate: failed to allocate for %ld bytes\n", (long)(sizeof(*large) + size));
+                abort();
+            }
+        }
+        large->prev = NULL;
+        large->size = size;
+        large->next = self->largechars;
+        if(large->next)
+            large->next->prev = large;
+
+        self->largechars = large;
+        self->largebytes += size;
+        ecc_mempool_checkgrowth();
+        return large + 1;
+    }
+
+    sizeclass = ecc_mempool_sizeclass(size);
+    cell = self->freecells[kind][sizeclass];
+    if(cell)
+    {
+        self->freecells[kind][sizeclass] = *(void**)cell;
+        slab = ecc_mempool_slabof(cell);
+        index = (uint32_t)(((char*)cell - (char*)slab - slab->celloffset) / slab->cellsize);
+    }
+    else
+    {
+        slab = self->slabs[kind][sizeclass];
+        if(!slab || slab->bumpcount >= slab->cellcount)
+            slab = ecc_mempool_addslab(kind, sizeclass);
+
+        index = slab->bumpcount++;
+        cell = ecc_mempool_cellat(slab, index);
+    }
+    slab->livebits[index >> 5] |= UINT32_C(1) << (index & 31);
+    ++slab->livecount;
+    return cell;
+}
+
+void ecc_mempool_free(eccmemkind_t kind, void* cell)
+{
+    uint32_t index, sizeclass;
+    eccmemslab_t* slab;
+    eccmemlarge_t* large;
+
+    if(kind == ECC_MEMKIND_CHARS && !ecc_mempool_isslabcell(cell))
+    {
+        large = (eccmemlarge_t*)cell - 1;
+        if(large->prev)
+            large->prev->next = large->next;
+        else
+            self->largechars = large->next;
+
+        if(large->next)
+            large->next->prev = large->prev;
+
+        self->largebytes -= large->size;
+        if(self->largefreebytes + large->size <= ECC_CONF_CHARSCACHE)
+        {
+            sizeclass = ecc_mempool_largeclass(large->size);
+            large->next = self->largefree[sizeclass];
+            self->largefree[sizeclass] = large;
+            self->largefreebytes += large->size;
+        }
+        else
+            free(large);
+
         return;
+    }
+
+    slab = ecc_mempool_slabof(cell);
+    index = (uint32_t)(((char*)cell - (char*)slab - slab->celloffset) / slab->cellsize);
+    assert(ecc_mempool_islive(slab, index));
+    slab->livebits[index >> 5] &= ~(UINT32_C(1) << (index & 31));
+    --slab->livecount;
+    *(void**)cell = self->freecells[slab->kind][slab->sizeclass];
+    self->freecells[slab->kind][slab->sizeclass] = cell;
+}
+
+/*
+// grows (or shrinks) a string buffer nothing refers to yet, such as the one of an append builder:
+// big ones are realloc'ed in place, others moved to a cell of the new size class and the old cell freed at once.
+*/
+void* ecc_mempool_reallocate(eccmemkind_t kind, void* cell, size_t size)
+{
+    size_t oldsize;
+    eccmemlarge_t *large, *moved;
+    void* newcell;
 
-    chars->flags |= ECC_CHARBUFFLAG_MARK;
+    assert(kind == ECC_MEMKIND_CHARS);
+
+    if(ecc_mempool_isslabcell(cell))
+        oldsize = ecc_mempool_slabof(cell)->cellsize;
+    else
+    {
+        large = (eccmemlarge_t*)cell - 1;
+        if(size > ECC_MEMPOOL_MAXCELLSIZE)
+        {
+            size = (size_t)1 << ecc_mempool_largeclass(size);
+            moved = (eccmemlarge_t*)realloc(large, sizeof(*large) + size);
+            if(moved == NULL)
+            {
+                fprintf(stderr, "in reallocate: failed to reallocate for %ld bytes\n", (long)(sizeof(*large) + size));
+                abort();
+            }
+            if(moved->prev)
+                moved->prev->next = moved;
+            else
+                self->largechars = moved;
+
+            if(moved->next)
+                moved->next->prev = moved;
+
+            self->largebytes += size - moved->size;
+            moved->size = size;
+            ecc_mempool_checkgrowth();
+            return moved + 1;
+        }
+        oldsize = large->size;
+    }
+
+    newcell = ecc_mempool_allocate(kind, size);
+    memcpy(newcell, cell, oldsize < size ? oldsize : size);
+    ecc_mempool_free(kind, cell);
+    return newcell;
 }
 
 void ecc_mempool_setup(void)
@@ -52,11 +516,29 @@ void ecc_mempool_setup(void)
 
 void ecc_mempool_teardown(void)
 {
+    uint32_t index;
+    eccmemlarge_t* large;
+
     assert(self);
 
     ecc_mempool_unmarkall();
     ecc_mempool_collectunmarked();
 
+    for(index = 0; index < self->arenalistcount; ++index)
+        free(self->arenalistvals[index]);
+
+    for(index = 0; index < ECC_MEMPOOL_LARGECLASSCOUNT; ++index)
+        while((large = self->largefree[index]))
+        {
+            self->largefree[index] = large->next;
+            free(large);
+        }
+
+    free(self->arenalistvals), self->arenalistvals = NULL;
+    free(self->remlistvals), self->remlistvals = NULL;
+    free(self->graylistvals), self->graylistvals = NULL;
+    free(self->capturelistvals), self->capturelistvals = NULL;
+    free(self->cleanuplistvals), self->cleanuplistvals = NULL;
     free(self->funclistvals), self->funclistvals = NULL;
     free(self->objlistvals), self->objlistvals = NULL;
     free(self->sbuflistvals), self->sbuflistvals = NULL;
@@ -132,19 +614,46 @@ void ecc_mempool_addchars(eccstrbuffer_t* chars)
 
 void ecc_mempool_unmarkall(void)
 {
-    uint32_t index, count;
+    uint32_t kind, sizeclass, index, count;
+    eccmemslab_t* slab;
+    eccmemlarge_t* large;
+    eccobjfunction_t* function;
+    eccobject_t* object;
 
-    for(index = 0, count = self->funclistcount; index < count; ++index)
-    {
-        self->funclistvals[index]->object.flags &= ~ECC_OBJFLAG_MARK;
-        self->funclistvals[index]->funcenv.flags &= ~ECC_OBJFLAG_MARK;
-    }
+    /* a pending incremental mark is abandoned */
+    self->graylistcount = 0;
+    self->marking = 0;
+    ++self->markepoch;
 
-    for(index = 0, count = self->objlistcount; index < count; ++index)
-        self->objlistvals[index]->flags &= ~ECC_OBJFLAG_MARK;
+    for(kind = 0; kind < ECC_MEMKIND_COUNT; ++kind)
+        for(sizeclass = 0; sizeclass < ECC_MEMPOOL_CLASSCOUNT; ++sizeclass)
+            for(slab = self->slabs[kind][sizeclass]; slab; slab = slab->next)
+                for(index = 0, count = slab->bumpcount; index < count; ++index)
+                {
+                    if(!ecc_mempool_islive(slab, index))
+                        continue;
 
-    for(index = 0, count = self->sbuflistcount; index < count; ++index)
-        self->sbuflistvals[index]->flags &= ~ECC_CHARBUFFLAG_MARK;
+                    if(kind == ECC_MEMKIND_FUNCTION)
+                    {
+                        function = (eccobjfunction_t*)ecc_mempool_cellat(slab, index);
+                        function->object.flags &= ~ECC_OBJFLAG_MARK;
+                        function->funcenv.flags &= ~ECC_OBJFLAG_MARK;
+                    }
+                    else if(kind == ECC_MEMKIND_OBJECT)
+                    {
+                        object = (eccobject_t*)ecc_mempool_cellat(slab, index);
+                        object->flags &= ~ECC_OBJFLAG_MARK;
+
+                        /* function copies are carved from object slabs, and copy their marks from the original */
+                        if(object->type == &ECC_Type_Function)
+                            ((eccobjfunction_t*)object)->funcenv.flags &= ~ECC_OBJFLAG_MARK;
+                    }
+                    else
+                        ((eccstrbuffer_t*)ecc_mempool_cellat(slab, index))->flags &= ~ECC_CHARBUFFLAG_MARK;
+                }
+
+    for(large = self->largechars; large; large = large->next)
+        ((eccstrbuffer_t*)(large + 1))->flags &= ~ECC_CHARBUFFLAG_MARK;
 }
 
 void ecc_mempool_markvalue(eccvalue_t value)
@@ -153,6 +662,10 @@ void ecc_mempool_markvalue(eccvalue_t value)
         ecc_mempool_markobject(value.data.object);
     else if(value.type == ECC_VALTYPE_CHARS)
         ecc_mempool_markchars(value.data.chars);
+    else if(value.type == ECC_VALTYPE_KEY)
+        ecc_keyidx_mark(value.data.key);
+    else if(value.type == ECC_VALTYPE_TEXT)
+        ecc_keyidx_marktext(value.data.text);
 }
 
 void ecc_mempool_releaseobject(eccobject_t* object)
@@ -178,34 +691,48 @@ eccvalue_t ecc_mempool_retainvalue(eccvalue_t value)
     if(value.type >= ECC_VALTYPE_OBJECT)
     {
         ++value.data.object->refcount;
-        if(!(value.data.object->flags & ECC_OBJFLAG_MARK))
+        if(!(value.data.object->flags & ECC_OBJFLAG_CAPTURED))
         {
-            value.data.object->flags |= ECC_OBJFLAG_MARK;
+            value.data.object->flags |= ECC_OBJFLAG_CAPTURED;
             ecc_mempool_captureobject(value.data.object);
         }
     }
     return value;
 }
 
-void ecc_mempool_cleanupobject(eccobject_t* object)
+static void ecc_mempool_releasemembers(eccobject_t* object)
 {
     eccvalue_t value;
 
     if(object->prototype && object->prototype->refcount)
         --object->prototype->refcount;
 
-    if(object->hmapitemcount)
-        while(object->hmapitemcount--)
-            if((value = object->hmapitemitems[object->hmapitemcount].hmapitemvalue).check == 1)
-                ecc_mempool_releasevalue(value);
+    /* leaves both counts at zero, so an object cleaned up twice releases nothing the second time */
+    while(object->hmapitemcount)
+        if((value = object->hmapitemitems[--object->hmapitemcount].hmapitemvalue).check == 1)
+            ecc_mempool_releasevalue(value);
 
-    if(object->hmapmapcount)
-        while(object->hmapmapcount--)
-            if((value = object->hmapmapitems[object->hmapmapcount].hmapmapvalue).check == 1)
-                ecc_mempool_releasevalue(value);
+    while(object->hmapmapcount)
+        if((value = object->hmapmapitems[--object->hmapmapcount].hmapmapvalue).check == 1)
+            ecc_mempool_releasevalue(value);
 }
 
-void ecc_mempool_captureobject(eccobject_t* object)
+/* objects released from within are queued for the outermost call, so long chains do not recurse */
+void ecc_mempool_cleanupobject(eccobject_t* object)
+{
+    ecc_mempool_growstack(&self->cleanuplistvals, &self->cleanuplistcapacity, self->cleanuplistcount + 1);
+    self->cleanuplistvals[self->cleanuplistcount++] = object;
+    if(self->cleaningup)
+        return;
+
+    self->cleaningup = 1;
+    while(self->cleanuplistcount)
+        ecc_mempool_releasemembers(self->cleanuplistvals[--self->cleanuplistcount]);
+
+    self->cleaningup = 0;
+}
+
+static void ecc_mempool_retainmembers(eccobject_t* object)
 {
     uint32_t index, count;
     ecchashitem_t* element;
@@ -214,9 +741,9 @@ void ecc_mempool_captureobject(eccobject_t* object)
     if(object->prototype)
     {
         ++object->prototype->refcount;
-        if(!(object->prototype->flags & ECC_OBJFLAG_MARK))
+        if(!(object->prototype->flags & ECC_OBJFLAG_CAPTURED))
         {
-            object->prototype->flags |= ECC_OBJFLAG_MARK;
+            object->prototype->flags |= ECC_OBJFLAG_CAPTURED;
             ecc_mempool_captureobject(object->prototype);
         }
     }
@@ -241,69 +768,593 @@ void ecc_mempool_captureobject(eccobject_t* object)
         object->type->fncapture(object);
 }
 
-void ecc_mempool_collectunmarked(void)
+/* like ecc_mempool_cleanupobject, captures reached from within are queued for the outermost call */
+void ecc_mempool_captureobject(eccobject_t* object)
 {
-    uint32_t index;
+    ecc_mempool_growstack(&self->capturelistvals, &self->capturelistcapacity, self->capturelistcount + 1);
+    self->capturelistvals[self->capturelistcount++] = object;
+    if(self->capturing)
+        return;
 
-    /* finalize & destroy */
+    self->capturing = 1;
+    while(self->capturelistcount)
+        ecc_mempool_retainmembers(self->capturelistvals[--self->capturelistcount]);
 
-    index = self->funclistcount;
-    while(index--)
-        if(!(self->funclistvals[index]->object.flags & ECC_OBJFLAG_MARK) && !(self->funclistvals[index]->funcenv.flags & ECC_OBJFLAG_MARK))
-        {
-            ecc_function_destroy(self->funclistvals[index]);
-            self->funclistvals[index] = self->funclistvals[--self->funclistcount];
-        }
+    self->capturing = 0;
+}
 
-    index = self->objlistcount;
-    while(index--)
-        if(!(self->objlistvals[index]->flags & ECC_OBJFLAG_MARK))
-        {
-            ecc_object_finalize(self->objlistvals[index]);
-            ecc_object_destroy(self->objlistvals[index]);
-            self->objlistvals[index] = self->objlistvals[--self->objlistcount];
-        }
+static int ecc_mempool_ismarked(eccmemkind_t kind, void* cell)
+{
+    if(kind == ECC_MEMKIND_FUNCTION)
+        return (((eccobjfunction_t*)cell)->object.flags & ECC_OBJFLAG_MARK) || (((eccobjfunction_t*)cell)->funcenv.flags & ECC_OBJFLAG_MARK);
+    else if(kind == ECC_MEMKIND_OBJECT)
+        return ((eccobject_t*)cell)->flags & ECC_OBJFLAG_MARK;
+    else
+        return ((eccstrbuffer_t*)cell)->flags & ECC_CHARBUFFLAG_MARK;
+}
 
-    index = self->sbuflistcount;
-    while(index--)
-        if(!(self->sbuflistvals[index]->flags & ECC_CHARBUFFLAG_MARK))
-        {
-            ecc_strbuf_destroy(self->sbuflistvals[index]);
-            self->sbuflistvals[index] = self->sbuflistvals[--self->sbuflistcount];
-        }
+static void ecc_mempool_destroycell(eccmemkind_t kind, void* cell)
+{
+    if(kind == ECC_MEMKIND_FUNCTION)
+        ecc_function_destroy((eccobjfunction_t*)cell);
+    else if(kind == ECC_MEMKIND_OBJECT)
+    {
+        ecc_object_finalize((eccobject_t*)cell);
+        ecc_object_destroy((eccobject_t*)cell);
+    }
+    else
+        ecc_strbuf_destroy((eccstrbuffer_t*)cell);
 }
 
-void ecc_mempool_collectunreferencedfromindices(uint32_t indices[3])
+static uint32_t ecc_mempool_reservelist(eccmemkind_t kind, uint32_t count)
 {
-    uint32_t index;
+    uint32_t* listcount;
 
-    /* prepare */
+    if(kind == ECC_MEMKIND_FUNCTION)
+        listcount = &self->funclistcount;
+    else if(kind == ECC_MEMKIND_OBJECT)
+        listcount = &self->objlistcount;
+    else
+        listcount = &self->sbuflistcount;
 
-    index = self->objlistcount;
-    while(index-- > indices[1])
-        if(self->objlistvals[index]->refcount <= 0)
-            ecc_mempool_cleanupobject(self->objlistvals[index]);
+#if ECC_CONF_PARALLELGC
+    return __atomic_fetch_add(listcount, count, __ATOMIC_RELAXED);
+#else
+    *listcount += count;
+    return *listcount - count;
+#endif
+}
 
-    index = self->objlistcount;
-    while(index-- > indices[1])
-        if(self->objlistvals[index]->refcount > 0 && !(self->objlistvals[index]->flags & ECC_OBJFLAG_MARK))
-        {
-            self->objlistvals[index]->flags |= ECC_OBJFLAG_MARK;
-            ecc_mempool_captureobject(self->objlistvals[index]);
-        }
+static void ecc_mempool_relist(eccmemkind_t kind, void* cell, uint32_t index)
+{
+    /* the lists only shrink during a sweep, so capacity is always there; survivors are old from now on */
+    if(kind == ECC_MEMKIND_FUNCTION)
+    {
+        ((eccobjfunction_t*)cell)->object.flags &= ~(ECC_OBJFLAG_YOUNG | ECC_OBJFLAG_REMEMBERED);
+        ((eccobjfunction_t*)cell)->funcenv.flags &= ~(ECC_OBJFLAG_YOUNG | ECC_OBJFLAG_REMEMBERED);
+        self->funclistvals[index] = (eccobjfunction_t*)cell;
+    }
+    else if(kind == ECC_MEMKIND_OBJECT)
+    {
+        ((eccobject_t*)cell)->flags &= ~(ECC_OBJFLAG_YOUNG | ECC_OBJFLAG_REMEMBERED);
+        self->objlistvals[index] = (eccobject_t*)cell;
+    }
+    else
+        self->sbuflistvals[index] = (eccstrbuffer_t*)cell;
+}
 
-    /* destroy */
+/* only touches the slabs of one kind and size class, and the list entries it reserved: classes can be swept side by side */
+static void ecc_mempool_sweepclass(eccmemkind_t kind, uint32_t sizeclass, eccmemslab_t** empties, int relist)
+{
+    uint32_t index, count, listindex;
+    eccmemslab_t *slab, **link;
+    void* cell;
+    void** freetail;
 
-    index = self->funclistcount;
-    while(index-- > indices[0])
-        if(!self->funclistvals[index]->object.refcount && !self->funclistvals[index]->funcenv.refcount)
+    /* finalize & destroy */
+
+    for(slab = self->slabs[kind][sizeclass]; slab; slab = slab->next)
+        for(index = 0, count = slab->bumpcount; index < count; ++index)
+            if(ecc_mempool_islive(slab, index) && !ecc_mempool_ismarked(kind, (cell = ecc_mempool_cellat(slab, index))))
+                ecc_mempool_destroycell(kind, cell);
+
+    count = 0;
+    for(slab = self->slabs[kind][sizeclass]; slab; slab = slab->next)
+        count += slab->livecount;
+
+    listindex = relist ? ecc_mempool_reservelist(kind, count) : 0;
+
+    /* give empty slabs back, thread the free cells slab by slab and list the survivors */
+
+    self->freecells[kind][sizeclass] = NULL;
+    freetail = &self->freecells[kind][sizeclass];
+    link = &self->slabs[kind][sizeclass];
+    while((slab = *link))
+    {
+        if(!slab->livecount)
         {
-            ecc_function_destroy(self->funclistvals[index]);
-            self->funclistvals[index] = self->funclistvals[--self->funclistcount];
+            *link = slab->next;
+            slab->next = *empties;
+            *empties = slab;
+            continue;
         }
-
-    index = self->objlistcount;
-    while(index-- > indices[1])
+        for(index = 0, count = slab->bumpcount; index < count; ++index)
+        {
+            cell = ecc_mempool_cellat(slab, index);
+            if(ecc_mempool_islive(slab, index))
+            {
+                if(relist)
+                    ecc_mempool_relist(kind, cell, listindex++);
+            }
+            else
+            {
+                *freetail = cell;
+                freetail = (void**)cell;
+            }
+        }
+        link = &slab->next;
+    }
+    *freetail = NULL;
+}
+
+static void ecc_mempool_clearlists(void)
+{
+    /*
+    // walk the slabs rather than the creation lists, which get rebuilt on the way;
+    // their order only matters to indices taken during a call, and no call is running here.
+    */
+    self->funclistcount = 0;
+    self->objlistcount = 0;
+    self->sbuflistcount = 0;
+    self->remlistcount = 0;
+}
+
+/*
+// a collection while statements are running must not move list entries up: the indices those
+// statements took would then cover objects created before them. drop the dead ones in place instead.
+*/
+static void ecc_mempool_filterlists(void)
+{
+    uint32_t index, count;
+    eccobjfunction_t* function;
+    eccobject_t* object;
+
+    for(index = count = 0; index < self->funclistcount; ++index)
+    {
+        function = self->funclistvals[index];
+        if(ecc_mempool_ismarked(ECC_MEMKIND_FUNCTION, function))
+        {
+            function->object.flags &= ~(ECC_OBJFLAG_YOUNG | ECC_OBJFLAG_REMEMBERED);
+            function->funcenv.flags &= ~(ECC_OBJFLAG_YOUNG | ECC_OBJFLAG_REMEMBERED);
+            self->funclistvals[count++] = function;
+        }
+    }
+    self->funclistcount = count;
+
+    for(index = count = 0; index < self->objlistcount; ++index)
+    {
+        object = self->objlistvals[index];
+        if(ecc_mempool_ismarked(ECC_MEMKIND_OBJECT, object))
+        {
+            object->flags &= ~(ECC_OBJFLAG_YOUNG | ECC_OBJFLAG_REMEMBERED);
+            self->objlistvals[count++] = object;
+        }
+        else if(object->type->fnfinalize)
+        {
+            /* as in ecc_mempool_sweepparallel, on this thread */
+            ecc_mempool_destroycell(ECC_MEMKIND_OBJECT, object);
+        }
+    }
+    self->objlistcount = count;
+
+    for(index = count = 0; index < self->sbuflistcount; ++index)
+        if(ecc_mempool_ismarked(ECC_MEMKIND_CHARS, self->sbuflistvals[index]))
+            self->sbuflistvals[count++] = self->sbuflistvals[index];
+
+    self->sbuflistcount = count;
+    self->remlistcount = 0;
+}
+
+#if ECC_CONF_PARALLELGC
+static uint32_t ecc_mempool_workercount(void)
+{
+    long online;
+
+    if(self->funclistcount + self->objlistcount < ECC_CONF_PARALLELGCMIN)
+        return 1;
+
+    if(self->threadcount)
+        return self->threadcount;
+
+    online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 1 ? (uint32_t)online : 1;
+}
+
+static int ecc_mempool_startworkers(uint32_t count)
+{
+    uint32_t index;
+
+    if(count <= 1)
+        return 0;
+
+    g_gcworkers = (eccgcworker_t*)calloc(count, sizeof(*g_gcworkers));
+    if(g_gcworkers == NULL)
+        return 0;
+
+    for(index = 0; index < count; ++index)
+    {
+        g_gcworkers[index].index = index;
+        pthread_mutex_init(&g_gcworkers[index].lock, NULL);
+    }
+    g_gcworkercount = count;
+    return 1;
+}
+
+static void ecc_mempool_stopworkers(void)
+{
+    uint32_t index;
+    eccmemslab_t* slab;
+
+    for(index = 0; index < g_gcworkercount; ++index)
+    {
+        while((slab = g_gcworkers[index].emptyslabs))
+        {
+            g_gcworkers[index].emptyslabs = slab->next;
+            slab->next = self->emptyslabs;
+            self->emptyslabs = slab;
+        }
+        pthread_mutex_destroy(&g_gcworkers[index].lock);
+        free(g_gcworkers[index].stackvals);
+        free(g_gcworkers[index].sharedvals);
+    }
+    free(g_gcworkers), g_gcworkers = NULL;
+    g_gcworkercount = 0;
+}
+
+/* runs 'routine' on every worker, the calling thread being the first one */
+static void ecc_mempool_runworkers(void* (*routine)(void*))
+{
+    uint32_t index;
+
+    for(index = 1; index < g_gcworkercount; ++index)
+    {
+        g_gcworkers[index].started = !pthread_create(&g_gcworkers[index].thread, NULL, routine, &g_gcworkers[index]);
+
+        /* a worker that could not start never has work, it is idle for good */
+        if(!g_gcworkers[index].started)
+            __atomic_add_fetch(&g_gcidlecount, 1, __ATOMIC_SEQ_CST);
+    }
+
+    routine(&g_gcworkers[0]);
+
+    for(index = 1; index < g_gcworkercount; ++index)
+        if(g_gcworkers[index].started)
+            pthread_join(g_gcworkers[index].thread, NULL);
+}
+
+static void ecc_mempool_sharework(eccgcworker_t* worker)
+{
+    uint32_t half = worker->stackcount / 2;
+
+    pthread_mutex_lock(&worker->lock);
+    ecc_mempool_growstack(&worker->sharedvals, &worker->sharedcapacity, worker->sharedcount + half);
+    memcpy(worker->sharedvals + worker->sharedcount, worker->stackvals, half * sizeof(*worker->stackvals));
+    __atomic_store_n(&worker->sharedcount, worker->sharedcount + half, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&worker->lock);
+
+    worker->stackcount -= half;
+    memmove(worker->stackvals, worker->stackvals + half, worker->stackcount * sizeof(*worker->stackvals));
+}
+
+/* takes back all of its own shared stack first, else half of another worker's */
+static int ecc_mempool_stealwork(eccgcworker_t* worker)
+{
+    uint32_t index, count, taken;
+    eccgcworker_t* victim;
+
+    for(index = 0; index < g_gcworkercount; ++index)
+    {
+        victim = &g_gcworkers[(worker->index + index) % g_gcworkercount];
+        if(!__atomic_load_n(&victim->sharedcount, __ATOMIC_ACQUIRE))
+            continue;
+
+        pthread_mutex_lock(&victim->lock);
+        count = victim->sharedcount;
+        taken = victim == worker ? count : (count + 1) / 2;
+        ecc_mempool_growstack(&worker->stackvals, &worker->stackcapacity, worker->stackcount + taken);
+        memcpy(worker->stackvals + worker->stackcount, victim->sharedvals + count - taken, taken * sizeof(*worker->stackvals));
+        worker->stackcount += taken;
+        __atomic_store_n(&victim->sharedcount, count - taken, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&victim->lock);
+
+        if(taken)
+            return 1;
+    }
+    return 0;
+}
+
+static int ecc_mempool_hassharedwork(void)
+{
+    uint32_t index;
+
+    for(index = 0; index < g_gcworkercount; ++index)
+        if(__atomic_load_n(&g_gcworkers[index].sharedcount, __ATOMIC_ACQUIRE))
+            return 1;
+
+    return 0;
+}
+
+static void* ecc_mempool_markworker(void* argument)
+{
+    eccgcworker_t* worker = (eccgcworker_t*)argument;
+
+    g_gcworker = worker;
+    for(;;)
+    {
+        while(worker->stackcount)
+        {
+            ecc_mempool_markmembers(worker->stackvals[--worker->stackcount]);
+
+            if(worker->stackcount > 1 && __atomic_load_n(&g_gcidlecount, __ATOMIC_RELAXED) && !__atomic_load_n(&worker->sharedcount, __ATOMIC_RELAXED))
+                ecc_mempool_sharework(worker);
+        }
+
+        if(ecc_mempool_stealwork(worker))
+            continue;
+
+        /*
+        // a worker only goes idle with its shared stack empty, and nobody else fills it:
+        // once every worker is idle, there is no work left anywhere.
+        */
+        __atomic_add_fetch(&g_gcidlecount, 1, __ATOMIC_SEQ_CST);
+        while(!ecc_mempool_hassharedwork())
+        {
+            if(__atomic_load_n(&g_gcidlecount, __ATOMIC_SEQ_CST) == g_gcworkercount)
+            {
+                g_gcworker = NULL;
+                return NULL;
+            }
+            sched_yield();
+        }
+        __atomic_sub_fetch(&g_gcidlecount, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+static void ecc_mempool_markparallel(void)
+{
+    eccgcworker_t* first = &g_gcworkers[0];
+
+    /* the gray list is where the first worker starts from */
+    first->stackvals = self->graylistvals;
+    first->stackcount = self->graylistcount;
+    first->stackcapacity = self->graylistcapacity;
+
+    g_gcidlecount = 0;
+    ecc_mempool_runworkers(ecc_mempool_markworker);
+
+    self->graylistvals = first->stackvals;
+    self->graylistcount = 0;
+    self->graylistcapacity = first->stackcapacity;
+    first->stackvals = NULL;
+}
+
+static void* ecc_mempool_sweepworker(void* argument)
+{
+    eccgcworker_t* worker = (eccgcworker_t*)argument;
+    uint32_t unit;
+
+    while((unit = __atomic_fetch_add(&g_gcnextunit, 1, __ATOMIC_RELAXED)) < ECC_MEMKIND_COUNT * ECC_MEMPOOL_CLASSCOUNT)
+        ecc_mempool_sweepclass((eccmemkind_t)(unit / ECC_MEMPOOL_CLASSCOUNT), unit % ECC_MEMPOOL_CLASSCOUNT, &worker->emptyslabs, g_gcrelist);
+
+    return NULL;
+}
+
+static void ecc_mempool_sweepparallel(int relist)
+{
+    uint32_t index;
+    eccobject_t* object;
+
+    /* string and regexp finalizers let go of a string buffer that other objects may share: run those on this thread */
+    if(relist)
+    {
+        for(index = 0; index < self->objlistcount; ++index)
+        {
+            object = self->objlistvals[index];
+            if(!(object->flags & ECC_OBJFLAG_MARK) && object->type->fnfinalize)
+                ecc_mempool_destroycell(ECC_MEMKIND_OBJECT, object);
+        }
+        ecc_mempool_clearlists();
+    }
+
+    g_gcnextunit = 0;
+    g_gcrelist = relist;
+    ecc_mempool_runworkers(ecc_mempool_sweepworker);
+}
+#endif
+
+void ecc_mempool_setthreads(uint32_t count)
+{
+    self->threadcount = count;
+}
+
+static int ecc_mempool_compareparent(const void* a, const void* b)
+{
+    const eccstrbuffer_t* left = (*(eccstrslice_t* const*)a)->parent;
+    const eccstrbuffer_t* right = (*(eccstrslice_t* const*)b)->parent;
+
+    return left < right ? -1 : left > right;
+}
+
+/*
+// parents nothing else reaches are kept for their live slices when those cover enough of them
+// (see ECC_CONF_SLICEPIN); otherwise each slice gets its own copy and the parent goes with the sweep.
+*/
+static void ecc_mempool_unpinslices(void)
+{
+    uint32_t index, count, first;
+    eccstrslice_t **slices, *slice;
+    eccstrbuffer_t *parent, *copy;
+    int64_t covered;
+
+    for(index = count = 0; index < self->sbuflistcount; ++index)
+    {
+        slice = (eccstrslice_t*)self->sbuflistvals[index];
+        if((slice->flags & (ECC_CHARBUFFLAG_SLICE | ECC_CHARBUFFLAG_MARK)) == (ECC_CHARBUFFLAG_SLICE | ECC_CHARBUFFLAG_MARK)
+           && !(slice->parent->flags & ECC_CHARBUFFLAG_MARK))
+            ++count;
+    }
+    if(!count)
+        return;
+
+    slices = (eccstrslice_t**)malloc(count * sizeof(*slices));
+    if(slices == NULL)
+    {
+        /* keep them all */
+        for(index = 0; index < self->sbuflistcount; ++index)
+        {
+            slice = (eccstrslice_t*)self->sbuflistvals[index];
+            if((slice->flags & (ECC_CHARBUFFLAG_SLICE | ECC_CHARBUFFLAG_MARK)) == (ECC_CHARBUFFLAG_SLICE | ECC_CHARBUFFLAG_MARK))
+                slice->parent->flags |= ECC_CHARBUFFLAG_MARK;
+        }
+        return;
+    }
+
+    for(index = count = 0; index < self->sbuflistcount; ++index)
+    {
+        slice = (eccstrslice_t*)self->sbuflistvals[index];
+        if((slice->flags & (ECC_CHARBUFFLAG_SLICE | ECC_CHARBUFFLAG_MARK)) == (ECC_CHARBUFFLAG_SLICE | ECC_CHARBUFFLAG_MARK)
+           && !(slice->parent->flags & ECC_CHARBUFFLAG_MARK))
+            slices[count++] = slice;
+    }
+    qsort(slices, count, sizeof(*slices), ecc_mempool_compareparent);
+
+    for(first = 0; first < count; first = index)
+    {
+        parent = slices[first]->parent;
+        for(index = first, covered = 0; index < count && slices[index]->parent == parent; ++index)
+            covered += slices[index]->length;
+
+        if(covered * ECC_CONF_SLICEPIN >= parent->length)
+        {
+            parent->flags |= ECC_CHARBUFFLAG_MARK;
+            continue;
+        }
+
+        for(index = first; index < count && slices[index]->parent == parent; ++index)
+        {
+            slice = slices[index];
+            copy = ecc_strbuf_createwithbytes(slice->length, parent->bytes + slice->offset);
+            copy->flags |= ECC_CHARBUFFLAG_MARK;
+            ++copy->refcount;
+            slice->parent = copy;
+            slice->offset = 0;
+        }
+    }
+    free(slices);
+}
+
+static void ecc_mempool_stopconservative(void)
+{
+    self->conservative = 0;
+    free(self->largesortedvals), self->largesortedvals = NULL;
+    self->largesortedcount = 0;
+}
+
+static void ecc_mempool_collect(int keeporder)
+{
+    uint32_t kind, sizeclass;
+    eccmemslab_t* slab;
+    eccmemlarge_t *large, *next;
+
+#if ECC_CONF_PARALLELGC
+    if(ecc_mempool_startworkers(ecc_mempool_workercount()))
+    {
+        ecc_mempool_markparallel();
+        ecc_mempool_unpinslices();
+        if(keeporder)
+            ecc_mempool_filterlists();
+
+        ecc_mempool_sweepparallel(!keeporder);
+        ecc_mempool_stopworkers();
+    }
+    else
+#endif
+    {
+        ecc_mempool_markstep(UINT32_MAX);
+        ecc_mempool_unpinslices();
+        if(keeporder)
+            ecc_mempool_filterlists();
+        else
+            ecc_mempool_clearlists();
+
+        for(kind = 0; kind < ECC_MEMKIND_COUNT; ++kind)
+            for(sizeclass = 0; sizeclass < ECC_MEMPOOL_CLASSCOUNT; ++sizeclass)
+                ecc_mempool_sweepclass((eccmemkind_t)kind, sizeclass, &self->emptyslabs, !keeporder);
+    }
+    self->marking = 0;
+    ecc_mempool_stopconservative();
+
+    for(large = self->largechars; large; large = next)
+    {
+        next = large->next;
+        if(!(((eccstrbuffer_t*)(large + 1))->flags & ECC_CHARBUFFLAG_MARK))
+            ecc_strbuf_destroy((eccstrbuffer_t*)(large + 1));
+        else if(!keeporder)
+            ecc_mempool_relist(ECC_MEMKIND_CHARS, large + 1, ecc_mempool_reservelist(ECC_MEMKIND_CHARS, 1));
+    }
+
+    self->slabcount = 0;
+    for(kind = 0; kind < ECC_MEMKIND_COUNT; ++kind)
+        for(sizeclass = 0; sizeclass < ECC_MEMPOOL_CLASSCOUNT; ++sizeclass)
+            for(slab = self->slabs[kind][sizeclass]; slab; slab = slab->next)
+                ++self->slabcount;
+
+    self->collectpending = 0;
+    ecc_mempool_getindices(self->youngindices);
+}
+
+void ecc_mempool_collectunmarked(void)
+{
+    ecc_mempool_collect(0);
+}
+
+/* like ecc_mempool_collectunmarked, for collections while statements are running (see ecc_mempool_filterlists) */
+void ecc_mempool_collectunmarkedinorder(void)
+{
+    ecc_mempool_collect(1);
+}
+
+void ecc_mempool_collectunreferencedfromindices(uint32_t indices[3])
+{
+    uint32_t index;
+
+    /* prepare */
+
+    index = self->objlistcount;
+    while(index-- > indices[1])
+        if(self->objlistvals[index]->refcount <= 0)
+            ecc_mempool_cleanupobject(self->objlistvals[index]);
+
+    index = self->objlistcount;
+    while(index-- > indices[1])
+        if(self->objlistvals[index]->refcount > 0 && !(self->objlistvals[index]->flags & ECC_OBJFLAG_CAPTURED))
+        {
+            self->objlistvals[index]->flags |= ECC_OBJFLAG_CAPTURED;
+            ecc_mempool_captureobject(self->objlistvals[index]);
+        }
+
+    /* destroy */
+
+    index = self->funclistcount;
+    while(index-- > indices[0])
+        if(!self->funclistvals[index]->object.refcount && !self->funclistvals[index]->funcenv.refcount)
+        {
+            ecc_function_destroy(self->funclistvals[index]);
+            self->funclistvals[index] = self->funclistvals[--self->funclistcount];
+        }
+
+    index = self->objlistcount;
+    while(index-- > indices[1])
         if(self->objlistvals[index]->refcount <= 0)
         {
             ecc_object_finalize(self->objlistvals[index]);
@@ -346,3 +1397,404 @@ void ecc_mempool_getindices(uint32_t indices[3])
     indices[1] = self->objlistcount;
     indices[2] = self->sbuflistcount;
 }
+
+void ecc_mempool_remember(eccobject_t* object)
+{
+    size_t needed;
+    eccobject_t** tmp;
+    if(self->remlistcount >= self->remlistcapacity)
+    {
+        self->remlistcapacity = self->remlistcapacity ? self->remlistcapacity * 2 : 64;
+        needed = (self->remlistcapacity * sizeof(*self->remlistvals));
+        tmp = (eccobject_t**)realloc(self->remlistvals, needed);
+        if(tmp == NULL)
+        {
+            fprintf(stderr, "in remember: failed to reallocate for %ld bytes\n", needed);
+        }
+        self->remlistvals = tmp;
+    }
+    object->flags |= ECC_OBJFLAG_REMEMBERED;
+    self->remlistvals[self->remlistcount++] = object;
+}
+
+/* the live slab cell 'address' points into, if any */
+static void* ecc_mempool_cellof(const void* address)
+{
+    eccmemslab_t* slab;
+    size_t index;
+
+    if(!ecc_mempool_isslabcell(address))
+        return NULL;
+
+    /* the slabs left in the newest arena are not carved yet, their headers hold garbage */
+    if(self->arenaleft && (const char*)address >= self->arenanext && (const char*)address < self->arenanext + (size_t)self->arenaleft * ECC_CONF_SLABSIZE)
+        return NULL;
+
+    slab = ecc_mempool_slabof(address);
+    if((const char*)address < (char*)slab + slab->celloffset)
+        return NULL;
+
+    index = ((const char*)address - ((char*)slab + slab->celloffset)) / slab->cellsize;
+    if(index >= slab->bumpcount || !ecc_mempool_islive(slab, index))
+        return NULL;
+
+    return ecc_mempool_cellat(slab, index);
+}
+
+static int ecc_mempool_isliveobject(eccobject_t* object)
+{
+    char* cell;
+    size_t offset;
+
+    /* barriers may have seen objects on the C stack or since destroyed: only trust live slab cells */
+    cell = (char*)ecc_mempool_cellof(object);
+    if(!cell || ecc_mempool_slabof(cell)->kind == ECC_MEMKIND_CHARS)
+        return 0;
+
+    /* function copies are carved from object slabs */
+    offset = (char*)object - cell;
+    return offset == 0 || (offset == offsetof(eccobjfunction_t, funcenv) && ((eccobject_t*)cell)->type == &ECC_Type_Function);
+}
+
+void ecc_mempool_escape(eccvalue_t value)
+{
+    if(self->marking)
+    {
+        /* may be a copy on the C stack */
+        if(value.type < ECC_VALTYPE_OBJECT || ecc_mempool_isliveobject(value.data.object))
+            ecc_mempool_markvalue(value);
+    }
+    else if(value.type >= ECC_VALTYPE_OBJECT && (value.data.object->flags & (ECC_OBJFLAG_YOUNG | ECC_OBJFLAG_REMEMBERED)) == ECC_OBJFLAG_YOUNG)
+        ecc_mempool_remember(value.data.object);
+}
+
+void ecc_mempool_markroot(eccvalue_t value)
+{
+    if(value.type < ECC_VALTYPE_OBJECT)
+        ecc_mempool_markvalue(value);
+    else if(value.data.object->flags & ECC_OBJFLAG_YOUNG)
+        ecc_mempool_markobject(value.data.object);
+    else
+    {
+        /* old roots stay marked between collections, look at what they hold */
+        ecc_mempool_markmembers(value.data.object);
+        if(value.type == ECC_VALTYPE_FUNCTION)
+            ecc_mempool_markmembers(&value.data.function->funcenv);
+    }
+}
+
+/* function templates, literals and parse errors live in the values of the ops: marked once a collection, however many closures share them */
+void ecc_mempool_markoplist(eccoplist_t* oplist)
+{
+    uint32_t index, count;
+
+#if ECC_CONF_PARALLELGC
+    if(g_gcworker)
+    {
+        if(__atomic_exchange_n(&oplist->markepoch, self->markepoch, __ATOMIC_RELAXED) == self->markepoch)
+            return;
+    }
+    else
+#endif
+    {
+        if(oplist->markepoch == self->markepoch)
+            return;
+
+        oplist->markepoch = self->markepoch;
+    }
+
+    for(index = 0, count = oplist->count; index < count; ++index)
+        ecc_mempool_markvalue(oplist->ops[index].opvalue);
+}
+
+static void ecc_mempool_markaddress(const void* address)
+{
+    void* cell;
+
+    if(!(cell = ecc_mempool_cellof(address)))
+        return;
+
+    /* function copies in object slabs have the function type, which marks their environment */
+    if(ecc_mempool_slabof(cell)->kind == ECC_MEMKIND_CHARS)
+        ecc_mempool_markchars((eccstrbuffer_t*)cell);
+    else
+        ecc_mempool_markobject((eccobject_t*)cell);
+}
+
+static int ecc_mempool_compareaddress(const void* a, const void* b)
+{
+    uintptr_t x = (uintptr_t)*(eccmemlarge_t* const*)a, y = (uintptr_t)*(eccmemlarge_t* const*)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* the big string buffer 'address' points into, if any */
+static eccmemlarge_t* ecc_mempool_largeof(const void* address)
+{
+    uint32_t lower = 0, upper = self->largesortedcount, middle;
+    eccmemlarge_t* large;
+
+    if(!upper)
+        return NULL;
+
+    while(upper - lower > 1)
+    {
+        middle = (lower + upper) / 2;
+        if((const char*)address < (const char*)self->largesortedvals[middle])
+            upper = middle;
+        else
+            lower = middle;
+    }
+    large = self->largesortedvals[lower];
+    if((const char*)address >= (const char*)(large + 1) && (const char*)address < (const char*)(large + 1) + large->size)
+        return large;
+
+    return NULL;
+}
+
+/*
+// from here to the end of the collection, marks only follow pointers to live cells:
+// a word that happens to point to garbage the unreferenced cleanup already took apart must not be walked.
+*/
+static void ecc_mempool_startconservative(void)
+{
+    uint32_t count = 0;
+    eccmemlarge_t* large;
+
+    if(self->conservative)
+        return;
+
+    self->conservative = 1;
+    for(large = self->largechars; large; large = large->next)
+        ++count;
+
+    if(count && (self->largesortedvals = (eccmemlarge_t**)malloc(count * sizeof(*self->largesortedvals))))
+    {
+        for(count = 0, large = self->largechars; large; large = large->next)
+            self->largesortedvals[count++] = large;
+
+        qsort(self->largesortedvals, count, sizeof(*self->largesortedvals), ecc_mempool_compareaddress);
+        self->largesortedcount = count;
+    }
+}
+
+static int ecc_mempool_islivechars(eccstrbuffer_t* chars)
+{
+    eccmemlarge_t* large;
+
+    if(ecc_mempool_isslabcell(chars))
+        return ecc_mempool_cellof(chars) == (void*)chars && ecc_mempool_slabof(chars)->kind == ECC_MEMKIND_CHARS;
+
+    large = ecc_mempool_largeof(chars);
+    return large && (void*)(large + 1) == (void*)chars;
+}
+
+/*
+// conservatively marks every cell a pointer sized word between 'from' and 'to' points into,
+// for collections while C frames hold values the roots do not know about.
+*/
+#if defined(__GNUC__)
+__attribute__((no_sanitize_address))
+#endif
+void ecc_mempool_markrange(const void* from, const void* to)
+{
+    const void* const* word;
+    const void* swap;
+    eccmemlarge_t* large;
+
+    if(from > to)
+        swap = from, from = to, to = swap;
+
+    ecc_mempool_startconservative();
+
+    word = (const void* const*)(((uintptr_t)from + sizeof(void*) - 1) & ~(uintptr_t)(sizeof(void*) - 1));
+    for(; (const void*)(word + 1) <= to; ++word)
+    {
+        if(ecc_mempool_isslabcell(*word))
+            ecc_mempool_markaddress(*word);
+        else if((large = ecc_mempool_largeof(*word)))
+            ecc_mempool_markchars((eccstrbuffer_t*)(large + 1));
+    }
+}
+
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+static void ecc_mempool_markstackfrom(const void* base)
+{
+    const void* top = &top;
+
+    ecc_mempool_markrange(top, base);
+}
+
+/* marks what the C stack between the caller and 'base' may point to, registers included */
+void ecc_mempool_markstack(const void* base)
+{
+    jmp_buf registers;
+
+#if defined(__GNUC__)
+    __builtin_unwind_init();
+#endif
+    if(!setjmp(registers))
+        ecc_mempool_markstackfrom(base);
+}
+
+void ecc_mempool_unmarkyoung(void)
+{
+    uint32_t index;
+
+    ++self->markepoch;
+
+    for(index = self->youngindices[0]; index < self->funclistcount; ++index)
+    {
+        self->funclistvals[index]->object.flags &= ~ECC_OBJFLAG_MARK;
+        self->funclistvals[index]->funcenv.flags &= ~ECC_OBJFLAG_MARK;
+    }
+
+    for(index = self->youngindices[1]; index < self->objlistcount; ++index)
+    {
+        self->objlistvals[index]->flags &= ~ECC_OBJFLAG_MARK;
+        if(self->objlistvals[index]->type == &ECC_Type_Function)
+            ((eccobjfunction_t*)self->objlistvals[index])->funcenv.flags &= ~ECC_OBJFLAG_MARK;
+    }
+}
+
+void ecc_mempool_collectyoung(void)
+{
+    uint32_t index;
+    eccobject_t* object;
+
+    /*
+    // old objects are always marked, so marking stops at them: what they gained since
+    // the last collection comes from the remembered set. string buffers are left to
+    // the full collection and the unreferenced cleanup.
+    */
+    for(index = 0; index < self->remlistcount; ++index)
+    {
+        object = self->remlistvals[index];
+        if(!ecc_mempool_isliveobject(object) || !(object->flags & ECC_OBJFLAG_REMEMBERED))
+            continue;
+
+        object->flags &= ~ECC_OBJFLAG_REMEMBERED;
+        if(object->flags & ECC_OBJFLAG_YOUNG)
+            ecc_mempool_markobject(object);
+        else
+            ecc_mempool_markmembers(object);
+    }
+    self->remlistcount = 0;
+    ecc_mempool_markstep(UINT32_MAX);
+
+    /* finalize & destroy */
+
+    if(self->youngindices[0] > self->funclistcount)
+        self->youngindices[0] = self->funclistcount;
+
+    if(self->youngindices[1] > self->objlistcount)
+        self->youngindices[1] = self->objlistcount;
+
+    index = self->funclistcount;
+    while(index-- > self->youngindices[0])
+        if(!(self->funclistvals[index]->object.flags & ECC_OBJFLAG_MARK) && !(self->funclistvals[index]->funcenv.flags & ECC_OBJFLAG_MARK))
+        {
+            ecc_function_destroy(self->funclistvals[index]);
+            self->funclistvals[index] = self->funclistvals[--self->funclistcount];
+        }
+
+    index = self->objlistcount;
+    while(index-- > self->youngindices[1])
+        if(!(self->objlistvals[index]->flags & ECC_OBJFLAG_MARK))
+        {
+            ecc_object_finalize(self->objlistvals[index]);
+            ecc_object_destroy(self->objlistvals[index]);
+            self->objlistvals[index] = self->objlistvals[--self->objlistcount];
+        }
+
+    /* promote */
+
+    for(index = self->youngindices[0]; index < self->funclistcount; ++index)
+    {
+        self->funclistvals[index]->object.flags &= ~(ECC_OBJFLAG_YOUNG | ECC_OBJFLAG_REMEMBERED);
+        self->funclistvals[index]->funcenv.flags &= ~(ECC_OBJFLAG_YOUNG | ECC_OBJFLAG_REMEMBERED);
+    }
+
+    for(index = self->youngindices[1]; index < self->objlistcount; ++index)
+        self->objlistvals[index]->flags &= ~(ECC_OBJFLAG_YOUNG | ECC_OBJFLAG_REMEMBERED);
+
+    self->youngindices[0] = self->funclistcount;
+    self->youngindices[1] = self->objlistcount;
+    ecc_mempool_stopconservative();
+}
+
+/*
+// an incremental mark starts from everything unmarked and ends in ecc_mempool_finishmark.
+// marked objects given a reference in between are looked at again there, and values stored
+// where the owner is not known get marked right away: no young collection may run until then.
+*/
+void ecc_mempool_startmark(void)
+{
+    uint32_t index;
+
+    ecc_mempool_unmarkall();
+
+    for(index = 0; index < self->remlistcount; ++index)
+        if(ecc_mempool_isliveobject(self->remlistvals[index]))
+            self->remlistvals[index]->flags &= ~ECC_OBJFLAG_REMEMBERED;
+
+    self->remlistcount = 0;
+
+    for(index = self->youngindices[0]; index < self->funclistcount; ++index)
+    {
+        self->funclistvals[index]->object.flags &= ~ECC_OBJFLAG_YOUNG;
+        self->funclistvals[index]->funcenv.flags &= ~ECC_OBJFLAG_YOUNG;
+    }
+
+    for(index = self->youngindices[1]; index < self->objlistcount; ++index)
+        self->objlistvals[index]->flags &= ~ECC_OBJFLAG_YOUNG;
+
+    ecc_mempool_getindices(self->youngindices);
+    self->marking = 1;
+}
+
+
+void ecc_mempool_finishmark(void)
+{
+    uint32_t index;
+    eccobject_t* object;
+
+    for(index = 0; index < self->remlistcount; ++index)
+    {
+        object = self->remlistvals[index];
+        if(!ecc_mempool_isliveobject(object) || !(object->flags & ECC_OBJFLAG_REMEMBERED))
+            continue;
+
+        object->flags &= ~ECC_OBJFLAG_REMEMBERED;
+        if(object->flags & ECC_OBJFLAG_MARK)
+            ecc_mempool_markmembers(object);
+    }
+    self->remlistcount = 0;
+
+    /* stores into objects created since the mark started are not remembered: look again at the ones reached */
+    for(index = self->youngindices[0]; index < self->funclistcount; ++index)
+    {
+        if(self->funclistvals[index]->object.flags & ECC_OBJFLAG_MARK)
+            ecc_mempool_markmembers(&self->funclistvals[index]->object);
+
+        if(self->funclistvals[index]->funcenv.flags & ECC_OBJFLAG_MARK)
+            ecc_mempool_markmembers(&self->funclistvals[index]->funcenv);
+    }
+
+    for(index = self->youngindices[1]; index < self->objlistcount; ++index)
+        if(self->objlistvals[index]->flags & ECC_OBJFLAG_MARK)
+            ecc_mempool_markmembers(self->objlistvals[index]);
+
+    ecc_mempool_markstep(UINT32_MAX);
+
+    /* string buffers are not looked at by young collections: keep the new ones for the next cycle */
+    for(index = self->youngindices[2]; index < self->sbuflistcount; ++index)
+        ecc_mempool_markchars(self->sbuflistvals[index]);
+}
+
+int ecc_mempool_ismarking(void)
+{
+    return self->marking;
+}
@@ -0,0 +1,32 @@
+/*
+ * dictionary benchmark: objects with more members than a shape holds
+ * (see ECC_CONF_MAXSHAPEMEMBERS) keep a hashed member index;
+ * times filling and reading them back. compare peak RSS for bytes per property.
+ * usage: run propbench.js [objects] [members per object]
+ */
+var count = +(arguments[0] || 20000);
+var members = +(arguments[1] || 40);
+var names = [], all = [], sum = 0, i, j, o;
+for (j = 0; j < members; ++j)
+    names[j] = 'field' + j;
+
+var start = (new Date).getTime();
+for (i = 0; i < count; ++i)
+{
+    o = {};
+    for (j = 0; j < members; ++j)
+        o[names[j]] = j;
+
+    all[i] = o;
+}
+var filled = (new Date).getTime();
+for (var r = 0; r < 5; ++r)
+    for (i = 0; i < count; ++i)
+    {
+        o = all[i];
+        for (j = 0; j < members; ++j)
+            sum += o[names[j]];
+    }
+
+var elapsed = (new Date).getTime() - filled;
+println(count * members + " properties: fill " + (filled - start) + " ms, " + (elapsed * 1e6 / (5 * count * members)).toFixed(0) + " ns/lookup (" + sum + ")");
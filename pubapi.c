@@ -11,6 +11,8 @@
 
 static int instanceCount = 0;
 
+static void ecc_script_updatecollectpolicy(eccstate_t* self);
+
 void ecc_script_addinput(eccstate_t* self, eccioinput_t* input)
 {
     size_t needed;
@@ -33,6 +35,7 @@ eccstate_t* ecc_script_create(void)
     {
         ecc_env_setup();
         ecc_mempool_setup();
+        ecc_shape_setup();
         ecc_keyidx_setup();
         ecc_globals_setup();
     }
@@ -41,6 +44,13 @@ eccstate_t* ecc_script_create(void)
 
     self->globalfunc = ecc_globals_create();
     self->maximumCallDepth = ECC_CONF_MAXCALLDEPTH;
+    self->dispatchLoop = ECC_CONF_DISPATCHLOOP;
+    self->jit = ECC_CONF_JIT;
+    self->fusion = ECC_CONF_FUSION;
+    self->gcThreads = ECC_CONF_GCTHREADS;
+    self->gcAuto = ECC_CONF_GCAUTO;
+    self->gcGrowthPercent = ECC_CONF_GCGROWTH;
+    self->gcMinimumHeap = ECC_CONF_GCMINIMUMHEAP;
 
     return self;
 }
@@ -54,6 +64,7 @@ void ecc_script_destroy(eccstate_t* self)
 
     free(self->inputs), self->inputs = NULL;
     free(self->envList), self->envList = NULL;
+    free(self->tailValues), self->tailValues = NULL;
     free(self), self = NULL;
 
     if(!--instanceCount)
@@ -61,7 +72,11 @@ void ecc_script_destroy(eccstate_t* self)
         ecc_globals_teardown();
         ecc_keyidx_teardown();
         ecc_mempool_teardown();
+        ecc_shape_teardown();
         ecc_env_teardown();
+#if ECC_CONF_JIT
+        ecc_jit_teardown();
+#endif
     }
 }
 
@@ -81,7 +96,7 @@ void ecc_script_addvalue(eccstate_t* self, const char* name, eccvalue_t value, i
 
 int ecc_script_evalinput(eccstate_t* self, eccioinput_t* input, int flags)
 {
-    int result = EXIT_SUCCESS, trap = !self->envCount || flags & ECC_SCRIPTEVAL_PRIMITIVERESULT, catchpos = 0;
+    int result = EXIT_SUCCESS, trap = !self->envCount || flags & ECC_SCRIPTEVAL_PRIMITIVERESULT, catchpos = 0, outermost = !self->gcStackBase;
     ecccontext_t context = {};
     context.execenv = &self->globalfunc->funcenv;
     context.thisvalue = ecc_value_object(&self->globalfunc->funcenv);
@@ -93,6 +108,13 @@ int ecc_script_evalinput(eccstate_t* self, eccioinput_t* input, int flags)
 
     self->sloppyMode = flags & ECC_SCRIPTEVAL_SLOPPYMODE;
 
+    /* automatic collections scan the C stack from here on */
+    if(outermost)
+    {
+        self->gcStackBase = &context;
+        ecc_script_updatecollectpolicy(self);
+    }
+
     if(trap)
     {
         self->printLastThrow = 1;
@@ -121,6 +143,9 @@ int ecc_script_evalinput(eccstate_t* self, eccioinput_t* input, int flags)
         self->printLastThrow = 0;
     }
 
+    if(outermost)
+        self->gcStackBase = NULL;
+
     return result;
 }
 
@@ -128,7 +153,8 @@ void ecc_script_evalinputwithcontext(eccstate_t* self, eccioinput_t* input, eccc
 {
     eccastlexer_t* lexer;
     eccastparser_t* parser;
-    eccobjfunction_t* function;
+    /* the running ops belong to it: kept on the stack for automatic collections to find */
+    eccobjfunction_t* volatile function;
 
     assert(self);
     assert(self->envCount);
@@ -137,6 +163,8 @@ void ecc_script_evalinputwithcontext(eccstate_t* self, eccioinput_t* input, eccc
 
     lexer = ecc_astlex_createwithinput(input);
     parser = ecc_astparse_createwithlexer(lexer);
+    parser->fusion = self->fusion;
+    parser->fusionReport = self->fusionReport;
 
     if(context->isstrictmode)
         parser->isstrictmode = 1;
@@ -155,7 +183,15 @@ void ecc_script_evalinputwithcontext(eccstate_t* self, eccioinput_t* input, eccc
     */
     self->result = ECCValConstUndefined;
 
-    context->ops->native(context);
+#if ECC_CONF_DISPATCHLOOP
+    if(self->dispatchLoop)
+        ecc_oper_dispatch(context);
+    else
+#endif
+        context->ops->native(context);
+
+    /* not a tail call: the frame holding 'function' stays until the ops return */
+    function = NULL;
 }
 
 jmp_buf* ecc_script_pushenv(eccstate_t* self)
@@ -253,12 +289,23 @@ void ecc_script_printtextinput(eccstate_t* self, eccstrbox_t text, int fullLine)
     ecc_ioinput_printtext(ecc_script_findinput(self, text), text, ofLine, ofText, ofInput, fullLine);
 }
 
-void ecc_script_garbagecollect(eccstate_t* self)
+/* the heap may outgrow what a full collection left by gcGrowthPercent, or up to gcMinimumHeap, before the next automatic one */
+static void ecc_script_updatecollectpolicy(eccstate_t* self)
+{
+    size_t bytes = ecc_mempool_heapbytes() / 100 * self->gcGrowthPercent;
+
+    if(!self->gcAuto)
+        ecc_mempool_setcollectbytes(0);
+    else
+        ecc_mempool_setcollectbytes(bytes > self->gcMinimumHeap ? bytes : self->gcMinimumHeap);
+}
+
+static void ecc_script_markroots(eccstate_t* self)
 {
     uint32_t index, count;
-    ecc_mempool_unmarkall();
     ecc_mempool_markvalue(ecc_value_object(ECC_Prototype_Arguments));
     ecc_mempool_markvalue(ecc_value_function(self->globalfunc));
+    ecc_mempool_markvalue(self->result);
     for(index = 0, count = self->inputCount; index < count; ++index)
     {
         eccioinput_t* input = self->inputs[index];
@@ -267,6 +314,98 @@ void ecc_script_garbagecollect(eccstate_t* self)
         while(a--)
             ecc_mempool_markvalue(input->attached[a]);
     }
+}
+
+/* within an evaluation, values the interpreter holds in C frames are found by scanning the stack conservatively */
+static void ecc_script_markframes(eccstate_t* self)
+{
+    if(!self->gcStackBase)
+        return;
+
+    ecc_mempool_markrange(self->envList, self->envList + self->envCount);
+    ecc_mempool_markstack(self->gcStackBase);
+}
+
+/* sweeps what was left unmarked; within an evaluation the lists keep their order for the statements still running, and keys and shapes are left alone */
+static void ecc_script_sweep(eccstate_t* self)
+{
+    ecc_mempool_setthreads(self->gcThreads);
+    if(self->gcStackBase)
+        ecc_mempool_collectunmarkedinorder();
+    else
+    {
+        ecc_mempool_collectunmarked();
+        ecc_keyidx_collectunmarked();
+        ecc_shape_collectunmarked();
+    }
+    ecc_script_updatecollectpolicy(self);
+}
+
+/* full collection, between evaluations or from a native function */
+void ecc_script_garbagecollect(eccstate_t* self)
+{
+    ecc_mempool_unmarkall();
+    ecc_script_markroots(self);
+    ecc_script_markframes(self);
+    ecc_script_sweep(self);
+}
+
+/* full collection from a safe point within an evaluation, once the heap outgrew the policy */
+void ecc_script_autocollect(eccstate_t* self)
+{
+    if(!self->gcAuto || !self->gcStackBase || !ecc_mempool_collectpending() || ecc_mempool_ismarking())
+        return;
+
+    ecc_script_garbagecollect(self);
+}
+
+/*
+// minor collection: only objects created since the last collection are looked at and swept,
+// survivors become old. like ecc_script_garbagecollect, between evaluations or from a native function.
+*/
+void ecc_script_collectyoung(eccstate_t* self)
+{
+    uint32_t index, count;
+    if(ecc_mempool_ismarking())
+        return;
+
+    ecc_mempool_unmarkyoung();
+    ecc_mempool_markroot(ecc_value_object(ECC_Prototype_Arguments));
+    ecc_mempool_markroot(ecc_value_function(self->globalfunc));
+    ecc_mempool_markroot(self->result);
+    for(index = 0, count = self->inputCount; index < count; ++index)
+    {
+        eccioinput_t* input = self->inputs[index];
+        uint32_t a = input->attachedCount;
+
+        while(a--)
+            ecc_mempool_markroot(input->attached[a]);
+    }
+    ecc_script_markframes(self);
+
+    ecc_mempool_collectyoung();
+}
+
+/*
+// incremental collection: each call marks up to 'budget' objects, the first one starting
+// a new cycle, the last one sweeping and returning 1. objects created in between survive
+// the cycle, and young collections are skipped meanwhile.
+*/
+int ecc_script_collectstep(eccstate_t* self, uint32_t budget)
+{
+    if(!ecc_mempool_ismarking())
+    {
+        ecc_mempool_startmark();
+        ecc_script_markroots(self);
+    }
+
+    if(!ecc_mempool_markstep(budget))
+        return 0;
 
-    ecc_mempool_collectunmarked();
+    /* roots may have been attached since */
+    ecc_script_markroots(self);
+    ecc_script_markframes(self);
+    ecc_mempool_finishmark();
+    ecc_script_sweep(self);
+    return 1;
 }
@@ -0,0 +1,25 @@
+/*
+ * concatenation benchmark: builds one big string with += (see ECC_CONF_ROPELENGTH),
+ * then reads it back once so the rope is flattened.
+ * usage: run ropebench.js [megabytes] [bytes per piece]
+ */
+var megabytes = +(arguments[0] || 50);
+var piece = +(arguments[1] || 64);
+var chunk = '', s = '', count = 0, total = megabytes * 1024 * 1024, i;
+for (i = 0; i < piece - 1; ++i)
+    chunk += String.fromCharCode(97 + i % 26);
+
+chunk += '\n';
+
+var start = (new Date).getTime();
+while (count * piece < total)
+{
+    s += chunk;
+    ++count;
+}
+var built = (new Date).getTime();
+var lines = s.split('\n').length - 1;
+if (lines != count || s.length != count * piece)
+    throw Error(s.length + ' bytes in ' + lines + ' lines, expected ' + count);
+
+println(s.length + " bytes in " + count + " pieces: build " + (built - start) + " ms, read " + ((new Date).getTime() - built) + " ms");
@@ -0,0 +1,22 @@
+/*
+ * search benchmark: indexOf, lastIndexOf and split with a string separator
+ * over a long text with characters beyond ASCII (see ecc_strbox_find).
+ * usage: run searchbench.js [units] [rounds]
+ */
+var units = +(arguments[0] || 1000000);
+var rounds = +(arguments[1] || 20);
+var parts = [], i, r, found = 0, start;
+for (i = 0; i * 16 < units; ++i)
+    parts[i] = (i % 100 == 0) ? 'le café, ferme;' : 'the quick brown;';
+
+var s = parts.join('') + 'needle';
+
+start = (new Date).getTime();
+for (r = 0; r < rounds; ++r)
+    found += s.indexOf('needle') + s.indexOf('needle', r) + s.lastIndexOf('the quick', s.length - r * 100);
+
+var searched = (new Date).getTime();
+for (r = 0; r < rounds / 4; ++r)
+    found += s.split(';').length + s.split('café').length;
+
+println(s.length + " units: indexOf/lastIndexOf " + (searched - start) + " ms, split " + ((new Date).getTime() - searched) + " ms (" + found + ")");
@@ -0,0 +1,268 @@
+/*
+//  shape.c
+//  libecc
+//
+//  Licensed under MIT license, see LICENSE.txt file in project root
+*/
+#include "ecc.h"
+
+/*
+// a shape describes the members of an object by the order they were added in:
+// the member added at shape 'parent' lives in hmapmapitems[2 + parent->count].
+// shapes are shared between objects and never change once created,
+// objects move along the transition tree when they gain a member.
+// full collections between evaluations drop the branches no live object holds.
+*/
+
+/* up to this many members, a lookup walks the parent chain instead of building a table */
+#define ECC_SHAPE_LINEARCOUNT 8
+
+static eccshape_t g_shaperoot;
+static uint32_t g_shapecount = 0;
+
+static uint32_t ecc_shape_hashkey(eccindexkey_t key)
+{
+    return key.data.integer * UINT32_C(2654435761);
+}
+
+static void ecc_shape_destroytree(eccshape_t* self)
+{
+    uint32_t index;
+    if(self->transitions)
+    {
+        for(index = 0; index <= self->transitionmask; ++index)
+        {
+            if(self->transitions[index])
+            {
+                ecc_shape_destroytree(self->transitions[index]);
+                free(self->transitions[index]);
+                --g_shapecount;
+            }
+        }
+    }
+    free(self->transitions), self->transitions = NULL;
+    free(self->table), self->table = NULL;
+}
+
+void ecc_shape_setup(void)
+{
+    memset(&g_shaperoot, 0, sizeof(g_shaperoot));
+    g_shapecount = 1;
+}
+
+void ecc_shape_teardown(void)
+{
+    ecc_shape_destroytree(&g_shaperoot);
+    memset(&g_shaperoot, 0, sizeof(g_shaperoot));
+    g_shapecount = 0;
+}
+
+eccshape_t* ecc_shape_root(void)
+{
+    return &g_shaperoot;
+}
+
+uint32_t ecc_shape_count(void)
+{
+    return g_shapecount;
+}
+
+static void ecc_shape_buildtable(eccshape_t* self)
+{
+    uint32_t size;
+    uint32_t index;
+    const eccshape_t* shape;
+    size = 16;
+    while(size < self->count * 2)
+    {
+        size *= 2;
+    }
+    self->table = (eccshapeentry_t*)calloc(size, sizeof(*self->table));
+    self->tablemask = size - 1;
+    for(shape = self; shape->parent; shape = shape->parent)
+    {
+        index = ecc_shape_hashkey(shape->key) & self->tablemask;
+        while(self->table[index].slot)
+        {
+            index = (index + 1) & self->tablemask;
+        }
+        self->table[index].key = shape->key;
+        self->table[index].slot = shape->parent->count + 2;
+    }
+}
+
+uint32_t ecc_shape_find(eccshape_t* self, eccindexkey_t key)
+{
+    uint32_t index;
+    const eccshape_t* shape;
+    if(self->count <= ECC_SHAPE_LINEARCOUNT)
+    {
+        for(shape = self; shape->parent; shape = shape->parent)
+        {
+            if(ecc_keyidx_isequal(shape->key, key))
+            {
+                return shape->parent->count + 2;
+            }
+        }
+        return 0;
+    }
+    if(!self->table)
+    {
+        ecc_shape_buildtable(self);
+    }
+    index = ecc_shape_hashkey(key) & self->tablemask;
+    while(self->table[index].slot)
+    {
+        if(ecc_keyidx_isequal(self->table[index].key, key))
+        {
+            return self->table[index].slot;
+        }
+        index = (index + 1) & self->tablemask;
+    }
+    return 0;
+}
+
+static void ecc_shape_inserttransition(eccshape_t* self, eccshape_t* child)
+{
+    uint32_t index;
+    index = ecc_shape_hashkey(child->key) & self->transitionmask;
+    while(self->transitions[index])
+    {
+        index = (index + 1) & self->transitionmask;
+    }
+    self->transitions[index] = child;
+}
+
+eccshape_t* ecc_shape_transition(eccshape_t* self, eccindexkey_t key)
+{
+    uint32_t index;
+    uint32_t capacity;
+    eccshape_t* child;
+    eccshape_t** previous;
+    if(self->transitions)
+    {
+        index = ecc_shape_hashkey(key) & self->transitionmask;
+        while((child = self->transitions[index]))
+        {
+            if(ecc_keyidx_isequal(child->key, key))
+            {
+                return child;
+            }
+            index = (index + 1) & self->transitionmask;
+        }
+    }
+    if(g_shapecount >= ECC_CONF_MAXSHAPES)
+    {
+        return NULL;
+    }
+    /* keep the transition table at most half full */
+    if(!self->transitions || (self->transitioncount + 1) * 2 > self->transitionmask + 1)
+    {
+        previous = self->transitions;
+        capacity = previous ? self->transitionmask + 1 : 0;
+        self->transitionmask = capacity ? capacity * 2 - 1 : 3;
+        self->transitions = (eccshape_t**)calloc(self->transitionmask + 1, sizeof(*self->transitions));
+        if(self->transitions == NULL)
+        {
+            fprintf(stderr, "in transition: failed to allocate for %ld bytes\n", (long)((self->transitionmask + 1) * sizeof(*self->transitions)));
+        }
+        for(index = 0; index < capacity; ++index)
+        {
+            if(previous[index])
+            {
+                ecc_shape_inserttransition(self, previous[index]);
+            }
+        }
+        free(previous);
+    }
+    child = (eccshape_t*)calloc(1, sizeof(*child));
+    child->parent = self;
+    child->key = key;
+    child->count = self->count + 1;
+    ecc_shape_inserttransition(self, child);
+    ++self->transitioncount;
+    ++g_shapecount;
+    return child;
+}
+
+/* marks the shape of a live object and the ones leading to it, parallel collections mark from several threads */
+void ecc_shape_mark(eccshape_t* self)
+{
+#if ECC_CONF_PARALLELGC
+    for(; self && !__atomic_load_n(&self->marked, __ATOMIC_RELAXED); self = self->parent)
+    {
+        __atomic_store_n(&self->marked, 1, __ATOMIC_RELAXED);
+    }
+#else
+    for(; self && !self->marked; self = self->parent)
+    {
+        self->marked = 1;
+    }
+#endif
+}
+
+static void ecc_shape_prunetree(eccshape_t* self)
+{
+    uint32_t index;
+    uint32_t capacity;
+    uint32_t size;
+    eccshape_t* child;
+    eccshape_t** previous;
+    self->marked = 0;
+    if(!self->transitions)
+    {
+        return;
+    }
+    capacity = self->transitionmask + 1;
+    for(index = 0; index < capacity; ++index)
+    {
+        if((child = self->transitions[index]))
+        {
+            if(child->marked)
+            {
+                ecc_shape_prunetree(child);
+            }
+            else
+            {
+                ecc_shape_destroytree(child);
+                free(child);
+                --g_shapecount;
+                --self->transitioncount;
+                self->transitions[index] = NULL;
+            }
+        }
+    }
+    if(!self->transitioncount)
+    {
+        free(self->transitions), self->transitions = NULL;
+        self->transitionmask = 0;
+        return;
+    }
+    /* probes may cross the holes left, so the survivors go in a table sized for them */
+    size = 4;
+    while(self->transitioncount * 2 > size)
+    {
+        size *= 2;
+    }
+    previous = self->transitions;
+    self->transitionmask = size - 1;
+    self->transitions = (eccshape_t**)calloc(size, sizeof(*self->transitions));
+    if(self->transitions == NULL)
+    {
+        fprintf(stderr, "in prunetree: failed to allocate for %ld bytes\n", (long)(size * sizeof(*self->transitions)));
+    }
+    for(index = 0; index < capacity; ++index)
+    {
+        if(previous[index])
+        {
+            ecc_shape_inserttransition(self, previous[index]);
+        }
+    }
+    free(previous);
+}
+
+/* frees the shapes left unmarked by a full collection, which no live object can reach, and clears every mark */
+void ecc_shape_collectunmarked(void)
+{
+    ecc_shape_prunetree(&g_shaperoot);
+}
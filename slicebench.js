@@ -0,0 +1,22 @@
+/*
+ * tokenizing benchmark: splits a large input into lines and fields and keeps them all,
+ * the pieces share the input (see ECC_CONF_SLICELENGTH). compare peak RSS against the input size.
+ * usage: run slicebench.js [lines]
+ */
+var count = +(arguments[0] || 200000);
+var parts = [], i;
+for (i = 0; i < count; ++i)
+    parts[i] = 'record number ' + i + ' with a payload field;second field of this line ' + i;
+
+var input = parts.join('\n');
+parts = null;
+
+var start = (new Date).getTime();
+var lines = input.split('\n'), fields = [], total = 0;
+for (i = 0; i < lines.length; ++i)
+{
+    fields[i] = lines[i].split(';');
+    total += fields[i][1].substring(7, 12).length;
+}
+
+println(input.length + " bytes, " + lines.length + " lines: " + ((new Date).getTime() - start) + " ms (" + total + ", " + fields[count - 1][0].slice(-13) + ")");
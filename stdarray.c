@@ -463,12 +463,12 @@ static int ecc_array_compare(eccarraycomparestate_t* cmp, eccvalue_t left, eccva
             /* fallthrough */
         case 5:
             {
-                cmp->context.execenv->hmapmapitems[3 + 1].hmapmapvalue = right;
+                ecc_object_setvalue(cmp->context.execenv, &cmp->context.execenv->hmapmapitems[3 + 1].hmapmapvalue, right);
             }
             /* fallthrough */
         case 4:
             {
-                cmp->context.execenv->hmapmapitems[3 + 0].hmapmapvalue = left;
+                ecc_object_setvalue(cmp->context.execenv, &cmp->context.execenv->hmapmapitems[3 + 0].hmapmapvalue, left);
             }
             /* fallthrough */
         case 3:
@@ -481,6 +481,15 @@ static int ecc_array_compare(eccarraycomparestate_t* cmp, eccvalue_t left, eccva
     }
 
     cmp->context.ops = cmp->ops;
+    if(cmp->function && cmp->function->cells)
+    {
+        /* fresh cells for each call, as ecc_oper_callfunction does */
+        cmp->context.execenv->prototype = cmp->function->funcenv.prototype;
+        ecc_oper_boxcells(cmp->function, cmp->context.execenv);
+    }
+    /* the arguments object lives across comparisons, and collections */
+    ecc_mempool_writebarrier(cmp->arguments, left);
+    ecc_mempool_writebarrier(cmp->arguments, right);
     cmp->arguments->hmapitemitems[0].hmapitemvalue = left;
     cmp->arguments->hmapitemitems[1].hmapitemvalue = right;
 
@@ -578,7 +587,7 @@ static void ecc_array_sortandmerge(eccobject_t* object, eccarraycomparestate_t*
 
 void ecc_array_sortinplace(ecccontext_t* context, eccobject_t* object, eccobjfunction_t* function, int first, int last)
 {
-    eccoperand_t defaultOps = { ecc_objfnarray_defaultcomparison, ECCValConstUndefined, ECC_String_NativeCode };
+    eccoperand_t defaultOps = { ecc_objfnarray_defaultcomparison, ECCValConstUndefined, ECC_String_NativeCode, ECC_OPCODE_NATIVE, 0, 0, NULL, NULL };
     const eccoperand_t* ops = function ? function->oplist->ops : &defaultOps;
 
     /*
@@ -607,7 +616,7 @@ void ecc_array_sortinplace(ecccontext_t* context, eccobject_t* object, eccobjfun
         cmp.arguments = ecc_args_createsized(2);
         ++cmp.arguments->refcount;
 
-        environment->hmapmapitems[2].hmapmapvalue = ecc_value_object(cmp.arguments);
+        ecc_object_setvalue(environment, &environment->hmapmapitems[2].hmapmapvalue, ecc_value_object(cmp.arguments));
 
         ecc_array_sortandmerge(object, &cmp, first, last);
     }
@@ -622,6 +631,8 @@ void ecc_array_sortinplace(ecccontext_t* context, eccobject_t* object, eccobjfun
         {
             environment = function->funcenv;
         }
+        environment.flags |= ECC_OBJFLAG_YOUNG;
+        arguments.flags = ECC_OBJFLAG_YOUNG;
         ecchashmap_t hashmap[function ? function->funcenv.hmapmapcapacity : 3];
         ecchashitem_t element[2];
 
@@ -636,7 +647,7 @@ void ecc_array_sortinplace(ecccontext_t* context, eccobject_t* object, eccobjfun
         arguments.hmapitemitems = element;
         arguments.hmapitemcount = 2;
         environment.hmapmapitems = hashmap;
-        environment.hmapmapitems[2].hmapmapvalue = ecc_value_object(&arguments);
+        ecc_object_setvalue(&environment, &environment.hmapmapitems[2].hmapmapvalue, ecc_value_object(&arguments));
 
         ecc_array_sortandmerge(object, &cmp, first, last);
     }
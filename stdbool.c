@@ -62,7 +62,7 @@ void ecc_bool_teardown(void)
 
 eccobjbool_t* ecc_bool_create(int truth)
 {
-    eccobjbool_t* self = (eccobjbool_t*)malloc(sizeof(*self));
+    eccobjbool_t* self = (eccobjbool_t*)ecc_mempool_allocate(ECC_MEMKIND_OBJECT, sizeof(*self));
     memset(self, 0, sizeof(eccobjbool_t));
     ecc_mempool_addobject(&self->object);
     ecc_object_initialize(&self->object, ECC_Prototype_Boolean);
@@ -1057,7 +1057,7 @@ void ecc_date_teardown(void)
 
 eccobjdate_t* ecc_date_create(double ms)
 {
-    eccobjdate_t* self = (eccobjdate_t*)malloc(sizeof(*self));
+    eccobjdate_t* self = (eccobjdate_t*)ecc_mempool_allocate(ECC_MEMKIND_OBJECT, sizeof(*self));
     memset(self, 0, sizeof(eccobjdate_t));
     ecc_mempool_addobject(&self->object);
     ecc_object_initialize(&self->object, ECC_Prototype_Date);
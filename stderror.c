@@ -43,7 +43,7 @@ eccstrbuffer_t* ecc_error_messagevalue(ecccontext_t* context, eccvalue_t value)
     if(value.type == ECC_VALTYPE_UNDEFINED)
         return NULL;
     else if(value.type == ECC_VALTYPE_CHARS)
-        return value.data.chars;
+        return ecc_strbuf_flatten(value.data.chars);
     else
     {
         value = ecc_value_tostring(context, value);
@@ -87,7 +87,7 @@ eccvalue_t ecc_error_tochars(ecccontext_t* context, eccvalue_t value)
 
 eccobjerror_t* ecc_error_create(eccobject_t* errorPrototype, eccstrbox_t text, eccstrbuffer_t* message)
 {
-    eccobjerror_t* self = (eccobjerror_t*)malloc(sizeof(*self));
+    eccobjerror_t* self = (eccobjerror_t*)ecc_mempool_allocate(ECC_MEMKIND_OBJECT, sizeof(*self));
     ecc_mempool_addobject(&self->object);
     memset(self, 0, sizeof(eccobjerror_t));
 
@@ -264,5 +264,5 @@ void ecc_error_destroy(eccobjerror_t* self)
 
     ecc_object_finalize(&self->object);
 
-    free(self), self = NULL;
+    ecc_mempool_free(ECC_MEMKIND_OBJECT, self), self = NULL;
 }
@@ -46,6 +46,9 @@ void ecc_function_typemark(eccobject_t* object)
 
     if(self->pair)
         ecc_mempool_markobject(&self->pair->object);
+
+    if(self->oplist)
+        ecc_mempool_markoplist(self->oplist);
 }
 
 eccvalue_t ecc_function_tochars(ecccontext_t* context, eccvalue_t value)
@@ -110,6 +113,7 @@ eccvalue_t ecc_objfnfunction_call(ecccontext_t* context)
     context->isstrictmode = context->parent->isstrictmode;
 
     arguments = *context->execenv->hmapmapitems[2].hmapmapvalue.data.object;
+    arguments.flags |= ECC_OBJFLAG_YOUNG;
 
     if(arguments.hmapitemcount)
     {
@@ -261,7 +265,7 @@ eccobjfunction_t* ecc_function_create(eccobject_t* environment)
 
 eccobjfunction_t* ecc_function_createsized(eccobject_t* environment, uint32_t size)
 {
-    eccobjfunction_t* self = (eccobjfunction_t*)malloc(sizeof(*self));
+    eccobjfunction_t* self = (eccobjfunction_t*)ecc_mempool_allocate(ECC_MEMKIND_FUNCTION, sizeof(*self));
     ecc_mempool_addfunction(self);
     memset(self, 0, sizeof(eccobjfunction_t));
     ecc_object_initialize(&self->object, ECC_Prototype_Function);
@@ -296,13 +300,17 @@ eccobjfunction_t* ecc_function_createwithnative(const eccnativefuncptr_t native,
 
 eccobjfunction_t* ecc_function_copy(eccobjfunction_t* original)
 {
-    eccobjfunction_t* self = (eccobjfunction_t*)malloc(sizeof(*self));
+    /* the copy is tracked as a plain object */
+    eccobjfunction_t* self = (eccobjfunction_t*)ecc_mempool_allocate(ECC_MEMKIND_OBJECT, sizeof(*self));
     size_t byteSize;
 
     assert(original);
     ecc_mempool_addobject(&self->object);
 
     *self = *original;
+    self->object.flags = (original->object.flags & ~ECC_OBJFLAG_REMEMBERED) | ECC_OBJFLAG_YOUNG;
+    /* funcenv shares its template slots with the original and is never stored into, so it may stay young */
+    self->funcenv.flags = (original->funcenv.flags & ~ECC_OBJFLAG_REMEMBERED) | ECC_OBJFLAG_YOUNG;
 
     byteSize = sizeof(*self->object.hmapmapitems) * self->object.hmapmapcapacity;
     self->object.hmapmapitems = (ecchashmap_t*)malloc(byteSize);
@@ -321,7 +329,13 @@ void ecc_function_destroy(eccobjfunction_t* self)
     if(self->oplist)
         ecc_oplist_destroy(self->oplist), self->oplist = NULL;
 
-    free(self), self = NULL;
+    if(self->cells)
+    {
+        ecc_object_finalize(&self->cells->environment);
+        free(self->cells), self->cells = NULL;
+    }
+
+    ecc_mempool_free(ECC_MEMKIND_FUNCTION, self), self = NULL;
 }
 
 void ecc_function_addmember(eccobjfunction_t* self, const char* name, eccvalue_t value, int flags)
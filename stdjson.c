@@ -233,7 +233,7 @@ static eccvalue_t ecc_json_parseobject(eccjsonparser_t* parse)
             if(c.codepoint != '"')
                 return ecc_json_error(parse, -c.units, ecc_strbuf_create("expect property name"));
 
-            key = ecc_keyidx_makewithtext(ecc_json_parsestring(parse), ECC_INDEXFLAG_COPYONCREATE);
+            key = ecc_keyidx_makewithtext(ecc_json_parsestring(parse), ECC_INDEXFLAG_TRANSIENT);
 
             c = ecc_json_nextc(parse);
             if(c.codepoint != ':')
@@ -311,12 +311,12 @@ static eccvalue_t ecc_json_revive(eccjsonparser_t* parse, eccvalue_t thisval, ec
             /* fallthrough */
         case 5:
             {
-                parse->context.execenv->hmapmapitems[3 + 1].hmapmapvalue = value;
+                ecc_object_setvalue(parse->context.execenv, &parse->context.execenv->hmapmapitems[3 + 1].hmapmapvalue, value);
             }
             /* fallthrough */
         case 4:
             {
-                parse->context.execenv->hmapmapitems[3 + 0].hmapmapvalue = property;
+                ecc_object_setvalue(parse->context.execenv, &parse->context.execenv->hmapmapitems[3 + 0].hmapmapvalue, property);
             }
             /* fallthrough */
         case 3:
@@ -329,7 +329,14 @@ static eccvalue_t ecc_json_revive(eccjsonparser_t* parse, eccvalue_t thisval, ec
     }
 
     parse->context.ops = parse->ops;
+    if(parse->function && parse->function->cells)
+    {
+        parse->context.execenv->prototype = parse->function->funcenv.prototype;
+        ecc_oper_boxcells(parse->function, parse->context.execenv);
+    }
     parse->context.thisvalue = thisval;
+    ecc_mempool_writebarrier(parse->arguments, property);
+    ecc_mempool_writebarrier(parse->arguments, value);
     parse->arguments->hmapitemitems[0].hmapitemvalue = property;
     parse->arguments->hmapitemitems[1].hmapitemvalue = value;
     return parse->context.ops->native(&parse->context);
@@ -339,6 +346,7 @@ static eccvalue_t ecc_json_itermore(eccjsonparser_t* parse, eccvalue_t thisval,
 {
     uint32_t index, count;
     eccappbuf_t chars;
+    eccvalue_t revived;
 
     if(ecc_value_isobject(value))
     {
@@ -350,14 +358,19 @@ static eccvalue_t ecc_json_itermore(eccjsonparser_t* parse, eccvalue_t thisval,
             {
                 ecc_strbuf_beginappend(&chars);
                 ecc_strbuf_append(&chars, "%d", index);
-                object->hmapitemitems[index].hmapitemvalue = ecc_json_itermore(parse, thisval, ecc_strbuf_endappend(&chars), object->hmapitemitems[index].hmapitemvalue);
+                revived = ecc_json_itermore(parse, thisval, ecc_strbuf_endappend(&chars), object->hmapitemitems[index].hmapitemvalue);
+                ecc_mempool_writebarrier(object, revived);
+                object->hmapitemitems[index].hmapitemvalue = revived;
             }
         }
 
         for(index = 2; index < object->hmapmapcount; ++index)
         {
             if(object->hmapmapitems[index].hmapmapvalue.check == 1)
-                object->hmapmapitems[index].hmapmapvalue = ecc_json_itermore(parse, thisval, ecc_value_fromkey(object->hmapmapitems[index].hmapmapvalue.key), object->hmapmapitems[index].hmapmapvalue);
+            {
+                revived = ecc_json_itermore(parse, thisval, ecc_value_fromkey(object->hmapmapitems[index].hmapmapvalue.key), object->hmapmapitems[index].hmapmapvalue);
+                ecc_object_setvalue(object, &object->hmapmapitems[index].hmapmapvalue, revived);
+            }
         }
     }
     return ecc_json_revive(parse, thisval, property, value);
@@ -399,7 +412,7 @@ static eccvalue_t ecc_objfnjson_parse(ecccontext_t* context)
         parse.context.execenv = environment;
         parse.arguments = ecc_args_createsized(2);
         ++parse.arguments->refcount;
-        environment->hmapmapitems[2].hmapmapvalue = ecc_value_object(parse.arguments);
+        ecc_object_setvalue(environment, &environment->hmapmapitems[2].hmapmapvalue, ecc_value_object(parse.arguments));
         result = ecc_json_itermore(&parse, result, ecc_value_fromtext(&ECC_String_Empty), result);
     }
     else if(parse.function)
@@ -407,6 +420,8 @@ static eccvalue_t ecc_objfnjson_parse(ecccontext_t* context)
         eccobject_t environment = parse.function->funcenv;
         eccobject_t arguments;
         memset(&arguments, 0, sizeof(eccobject_t));
+        environment.flags |= ECC_OBJFLAG_YOUNG;
+        arguments.flags = ECC_OBJFLAG_YOUNG;
         ecchashmap_t hashmap[parse.function->funcenv.hmapmapcapacity];
         ecchashitem_t element[2];
         memcpy(hashmap, parse.function->funcenv.hmapmapitems, sizeof(hashmap));
@@ -415,7 +430,7 @@ static eccvalue_t ecc_objfnjson_parse(ecccontext_t* context)
         arguments.hmapitemitems = element;
         arguments.hmapitemcount = 2;
         environment.hmapmapitems = hashmap;
-        environment.hmapmapitems[2].hmapmapvalue = ecc_value_object(&arguments);
+        ecc_object_setvalue(&environment, &environment.hmapmapitems[2].hmapmapvalue, ecc_value_object(&arguments));
         result = ecc_json_itermore(&parse, result, ecc_value_fromtext(&ECC_String_Empty), result);
     }
     return result;
@@ -436,12 +451,12 @@ static eccvalue_t ecc_json_replace(eccjsonstringify_t* stringify, eccvalue_t thi
             /* fallthrough */
         case 5:
             {
-                stringify->context.execenv->hmapmapitems[3 + 1].hmapmapvalue = value;
+                ecc_object_setvalue(stringify->context.execenv, &stringify->context.execenv->hmapmapitems[3 + 1].hmapmapvalue, value);
             }
             /* fallthrough */
         case 4:
             {
-                stringify->context.execenv->hmapmapitems[3 + 0].hmapmapvalue = property;
+                ecc_object_setvalue(stringify->context.execenv, &stringify->context.execenv->hmapmapitems[3 + 0].hmapmapvalue, property);
             }
             /* fallthrough */
         case 3:
@@ -454,7 +469,14 @@ static eccvalue_t ecc_json_replace(eccjsonstringify_t* stringify, eccvalue_t thi
     }
 
     stringify->context.ops = stringify->ops;
+    if(stringify->function && stringify->function->cells)
+    {
+        stringify->context.execenv->prototype = stringify->function->funcenv.prototype;
+        ecc_oper_boxcells(stringify->function, stringify->context.execenv);
+    }
     stringify->context.thisvalue = thisval;
+    ecc_mempool_writebarrier(stringify->arguments, property);
+    ecc_mempool_writebarrier(stringify->arguments, value);
     stringify->arguments->hmapitemitems[0].hmapitemvalue = property;
     stringify->arguments->hmapitemitems[1].hmapitemvalue = value;
     return stringify->context.ops->native(&stringify->context);
@@ -597,7 +619,7 @@ static eccvalue_t ecc_objfnjson_stringify(ecccontext_t* context)
         stringify.arguments = ecc_args_createsized(2);
         ++stringify.arguments->refcount;
 
-        environment->hmapmapitems[2].hmapmapvalue = ecc_value_object(stringify.arguments);
+        ecc_object_setvalue(environment, &environment->hmapmapitems[2].hmapmapvalue, ecc_value_object(stringify.arguments));
 
         ecc_json_stringify(&stringify, value, ecc_value_fromtext(&ECC_String_Empty), value, 1, 0);
     }
@@ -606,6 +628,8 @@ static eccvalue_t ecc_objfnjson_stringify(ecccontext_t* context)
         eccobject_t environment = stringify.function->funcenv;
         eccobject_t arguments;
         memset(&arguments, 0, sizeof(eccobject_t));
+        environment.flags |= ECC_OBJFLAG_YOUNG;
+        arguments.flags = ECC_OBJFLAG_YOUNG;
         ecchashmap_t hashmap[stringify.function->funcenv.hmapmapcapacity];
         ecchashitem_t element[2];
 
@@ -616,7 +640,7 @@ static eccvalue_t ecc_objfnjson_stringify(ecccontext_t* context)
         arguments.hmapitemitems = element;
         arguments.hmapitemcount = 2;
         environment.hmapmapitems = hashmap;
-        environment.hmapmapitems[2].hmapmapvalue = ecc_value_object(&arguments);
+        ecc_object_setvalue(&environment, &environment.hmapmapitems[2].hmapmapvalue, ecc_value_object(&arguments));
 
         ecc_json_stringify(&stringify, value, ecc_value_fromtext(&ECC_String_Empty), value, 1, 0);
     }
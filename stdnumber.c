@@ -222,7 +222,7 @@ void ecc_number_teardown(void)
 eccobjnumber_t* ecc_number_create(double binary)
 {
     eccobjnumber_t* self;
-    self = (eccobjnumber_t*)malloc(sizeof(*self));
+    self = (eccobjnumber_t*)ecc_mempool_allocate(ECC_MEMKIND_OBJECT, sizeof(*self));
     memset(self, 0, sizeof(eccobjnumber_t));
     ecc_mempool_addobject(&self->object);
     ecc_object_initialize(&self->object, ECC_Prototype_Number);
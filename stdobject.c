@@ -16,9 +16,114 @@ const eccobjinterntype_t ECC_Type_Object = {
     .text = &ECC_String_ObjectType,
 };
 
+/*
+* dictionary mode: hmapmapitems[1] heads an open addressing (linear probing) index
+* over the members, kept in cells of hmapmapitems after the values:
+* each index cell holds 2 key numbers followed by their 2 value slots.
+* slots are 0 (empty) or >= 2, below ECC_OBJECT_MAXSLOTS, and are stored in the 3 first bytes
+* of their word whatever the byte order, so the last byte of a cell, 'check', stays 0
+* and index cells never pass for values.
+* values past ECC_OBJECT_MAXSLOTS are not indexed, ecc_object_scanslot finds them.
+* values stay in insertion order, enumeration walks them directly.
+*/
+#define ECC_OBJECT_INDEXPERCELL 2
+#define ECC_OBJECT_MAXSLOTS (1 << 24)
+#define ecc_object_indexstart(items) ((items)[1].slot[0])
+#define ecc_object_indexmask(items) ((items)[1].slot[1])
+#define ecc_object_indexcount(items) ((items)[1].slot[2])
+#define ecc_object_indexkey(items, start, entry) ((items)[(start) + (entry) / ECC_OBJECT_INDEXPERCELL].slot[(entry) % ECC_OBJECT_INDEXPERCELL])
+#define ecc_object_indexbytes(items, start, entry) ((uint8_t*)&(items)[(start) + (entry) / ECC_OBJECT_INDEXPERCELL].slot[ECC_OBJECT_INDEXPERCELL + (entry) % ECC_OBJECT_INDEXPERCELL])
+#define ecc_object_indexcells(size) (((size) + ECC_OBJECT_INDEXPERCELL - 1) / ECC_OBJECT_INDEXPERCELL)
+
+/* the overlay above needs 'check' to be the last byte of a value */
+typedef char ecc_object_checkislastbyte[offsetof(eccvalue_t, check) == sizeof(eccvalue_t) - 1 ? 1 : -1];
+
+static uint32_t ecc_object_indexslot(const ecchashmap_t* items, uint32_t start, uint32_t entry)
+{
+    const uint8_t* bytes;
+    bytes = ecc_object_indexbytes(items, start, entry);
+    return bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16;
+}
+
+static void ecc_object_setindexslot(ecchashmap_t* items, uint32_t start, uint32_t entry, uint32_t slot)
+{
+    uint8_t* bytes;
+    bytes = ecc_object_indexbytes(items, start, entry);
+    bytes[0] = (uint8_t)slot;
+    bytes[1] = (uint8_t)(slot >> 8);
+    bytes[2] = (uint8_t)(slot >> 16);
+}
+
+/* slot of key among the values left out of the index, or 0 */
+static uint32_t ecc_object_scanslot(const ecchashmap_t* items, uint32_t count, eccindexkey_t key)
+{
+    uint32_t slot;
+    for(slot = ECC_OBJECT_MAXSLOTS; slot < count; ++slot)
+    {
+        if(items[slot].hmapmapvalue.check == 1 && items[slot].hmapmapvalue.key.data.integer == key.data.integer)
+        {
+            return slot;
+        }
+    }
+    return 0;
+}
+
+static uint32_t ecc_object_indexhash(eccindexkey_t key)
+{
+    uint32_t hash;
+    hash = key.data.integer * UINT32_C(2654435761);
+    return hash ^ (hash >> 16);
+}
+
+/* index entry holding key, or UINT32_MAX */
+static uint32_t ecc_object_indexfind(const ecchashmap_t* items, eccindexkey_t key)
+{
+    uint32_t mask;
+    uint32_t start;
+    uint32_t entry;
+    start = ecc_object_indexstart(items);
+    mask = ecc_object_indexmask(items);
+    entry = ecc_object_indexhash(key) & mask;
+    while(ecc_object_indexslot(items, start, entry))
+    {
+        if(ecc_object_indexkey(items, start, entry) == key.data.integer)
+        {
+            return entry;
+        }
+        entry = (entry + 1) & mask;
+    }
+    return UINT32_MAX;
+}
+
 uint32_t ecc_object_getslot(const eccobject_t* const self, const eccindexkey_t key)
 {
-    return self->hmapmapitems[self->hmapmapitems[self->hmapmapitems[self->hmapmapitems[1].slot[key.data.depth[0]]].slot[key.data.depth[1]]].slot[key.data.depth[2]]].slot[key.data.depth[3]];
+    uint32_t mask;
+    uint32_t start;
+    uint32_t entry;
+    uint32_t slot;
+    const ecchashmap_t* items;
+    if(self->shape)
+    {
+        return ecc_shape_find(self->shape, key);
+    }
+    /* without an index, start and mask are 0 and the probe stops on the empty slot 0 */
+    items = self->hmapmapitems;
+    start = ecc_object_indexstart(items);
+    mask = ecc_object_indexmask(items);
+    entry = ecc_object_indexhash(key) & mask;
+    while((slot = ecc_object_indexslot(items, start, entry)))
+    {
+        if(ecc_object_indexkey(items, start, entry) == key.data.integer)
+        {
+            return slot;
+        }
+        entry = (entry + 1) & mask;
+    }
+    if(self->hmapmapcount > ECC_OBJECT_MAXSLOTS)
+    {
+        return ecc_object_scanslot(items, self->hmapmapcount, key);
+    }
+    return 0;
 }
 
 uint32_t ecc_object_getindexorkey(eccvalue_t property, eccindexkey_t* key)
@@ -64,7 +169,7 @@ uint32_t ecc_object_getindexorkey(eccvalue_t property, eccindexkey_t* key)
             {
                 eccstrbox_t text = ecc_value_textof(&property);
                 if((index = ecc_astlex_scanelement(text)) == UINT32_MAX)
-                    *key = ecc_keyidx_makewithtext(text, ECC_INDEXFLAG_COPYONCREATE);
+                    *key = ecc_keyidx_makewithtext(text, ECC_INDEXFLAG_TRANSIENT);
             }
             else
                 return ecc_object_getindexorkey(ecc_value_tostring(NULL, property), key);
@@ -81,7 +186,7 @@ eccindexkey_t ecc_object_keyofindex(uint32_t index, int create)
 
     length = snprintf(buffer, sizeof(buffer), "%u", (unsigned)index);
     if(create)
-        return ecc_keyidx_makewithtext(ecc_strbox_make(buffer, length), ECC_INDEXFLAG_COPYONCREATE);
+        return ecc_keyidx_makewithtext(ecc_strbox_make(buffer, length), ECC_INDEXFLAG_TRANSIENT);
     else
         return ecc_keyidx_search(ecc_strbox_make(buffer, length));
 }
@@ -663,7 +768,7 @@ eccobject_t* ecc_object_create(eccobject_t* prototype)
 eccobject_t* ecc_object_createsized(eccobject_t* prototype, uint32_t size)
 {
     eccobject_t* self;
-    self = (eccobject_t*)calloc(sizeof(*self), 1);
+    self = (eccobject_t*)ecc_mempool_allocate(ECC_MEMKIND_OBJECT, sizeof(*self));
     ecc_mempool_addobject(self);
     return ecc_object_initializesized(self, prototype, size);
 }
@@ -686,6 +791,7 @@ eccobject_t* ecc_object_initializesized(eccobject_t* self, eccobject_t* prototyp
     assert(self);
     memset(self, 0, sizeof(eccobject_t));
     self->type = prototype ? prototype->type : &ECC_Type_Object;
+    self->flags = ECC_OBJFLAG_YOUNG;
 
     self->prototype = prototype;
     self->hmapmapcount = 2;
@@ -701,6 +807,7 @@ eccobject_t* ecc_object_initializesized(eccobject_t* self, eccobject_t* prototyp
         byteSize = sizeof(*self->hmapmapitems) * self->hmapmapcapacity;
         self->hmapmapitems = (ecchashmap_t*)malloc(byteSize);
         memset(self->hmapmapitems, 0, byteSize);
+        self->shape = ecc_shape_root();
     }
     else
     {
@@ -738,15 +845,17 @@ eccobject_t* ecc_object_copy(const eccobject_t* original)
 {
     size_t bsz;
     eccobject_t* self;
-    self = (eccobject_t*)malloc(sizeof(*self));
+    self = (eccobject_t*)ecc_mempool_allocate(ECC_MEMKIND_OBJECT, sizeof(*self));
     ecc_mempool_addobject(self);
     *self = *original;
+    self->flags = (original->flags & ~ECC_OBJFLAG_REMEMBERED) | ECC_OBJFLAG_YOUNG;
     bsz = sizeof(*self->hmapitemitems) * self->hmapitemcount;
     self->hmapitemitems = (ecchashitem_t*)malloc(bsz);
     memcpy(self->hmapitemitems, original->hmapitemitems, bsz);
     bsz = sizeof(*self->hmapmapitems) * self->hmapmapcount;
     self->hmapmapitems = (ecchashmap_t*)malloc(bsz);
     memcpy(self->hmapmapitems, original->hmapmapitems, bsz);
+    self->hmapmapcapacity = self->hmapmapcount;
     return self;
 }
 
@@ -761,7 +870,7 @@ void ecc_object_destroy(eccobject_t* self)
     {
         ecc_object_destroymapitems(self);
     }
-    free(self);
+    ecc_mempool_free(ECC_MEMKIND_OBJECT, self);
     self = NULL;
 }
 
@@ -904,8 +1013,23 @@ eccvalue_t ecc_object_putvalue(ecccontext_t* context, eccobject_t* self, eccvalu
         }
         else
             value.flags = ref->flags;
+
+        /* the member keeps its key, dictionary indexes are rebuilt from it */
+        value.key = ref->key;
     }
 
+    if(self)
+        ecc_mempool_writebarrier(self, value);
+
+    return *ref = value;
+}
+
+/* like ecc_object_putvalue, for the slots the engine fills itself: no accessor, no readonly check */
+eccvalue_t ecc_object_setvalue(eccobject_t* self, eccvalue_t* ref, eccvalue_t value)
+{
+    value.key = ref->key;
+    value.flags = ref->flags;
+    ecc_mempool_writebarrier(self, value);
     return *ref = value;
 }
 
@@ -970,58 +1094,190 @@ eccvalue_t ecc_object_putproperty(ecccontext_t* context, eccobject_t* self, eccv
         return ecc_object_putmember(context, self, key, value);
 }
 
-eccvalue_t* ecc_object_addmember(eccobject_t* self, eccindexkey_t key, eccvalue_t value, int flags)
+/* grows hmapmapitems so that 'count' more cells fit */
+static void ecc_object_reservemap(eccobject_t* self, uint32_t count)
 {
-    int depth;
-    int needtoadd;
     uint32_t capacity;
-    uint32_t slot;
     size_t needed;
     ecchashmap_t* tmp;
-    slot = 1;
-    depth = 0;
-    assert(self);
-    do
+    if(self->hmapmapcount + count <= self->hmapmapcapacity)
+    {
+        return;
+    }
+    capacity = self->hmapmapcapacity;
+    self->hmapmapcapacity = self->hmapmapcapacity ? self->hmapmapcapacity * 2 : 2;
+    while(self->hmapmapcapacity < self->hmapmapcount + count)
+    {
+        self->hmapmapcapacity *= 2;
+    }
+    needed = (sizeof(*self->hmapmapitems) * self->hmapmapcapacity);
+    tmp = (ecchashmap_t*)realloc(self->hmapmapitems, needed);
+    if(tmp == NULL)
     {
-        if(!self->hmapmapitems[slot].slot[key.data.depth[depth]])
+        fprintf(stderr, "in reservemap: failed to reallocate for %ld bytes\n", needed);
+    }
+    self->hmapmapitems = tmp;
+    memset(self->hmapmapitems + capacity, 0, sizeof(*self->hmapmapitems) * (self->hmapmapcapacity - capacity));
+}
+
+static void ecc_object_indexinsert(ecchashmap_t* items, eccindexkey_t key, uint32_t slot)
+{
+    uint32_t mask;
+    uint32_t start;
+    uint32_t entry;
+    start = ecc_object_indexstart(items);
+    mask = ecc_object_indexmask(items);
+    entry = ecc_object_indexhash(key) & mask;
+    assert(slot < ECC_OBJECT_MAXSLOTS);
+    while(ecc_object_indexslot(items, start, entry))
+    {
+        entry = (entry + 1) & mask;
+    }
+    ecc_object_setindexslot(items, start, entry, slot);
+    ecc_object_indexkey(items, start, entry) = key.data.integer;
+    ++ecc_object_indexcount(items);
+}
+
+/* removes an entry, shifting back the ones that probed past it */
+static void ecc_object_indexremove(ecchashmap_t* items, uint32_t entry)
+{
+    uint32_t mask;
+    uint32_t start;
+    uint32_t next;
+    uint32_t home;
+    eccindexkey_t key;
+    start = ecc_object_indexstart(items);
+    mask = ecc_object_indexmask(items);
+    next = entry;
+    for(;;)
+    {
+        next = (next + 1) & mask;
+        if(!ecc_object_indexslot(items, start, next))
         {
-            needtoadd = 4 - depth - (self->hmapmapcapacity - self->hmapmapcount);
-            if(needtoadd > 0)
-            {
-                capacity = self->hmapmapcapacity;
-                self->hmapmapcapacity = self->hmapmapcapacity ? self->hmapmapcapacity * 2 : 2;
-                needed = (sizeof(*self->hmapmapitems) * self->hmapmapcapacity);
-                tmp = (ecchashmap_t*)realloc(self->hmapmapitems, needed);
-                if(tmp == NULL)
-                {
-                    fprintf(stderr, "in addmember: failed to reallocate for %ld bytes\n", needed);
-                }
-                self->hmapmapitems = tmp;
-                memset(self->hmapmapitems + capacity, 0, sizeof(*self->hmapmapitems) * (self->hmapmapcapacity - capacity));
-            }
-            do
-            {
-                assert(self->hmapmapcount < UINT16_MAX);
-                slot = self->hmapmapitems[slot].slot[key.data.depth[depth]] = self->hmapmapcount++;
-            } while(++depth < 4);
             break;
         }
-        else
-            assert(self->hmapmapitems[slot].hmapmapvalue.check != 1);
+        key.data.integer = ecc_object_indexkey(items, start, next);
+        home = ecc_object_indexhash(key) & mask;
+        if(((next - home) & mask) >= ((next - entry) & mask))
+        {
+            ecc_object_setindexslot(items, start, entry, ecc_object_indexslot(items, start, next));
+            ecc_object_indexkey(items, start, entry) = key.data.integer;
+            entry = next;
+        }
+    }
+    ecc_object_setindexslot(items, start, entry, 0);
+    ecc_object_indexkey(items, start, entry) = 0;
+    --ecc_object_indexcount(items);
+}
 
-        slot = self->hmapmapitems[slot].slot[key.data.depth[depth]];
-        assert(slot != 1);
-        assert(slot < self->hmapmapcount);
-    } while(++depth < 4);
+/*
+* lays a fresh index for at least 'members' members at the end of hmapmapitems,
+* and fills it from the values before it (the previous index cells are left behind,
+* ecc_object_packvalue drops them).
+*/
+static void ecc_object_buildindex(eccobject_t* self, uint32_t members)
+{
+    uint32_t size;
+    uint32_t start;
+    uint32_t slot;
+    eccvalue_t* value;
+    size = 4;
+    while(size * 3 < members * 4)
+    {
+        size *= 2;
+    }
+    ecc_object_reservemap(self, ecc_object_indexcells(size));
+    start = self->hmapmapcount;
+    memset(self->hmapmapitems + start, 0, sizeof(*self->hmapmapitems) * ecc_object_indexcells(size));
+    self->hmapmapcount += ecc_object_indexcells(size);
+    ecc_object_indexstart(self->hmapmapitems) = start;
+    ecc_object_indexmask(self->hmapmapitems) = size - 1;
+    ecc_object_indexcount(self->hmapmapitems) = 0;
+    /* from the last value down, so a key stored twice resolves to its latest slot */
+    for(slot = start; slot-- > 2;)
+    {
+        value = &self->hmapmapitems[slot].hmapmapvalue;
+        if(value->check == 1 && value->key.data.integer && slot < ECC_OBJECT_MAXSLOTS && ecc_object_indexfind(self->hmapmapitems, value->key) == UINT32_MAX)
+        {
+            ecc_object_indexinsert(self->hmapmapitems, value->key, slot);
+        }
+    }
+}
+
+/*
+* leaves the shape: values keep their slots (environment slots are resolved
+* at parse time), and the key index is built behind them.
+*/
+void ecc_object_todictionary(eccobject_t* self)
+{
+    const eccshape_t* shape;
+    assert(self);
+    shape = self->shape;
+    if(!shape)
+    {
+        return;
+    }
+    self->shape = NULL;
+    memset(self->hmapmapitems + 1, 0, sizeof(*self->hmapmapitems));
+    ecc_object_buildindex(self, shape->count + 1);
+}
+
+eccvalue_t* ecc_object_addmember(eccobject_t* self, eccindexkey_t key, eccvalue_t value, int flags)
+{
+    uint32_t slot;
+    uint32_t count;
+    eccshape_t* shape;
+    assert(self);
+    if(self->shape)
+    {
+        if((slot = ecc_shape_find(self->shape, key)))
+        {
+            goto found;
+        }
+        /* a full shape tree has no transition for new keys, see ECC_CONF_MAXSHAPES */
+        if(self->shape->count < ECC_CONF_MAXSHAPEMEMBERS && self->hmapmapcount == self->shape->count + 2
+           && (shape = ecc_shape_transition(self->shape, key)))
+        {
+            ecc_object_reservemap(self, 1);
+            self->shape = shape;
+            slot = self->hmapmapcount++;
+            ecc_mempool_ownerbarrier(self);
+            goto found;
+        }
+        ecc_object_todictionary(self);
+    }
+    if((slot = ecc_object_getslot(self, key)))
+    {
+        goto found;
+    }
+    /* keep the index at most three quarters full */
+    count = ecc_object_indexcount(self->hmapmapitems) + 1;
+    if(!ecc_object_indexstart(self->hmapmapitems) || count * 4 > (ecc_object_indexmask(self->hmapmapitems) + 1) * 3)
+    {
+        ecc_object_buildindex(self, count);
+    }
+    ecc_object_reservemap(self, 1);
+    slot = self->hmapmapcount++;
+    if(slot < ECC_OBJECT_MAXSLOTS)
+    {
+        ecc_object_indexinsert(self->hmapmapitems, key, slot);
+    }
+    ecc_mempool_ownerbarrier(self);
 
+found:
     if(value.flags & ECC_VALFLAG_ACCESSOR)
         if(self->hmapmapitems[slot].hmapmapvalue.check == 1 && self->hmapmapitems[slot].hmapmapvalue.flags & ECC_VALFLAG_ACCESSOR)
             if((self->hmapmapitems[slot].hmapmapvalue.flags & ECC_VALFLAG_ACCESSOR) != (value.flags & ECC_VALFLAG_ACCESSOR))
+            {
+                ecc_mempool_ownerbarrier(&value.data.function->object);
                 value.data.function->pair = self->hmapmapitems[slot].hmapmapvalue.data.function;
+            }
 
     value.key = key;
     value.flags |= flags;
 
+    self->memberbloom |= ecc_object_bloombit(key);
+    ecc_mempool_writebarrier(self, value);
     self->hmapmapitems[slot].hmapmapvalue = value;
 
     return &self->hmapmapitems[slot].hmapmapvalue;
@@ -1045,6 +1301,7 @@ eccvalue_t* ecc_object_addelement(eccobject_t* self, uint32_t index, eccvalue_t
     }
     ref = &self->hmapitemitems[index].hmapitemvalue;
     value.flags |= flags;
+    ecc_mempool_writebarrier(self, value);
     *ref = value;
     return ref;
 }
@@ -1065,13 +1322,33 @@ int ecc_object_deletemember(eccobject_t* self, eccindexkey_t member)
 {
     eccobject_t* object;
     uint32_t slot;
-    uint32_t refSlot;
+    uint32_t entry;
     object = self;
     assert(object);
     assert(member.data.integer);
-    refSlot = self->hmapmapitems[self->hmapmapitems[self->hmapmapitems[1].slot[member.data.depth[0]]].slot[member.data.depth[1]]].slot[member.data.depth[2]];
-    slot = self->hmapmapitems[refSlot].slot[member.data.depth[3]];
-    if(!slot || !(object->hmapmapitems[slot].hmapmapvalue.check == 1))
+    if(self->shape)
+    {
+        slot = ecc_shape_find(self->shape, member);
+        if(!slot || !(object->hmapmapitems[slot].hmapmapvalue.check == 1))
+        {
+            return 1;
+        }
+        if(object->hmapmapitems[slot].hmapmapvalue.flags & ECC_VALFLAG_SEALED)
+        {
+            return 0;
+        }
+        ecc_object_todictionary(self);
+    }
+    entry = ecc_object_indexfind(self->hmapmapitems, member);
+    if(entry != UINT32_MAX)
+    {
+        slot = ecc_object_indexslot(self->hmapmapitems, ecc_object_indexstart(self->hmapmapitems), entry);
+    }
+    else if(!(slot = ecc_object_scanslot(self->hmapmapitems, self->hmapmapcount, member)))
+    {
+        return 1;
+    }
+    if(!(object->hmapmapitems[slot].hmapmapvalue.check == 1))
     {
         return 1;
     }
@@ -1080,7 +1357,10 @@ int ecc_object_deletemember(eccobject_t* self, eccindexkey_t member)
         return 0;
     }
     object->hmapmapitems[slot].hmapmapvalue = ECCValConstUndefined;
-    self->hmapmapitems[refSlot].slot[member.data.depth[3]] = 0;
+    if(entry != UINT32_MAX)
+    {
+        ecc_object_indexremove(self->hmapmapitems, entry);
+    }
     return 1;
 }
 
@@ -1128,44 +1408,27 @@ void ecc_object_packvalue(eccobject_t* self)
     size_t needed;
     uint32_t index;
     uint32_t valueIndex;
-    uint32_t copyIndex;
-    uint32_t slot;
-    ecchashmap_t data;
+    uint32_t indexed;
     ecchashmap_t* tmp;
     index = 2;
     valueIndex = 2;
     assert(self);
-    for(; index < self->hmapmapcount; ++index)
+    /* values of a shaped object are already packed */
+    if(!self->shape)
     {
-        if(self->hmapmapitems[index].hmapmapvalue.check == 1)
+        indexed = ecc_object_indexstart(self->hmapmapitems);
+        for(; index < self->hmapmapcount; ++index)
         {
-            data = self->hmapmapitems[index];
-            for(copyIndex = index; copyIndex > valueIndex; --copyIndex)
-            {
-                self->hmapmapitems[copyIndex] = self->hmapmapitems[copyIndex - 1];
-                if(!(self->hmapmapitems[copyIndex].hmapmapvalue.check == 1))
-                {
-                    for(slot = 0; slot < 16; ++slot)
-                    {
-                        if(self->hmapmapitems[copyIndex].slot[slot] == index)
-                        {
-                            self->hmapmapitems[copyIndex].slot[slot] = valueIndex;
-                        }
-                        else if(self->hmapmapitems[copyIndex].slot[slot] >= valueIndex && self->hmapmapitems[copyIndex].slot[slot] < index)
-                        {
-                            self->hmapmapitems[copyIndex].slot[slot]++;
-                        }
-                    }
-                }
-            }
-            for(slot = 0; slot < 16; ++slot)
+            if(self->hmapmapitems[index].hmapmapvalue.check == 1)
             {
-                if(self->hmapmapitems[1].slot[slot] >= valueIndex && self->hmapmapitems[1].slot[slot] < index)
-                {
-                    self->hmapmapitems[1].slot[slot]++;
-                }
+                self->hmapmapitems[valueIndex++] = self->hmapmapitems[index];
             }
-            self->hmapmapitems[valueIndex++] = data;
+        }
+        self->hmapmapcount = valueIndex;
+        memset(self->hmapmapitems + 1, 0, sizeof(*self->hmapmapitems));
+        if(indexed)
+        {
+            ecc_object_buildindex(self, valueIndex - 2);
         }
     }
     needed = (sizeof(*self->hmapmapitems) * (self->hmapmapcount));
@@ -1201,6 +1464,7 @@ void ecc_object_stripmap(eccobject_t* self)
         fprintf(stderr, "in stripmap: failed to reallocate for %ld bytes\n", needed);
     }
     self->hmapmapitems = tmp;
+    self->shape = NULL;
     memset(self->hmapmapitems + 1, 0, sizeof(*self->hmapmapitems));
 }
 
@@ -1362,6 +1626,7 @@ void ecc_object_populateelementwithclist(eccobject_t* self, uint32_t count, cons
             eccstrbuffer_t* chars = ecc_strbuf_createsized(length);
             memcpy(chars->bytes, list[index], length);
 
+            ecc_mempool_ownerbarrier(self);
             self->hmapitemitems[index].hmapitemvalue = ecc_value_fromchars(chars);
         }
     }
@@ -1258,7 +1258,6 @@ static eccvalue_t ecc_objfnregex_exec(ecccontext_t* context)
         const char* bytes = ecc_value_stringbytes(&value);
         const char* capture[self->count * 2];
         const char* strindex[self->count * 2];
-        eccstrbuffer_t* element;
 
         eccrxstate_t state = { ecc_string_textatindex(bytes, length, lastIndex.data.integer, 0).bytes, bytes + length, capture, strindex, 0};
 
@@ -1270,10 +1269,7 @@ static eccvalue_t ecc_objfnregex_exec(ecccontext_t* context)
             for(numindex = 0, count = self->count; numindex < count; ++numindex)
             {
                 if(capture[numindex * 2])
-                {
-                    element = ecc_strbuf_createwithbytes((int32_t)(capture[numindex * 2 + 1] - capture[numindex * 2]), capture[numindex * 2]);
-                    array->hmapitemitems[numindex].hmapitemvalue = ecc_value_fromchars(element);
-                }
+                    array->hmapitemitems[numindex].hmapitemvalue = ecc_value_fromslice(&value, capture[numindex * 2], (int32_t)(capture[numindex * 2 + 1] - capture[numindex * 2]));
                 else
                     array->hmapitemitems[numindex].hmapitemvalue = ECCValConstUndefined;
             }
@@ -1350,7 +1346,7 @@ eccobjregexp_t* ecc_regexp_create(eccstrbuffer_t* s, eccobjerror_t** error, int
     eccrxparser_t p = { 0 };
 
     eccobjregexp_t* self;
-    self = (eccobjregexp_t*)malloc(sizeof(*self));
+    self = (eccobjregexp_t*)ecc_mempool_allocate(ECC_MEMKIND_OBJECT, sizeof(*self));
     memset(self, 0, sizeof(eccobjregexp_t));
     ecc_mempool_addobject(&self->object);
 
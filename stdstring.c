@@ -22,6 +22,8 @@ static eccvalue_t ecc_objfnstring_indexof(ecccontext_t *context);
 static eccvalue_t ecc_objfnstring_lastindexof(ecccontext_t *context);
 static eccvalue_t ecc_objfnstring_localecompare(ecccontext_t *context);
 static eccvalue_t ecc_objfnstring_match(ecccontext_t *context);
+static eccstrbox_t ecc_stringutil_textatindex(const eccvalue_t *value, int32_t position);
+static int32_t ecc_stringutil_unitindex(const eccvalue_t *value, int32_t offset);
 static void ecc_stringutil_replace(eccappbuf_t *chars, eccstrbox_t replace, eccstrbox_t before, eccstrbox_t match, eccstrbox_t after, int count, const char *dcap[]);
 static eccvalue_t ecc_objfnstring_replace(ecccontext_t *context);
 static eccvalue_t ecc_objfnstring_search(ecccontext_t *context);
@@ -34,6 +36,12 @@ static eccvalue_t ecc_objfnstring_trim(ecccontext_t *context);
 static eccvalue_t ecc_objfnstring_constructor(ecccontext_t *context);
 static eccvalue_t ecc_objfnstring_fromcharcode(ecccontext_t *context);
 
+/* a buffer beyond ASCII remembers where every this many UTF-16 units start, indexing walks the rest */
+#define ECC_STRING_CHECKPOINTUNITS 64
+/* checkpoint tables kept at once, by buffer address */
+#define ECC_STRING_INDEXCACHESIZE 8
+
+static eccstrindex_t g_stringindexes[ECC_STRING_INDEXCACHESIZE];
 
 eccobject_t* ECC_Prototype_String = NULL;
 eccobjfunction_t* ECC_CtorFunc_String = NULL;
@@ -67,6 +75,24 @@ static void ecc_string_typefnfinalize(eccobject_t* object)
     --self->sbuf->refcount;
 }
 
+/* string buffers are indexed through ecc_string_charsatindex, other strings from their first byte */
+static eccstrbox_t ecc_stringutil_textatindex(const eccvalue_t* value, int32_t position)
+{
+    if(value->type == ECC_VALTYPE_CHARS)
+        return ecc_string_charsatindex(ecc_strbuf_flatten(value->data.chars), position);
+
+    return ecc_string_textatindex(ecc_value_stringbytes(value), ecc_value_stringlength(value), position, 0);
+}
+
+/* the UTF-16 index of the character 'offset' bytes into the string, the other way round */
+static int32_t ecc_stringutil_unitindex(const eccvalue_t* value, int32_t offset)
+{
+    if(value->type == ECC_VALTYPE_CHARS)
+        return ecc_string_charsunitindex(ecc_strbuf_flatten(value->data.chars), offset);
+
+    return ecc_string_unitindex(ecc_value_stringbytes(value), ecc_value_stringlength(value), offset);
+}
+
 static eccvalue_t ecc_objfnstring_tostring(ecccontext_t* context)
 {
     ecc_context_assertthistype(context, ECC_VALTYPE_STRING);
@@ -83,18 +109,15 @@ static eccvalue_t ecc_objfnstring_valueof(ecccontext_t* context)
 
 static eccvalue_t ecc_objfnstring_charat(ecccontext_t* context)
 {
-    int32_t index, length;
-    const char* chars;
+    int32_t index;
     eccstrbox_t text;
 
     ecc_context_assertthiscoercibleprimitive(context);
 
     context->thisvalue = ecc_value_tostring(context, context->thisvalue);
-    chars = ecc_value_stringbytes(&context->thisvalue);
-    length = ecc_value_stringlength(&context->thisvalue);
     index = ecc_value_tointeger(context, ecc_context_argument(context, 0)).data.integer;
 
-    text = ecc_string_textatindex(chars, length, index, 0);
+    text = ecc_stringutil_textatindex(&context->thisvalue, index);
     if(!text.length)
         return ecc_value_fromtext(&ECC_String_Empty);
     else
@@ -123,18 +146,15 @@ static eccvalue_t ecc_objfnstring_charat(ecccontext_t* context)
 
 static eccvalue_t ecc_objfnstring_charcodeat(ecccontext_t* context)
 {
-    int32_t index, length;
-    const char* chars;
+    int32_t index;
     eccstrbox_t text;
 
     ecc_context_assertthiscoercibleprimitive(context);
 
     context->thisvalue = ecc_value_tostring(context, context->thisvalue);
-    chars = ecc_value_stringbytes(&context->thisvalue);
-    length = ecc_value_stringlength(&context->thisvalue);
     index = ecc_value_tointeger(context, ecc_context_argument(context, 0)).data.integer;
 
-    text = ecc_string_textatindex(chars, length, index, 0);
+    text = ecc_stringutil_textatindex(&context->thisvalue, index);
     if(!text.length)
         return ecc_value_fromfloat(ECC_CONST_NAN);
     else
@@ -177,8 +197,8 @@ static eccvalue_t ecc_objfnstring_indexof(ecccontext_t* context)
 {
     eccstrbox_t text;
     eccvalue_t search, start;
-    int32_t index, length, searchLength;
-    const char *chars, *searchChars;
+    int32_t index, length, found;
+    const char* chars;
 
     ecc_context_assertthiscoercibleprimitive(context);
 
@@ -187,39 +207,31 @@ static eccvalue_t ecc_objfnstring_indexof(ecccontext_t* context)
     length = ecc_value_stringlength(&context->thisvalue);
 
     search = ecc_value_tostring(context, ecc_context_argument(context, 0));
-    searchChars = ecc_value_stringbytes(&search);
-    searchLength = ecc_value_stringlength(&search);
     start = ecc_value_tointeger(context, ecc_context_argument(context, 1));
     index = start.data.integer < 0 ? length + start.data.integer : start.data.integer;
     if(index < 0)
         index = 0;
 
-    text = ecc_string_textatindex(chars, length, index, 0);
+    text = ecc_stringutil_textatindex(&context->thisvalue, index);
     if(text.flags & ECC_TEXTFLAG_BREAKFLAG)
-    {
         ecc_strbox_nextcharacter(&text);
-        ++index;
-    }
 
-    while(text.length)
-    {
-        if(!memcmp(text.bytes, searchChars, searchLength))
-            return ecc_value_fromint(index);
+    if(!text.length)
+        return ecc_value_fromint(-1);
 
-        ++index;
-        if(ecc_strbox_nextcharacter(&text).codepoint > 0xffff)
-            ++index;
-    }
+    found = ecc_strbox_find(text, ecc_value_textof(&search));
+    if(found < 0)
+        return ecc_value_fromint(-1);
 
-    return ecc_value_fromint(-1);
+    return ecc_value_fromint(ecc_stringutil_unitindex(&context->thisvalue, (int32_t)(text.bytes - chars) + found));
 }
 
 static eccvalue_t ecc_objfnstring_lastindexof(ecccontext_t* context)
 {
-    eccstrbox_t text;
+    eccstrbox_t text, searchText;
     eccvalue_t search, start;
-    int32_t index, length, searchLength;
-    const char *chars, *searchChars;
+    int32_t index, length, found;
+    const char* chars;
 
     ecc_context_assertthiscoercibleprimitive(context);
 
@@ -228,34 +240,27 @@ static eccvalue_t ecc_objfnstring_lastindexof(ecccontext_t* context)
     length = ecc_value_stringlength(&context->thisvalue);
 
     search = ecc_value_tostring(context, ecc_context_argument(context, 0));
-    searchChars = ecc_value_stringbytes(&search);
-    searchLength = ecc_value_stringlength(&search);
+    searchText = ecc_value_textof(&search);
 
     start = ecc_value_tobinary(context, ecc_context_argument(context, 1));
-    index = ecc_string_unitindex(chars, length, length);
+    if(context->thisvalue.type == ECC_VALTYPE_CHARS)
+        index = ecc_string_unitcount(ecc_strbuf_flatten(context->thisvalue.data.chars));
+    else
+        index = ecc_string_unitindex(chars, length, length);
+
     if(!isnan(start.data.valnumfloat) && start.data.valnumfloat < index)
         index = start.data.valnumfloat < 0 ? 0 : start.data.valnumfloat;
 
-    text = ecc_string_textatindex(chars, length, index, 0);
-    if(text.flags & ECC_TEXTFLAG_BREAKFLAG)
-        --index;
-
-    text.length = (int32_t)(text.bytes - chars);
-
-    for(;;)
-    {
-        if(length - (text.bytes - chars) >= searchLength && !memcmp(text.bytes, searchChars, searchLength))
-            return ecc_value_fromint(index);
+    /* matches may start up to the character at 'index' */
+    text = ecc_stringutil_textatindex(&context->thisvalue, index);
+    index = (int32_t)(text.bytes - chars);
+    text = ecc_strbox_make(chars, length - index > searchText.length ? index + searchText.length : length);
 
-        if(!text.length)
-            break;
-
-        --index;
-        if(ecc_strbox_prevcharacter(&text).codepoint > 0xffff)
-            --index;
-    }
+    found = ecc_strbox_findlast(text, searchText);
+    if(found < 0)
+        return ecc_value_fromint(-1);
 
-    return ecc_value_fromint(-1);
+    return ecc_value_fromint(ecc_stringutil_unitindex(&context->thisvalue, found));
 }
 
 static eccvalue_t ecc_objfnstring_localecompare(ecccontext_t* context)
@@ -305,7 +310,6 @@ static eccvalue_t ecc_objfnstring_match(ecccontext_t* context)
         const char* capture[regexp->count * 2];
         const char* strindex[regexp->count * 2];
         eccobject_t* array = ecc_array_create();
-        eccappbuf_t chars;
         uint32_t size = 0;
 
         do
@@ -314,9 +318,7 @@ static eccvalue_t ecc_objfnstring_match(ecccontext_t* context)
 
             if(ecc_regexp_matchwithstate(regexp, &state))
             {
-                ecc_strbuf_beginappend(&chars);
-                ecc_strbuf_append(&chars, "%.*s", capture[1] - capture[0], capture[0]);
-                ecc_object_addelement(array, size++, ecc_strbuf_endappend(&chars), 0);
+                ecc_object_addelement(array, size++, ecc_value_fromslice(&context->thisvalue, capture[0], (int32_t)(capture[1] - capture[0])), 0);
 
                 if(!regexp->isflagglobal)
                 {
@@ -325,11 +327,7 @@ static eccvalue_t ecc_objfnstring_match(ecccontext_t* context)
                     for(numindex = 1, count = regexp->count; numindex < count; ++numindex)
                     {
                         if(capture[numindex * 2])
-                        {
-                            ecc_strbuf_beginappend(&chars);
-                            ecc_strbuf_append(&chars, "%.*s", capture[numindex * 2 + 1] - capture[numindex * 2], capture[numindex * 2]);
-                            ecc_object_addelement(array, size++, ecc_strbuf_endappend(&chars), 0);
-                        }
+                            ecc_object_addelement(array, size++, ecc_value_fromslice(&context->thisvalue, capture[numindex * 2], (int32_t)(capture[numindex * 2 + 1] - capture[numindex * 2])), 0);
                         else
                             ecc_object_addelement(array, size++, ECCValConstUndefined, 0);
                     }
@@ -481,7 +479,7 @@ static eccvalue_t ecc_objfnstring_replace(ecccontext_t* context)
                     {
                         if(capture[numindex * 2])
                             arguments->hmapitemitems[numindex].hmapitemvalue
-                            = ecc_value_fromchars(ecc_strbuf_createwithbytes((int32_t)(capture[numindex * 2 + 1] - capture[numindex * 2]), capture[numindex * 2]));
+                            = ecc_value_fromslice(&context->thisvalue, capture[numindex * 2], (int32_t)(capture[numindex * 2 + 1] - capture[numindex * 2]));
                         else
                             arguments->hmapitemitems[numindex].hmapitemvalue = ECCValConstUndefined;
                     }
@@ -536,7 +534,7 @@ static eccvalue_t ecc_objfnstring_replace(ecccontext_t* context)
             eccobject_t* arguments = ecc_array_createsized(1 + 2);
             eccvalue_t result;
 
-            arguments->hmapitemitems[0].hmapitemvalue = ecc_value_fromchars(ecc_strbuf_createwithbytes(text.length, text.bytes));
+            arguments->hmapitemitems[0].hmapitemvalue = ecc_value_fromslice(&context->thisvalue, text.bytes, text.length);
             arguments->hmapitemitems[1].hmapitemvalue = ecc_value_fromint(ecc_string_unitindex(bytes, length, (int32_t)(text.bytes - bytes)));
             arguments->hmapitemitems[2].hmapitemvalue = context->thisvalue;
 
@@ -628,6 +626,8 @@ static eccvalue_t ecc_objfnstring_slice(ecccontext_t* context)
 
     if(head + length + tail <= 0)
         return ecc_value_fromtext(&ECC_String_Empty);
+    else if(!head && !tail)
+        return ecc_value_fromslice(&context->thisvalue, start.bytes, length);
     else
     {
         eccstrbuffer_t* result = ecc_strbuf_createsized(length + head + tail);
@@ -656,7 +656,6 @@ static eccvalue_t ecc_objfnstring_split(ecccontext_t* context)
     eccvalue_t separatorValue, limitValue;
     eccobjregexp_t* regexp = NULL;
     eccobject_t* array;
-    eccstrbuffer_t* element;
     eccstrbox_t text, separator = { 0 };
     uint32_t size = 0, limit = UINT32_MAX;
 
@@ -714,8 +713,7 @@ static eccvalue_t ecc_objfnstring_split(ecccontext_t* context)
                     continue;
                 }
 
-                element = ecc_strbuf_createwithbytes((int32_t)(capture[0] - text.bytes), text.bytes);
-                ecc_object_addelement(array, size++, ecc_value_fromchars(element), 0);
+                ecc_object_addelement(array, size++, ecc_value_fromslice(&context->thisvalue, text.bytes, (int32_t)(capture[0] - text.bytes)), 0);
 
                 for(numindex = 1, count = regexp->count; numindex < count; ++numindex)
                 {
@@ -723,10 +721,7 @@ static eccvalue_t ecc_objfnstring_split(ecccontext_t* context)
                         break;
 
                     if(capture[numindex * 2])
-                    {
-                        element = ecc_strbuf_createwithbytes((int32_t)(capture[numindex * 2 + 1] - capture[numindex * 2]), capture[numindex * 2]);
-                        ecc_object_addelement(array, size++, ecc_value_fromchars(element), 0);
-                    }
+                        ecc_object_addelement(array, size++, ecc_value_fromslice(&context->thisvalue, capture[numindex * 2], (int32_t)(capture[numindex * 2 + 1] - capture[numindex * 2])), 0);
                     else
                         ecc_object_addelement(array, size++, ECCValConstUndefined, 0);
                 }
@@ -736,8 +731,7 @@ static eccvalue_t ecc_objfnstring_split(ecccontext_t* context)
             }
             else
             {
-                element = ecc_strbuf_createwithbytes(text.length, text.bytes);
-                ecc_object_addelement(array, size++, ecc_value_fromchars(element), 0);
+                ecc_object_addelement(array, size++, ecc_value_fromslice(&context->thisvalue, text.bytes, text.length), 0);
                 break;
             }
         }
@@ -774,34 +768,16 @@ static eccvalue_t ecc_objfnstring_split(ecccontext_t* context)
     }
     else
     {
-        eccstrbox_t seek = text;
         int32_t length;
 
-        while(seek.length >= separator.length)
+        while(size < limit && (length = ecc_strbox_find(text, separator)) >= 0)
         {
-            if(size >= limit)
-                break;
-
-            if(!memcmp(seek.bytes, separator.bytes, separator.length))
-            {
-                length = (int32_t)(seek.bytes - text.bytes);
-                element = ecc_strbuf_createsized(length);
-                memcpy(element->bytes, text.bytes, length);
-                ecc_object_addelement(array, size++, ecc_value_fromchars(element), 0);
-
-                ecc_strbox_advance(&text, length + separator.length);
-                seek = text;
-                continue;
-            }
-            ecc_strbox_nextcharacter(&seek);
+            ecc_object_addelement(array, size++, ecc_value_fromslice(&context->thisvalue, text.bytes, length), 0);
+            ecc_strbox_advance(&text, length + separator.length);
         }
 
         if(size < limit)
-        {
-            element = ecc_strbuf_createsized(text.length);
-            memcpy(element->bytes, text.bytes, text.length);
-            ecc_object_addelement(array, size++, ecc_value_fromchars(element), 0);
-        }
+            ecc_object_addelement(array, size++, ecc_value_fromslice(&context->thisvalue, text.bytes, text.length), 0);
     }
 
     return ecc_value_object(array);
@@ -825,7 +801,7 @@ static eccvalue_t ecc_objfnstring_substring(ecccontext_t* context)
     else if(from.type == ECC_VALTYPE_BINARY && from.data.valnumfloat == ECC_CONST_INFINITY)
         start = ecc_strbox_make(chars + length, 0);
     else
-        start = ecc_string_textatindex(chars, length, ecc_value_tointeger(context, from).data.integer, 0);
+        start = ecc_stringutil_textatindex(&context->thisvalue, ecc_value_tointeger(context, from).data.integer);
 
     to = ecc_context_argument(context, 1);
     if(to.type == ECC_VALTYPE_UNDEFINED || (to.type == ECC_VALTYPE_BINARY && to.data.valnumfloat == ECC_CONST_INFINITY))
@@ -833,7 +809,7 @@ static eccvalue_t ecc_objfnstring_substring(ecccontext_t* context)
     else if(to.type == ECC_VALTYPE_BINARY && !isfinite(to.data.valnumfloat))
         end = ecc_strbox_make(chars, length);
     else
-        end = ecc_string_textatindex(chars, length, ecc_value_tointeger(context, to).data.integer, 0);
+        end = ecc_stringutil_textatindex(&context->thisvalue, ecc_value_tointeger(context, to).data.integer);
 
     if(start.bytes > end.bytes)
     {
@@ -855,6 +831,8 @@ static eccvalue_t ecc_objfnstring_substring(ecccontext_t* context)
 
     if(head + length + tail <= 0)
         return ecc_value_fromtext(&ECC_String_Empty);
+    else if(!head && !tail)
+        return ecc_value_fromslice(&context->thisvalue, start.bytes, length);
     else
     {
         eccstrbuffer_t* result = ecc_strbuf_createsized(length + head + tail);
@@ -914,7 +892,6 @@ static eccvalue_t ecc_objfnstring_touppercase(ecccontext_t* context)
 
 static eccvalue_t ecc_objfnstring_trim(ecccontext_t* context)
 {
-    eccstrbuffer_t* chars;
     eccstrbox_t text, last;
     eccrune_t c;
 
@@ -941,9 +918,7 @@ static eccvalue_t ecc_objfnstring_trim(ecccontext_t* context)
         text.length = last.length;
     }
 
-    chars = ecc_strbuf_createwithbytes(text.length, text.bytes);
-
-    return ecc_value_fromchars(chars);
+    return ecc_value_fromslice(&context->thisvalue, text.bytes, text.length);
 }
 
 static eccvalue_t ecc_objfnstring_constructor(ecccontext_t* context)
@@ -1009,8 +984,15 @@ void ecc_string_setup()
 
 void ecc_string_teardown(void)
 {
+    uint32_t index;
+
     ECC_Prototype_String = NULL;
     ECC_CtorFunc_String = NULL;
+
+    for(index = 0; index < ECC_STRING_INDEXCACHESIZE; ++index)
+        free(g_stringindexes[index].pointvals);
+
+    memset(g_stringindexes, 0, sizeof(g_stringindexes));
 }
 
 eccobjstring_t* ecc_string_create(eccstrbuffer_t* chars)
@@ -1020,17 +1002,15 @@ eccobjstring_t* ecc_string_create(eccstrbuffer_t* chars)
     const eccvalflag_t s = ECC_VALFLAG_SEALED;
     uint32_t length;
     eccobjstring_t* self;
-    self = (eccobjstring_t*)malloc(sizeof(*self));
+    self = (eccobjstring_t*)ecc_mempool_allocate(ECC_MEMKIND_OBJECT, sizeof(*self));
     memset(self, 0, sizeof(eccobjstring_t));
     ecc_mempool_addobject(&self->object);
     ecc_object_initialize(&self->object, ECC_Prototype_String);
-    length = ecc_string_unitindex(chars->bytes, chars->length, chars->length);
+    length = ecc_string_unitcount(chars);
     ecc_object_addmember(&self->object, ECC_ConstKey_length, ecc_value_fromint(length), r | h | s);
+    /* the wrapper may share a buffer others hold, its reference is dropped in ecc_string_typefnfinalize */
+    ++chars->refcount;
     self->sbuf = chars;
-    if(length == (uint32_t)chars->length)
-    {
-        chars->flags |= ECC_CHARBUFFLAG_ASCIIONLY;
-    }
     return self;
 }
 
@@ -1039,7 +1019,7 @@ eccvalue_t ecc_string_valueatindex(eccobjstring_t* self, int32_t index)
     eccrune_t c;
     eccstrbox_t text;
 
-    text = ecc_string_textatindex(self->sbuf->bytes, self->sbuf->length, index, 0);
+    text = ecc_string_charsatindex(self->sbuf, index);
     c = ecc_strbox_character(text);
 
     if(c.units <= 0)
@@ -1066,6 +1046,155 @@ eccvalue_t ecc_string_valueatindex(eccobjstring_t* self, int32_t index)
     }
 }
 
+/* counts the units of 'chars' once, noting ASCIIONLY, or returns the checkpoints of a buffer beyond ASCII */
+static eccstrindex_t* ecc_string_indexchars(eccstrbuffer_t* chars)
+{
+    eccstrindex_t* index = &g_stringindexes[((uintptr_t)chars >> 4) % ECC_STRING_INDEXCACHESIZE];
+    const char* bytes = ecc_strbuf_bytes(chars);
+    eccstrbox_t text;
+    eccrune_t c;
+    int32_t unit;
+    uint32_t needed;
+
+    if(chars->flags & ECC_CHARBUFFLAG_ASCIIONLY)
+        return NULL;
+    else if(chars->flags & ECC_CHARBUFFLAG_INDEXED && index->chars == chars)
+        return index;
+
+    if(!(chars->flags & ECC_CHARBUFFLAG_INDEXED))
+    {
+        for(unit = 0; unit < chars->length; ++unit)
+            if(bytes[unit] & 0x80)
+                break;
+
+        chars->flags |= ECC_CHARBUFFLAG_INDEXED;
+        if(unit == chars->length)
+        {
+            chars->flags |= ECC_CHARBUFFLAG_ASCIIONLY;
+            return NULL;
+        }
+    }
+
+    /* units never outnumber bytes */
+    needed = chars->length / ECC_STRING_CHECKPOINTUNITS + 1;
+    if(index->pointcapacity < needed)
+    {
+        eccstrcheckpoint_t* grown = (eccstrcheckpoint_t*)realloc(index->pointvals, sizeof(*index->pointvals) * needed);
+        if(grown == NULL)
+        {
+            fprintf(stderr, "in indexchars: failed to reallocate for %ld bytes\n", (long)(sizeof(*index->pointvals) * needed));
+            return NULL;
+        }
+        index->pointvals = grown;
+        index->pointcapacity = needed;
+    }
+
+    text = ecc_strbox_make(bytes, chars->length);
+    index->pointcount = 0;
+    unit = 0;
+    while(text.length)
+    {
+        if(unit >= (int32_t)index->pointcount * ECC_STRING_CHECKPOINTUNITS)
+        {
+            index->pointvals[index->pointcount].unit = unit;
+            index->pointvals[index->pointcount].offset = (int32_t)(text.bytes - bytes);
+            ++index->pointcount;
+        }
+        c = ecc_strbox_nextcharacter(&text);
+
+        /* simulate 16-bit surrogate */
+        unit += c.codepoint > 0xffff ? 2 : 1;
+    }
+    index->chars = chars;
+    index->units = unit;
+    return index;
+}
+
+int32_t ecc_string_unitcount(eccstrbuffer_t* chars)
+{
+    eccstrindex_t* index = ecc_string_indexchars(chars);
+
+    if(index)
+        return index->units;
+    else if(chars->flags & ECC_CHARBUFFLAG_ASCIIONLY)
+        return chars->length;
+
+    return ecc_string_unitindex(ecc_strbuf_bytes(chars), chars->length, chars->length);
+}
+
+/* ecc_string_textatindex for a string buffer, without reverse positions: direct for ASCII, from the closest checkpoint otherwise */
+eccstrbox_t ecc_string_charsatindex(eccstrbuffer_t* chars, int32_t position)
+{
+    eccstrindex_t* index;
+    const eccstrcheckpoint_t* point;
+    const char* bytes = ecc_strbuf_bytes(chars);
+    uint32_t count;
+
+    if(position <= 0)
+        return ecc_string_textatindex(bytes, chars->length, position, 0);
+
+    index = ecc_string_indexchars(chars);
+    if(!index)
+    {
+        if(!(chars->flags & ECC_CHARBUFFLAG_ASCIIONLY))
+            return ecc_string_textatindex(bytes, chars->length, position, 0);
+
+        if(position > chars->length)
+            position = chars->length;
+
+        return ecc_strbox_make(bytes + position, chars->length - position);
+    }
+
+    if(position >= index->units)
+        return ecc_strbox_make(bytes + chars->length, 0);
+
+    /* checkpoint n is at unit n * ECC_STRING_CHECKPOINTUNITS, or one past it when that unit halves a surrogate pair */
+    count = position / ECC_STRING_CHECKPOINTUNITS;
+    if(count >= index->pointcount)
+        count = index->pointcount - 1;
+
+    point = &index->pointvals[count];
+    if(point->unit > position)
+        --point;
+
+    return ecc_string_textatindex(bytes + point->offset, chars->length - point->offset, position - point->unit, 0);
+}
+
+/* the UTF-16 index of the character 'offset' bytes into 'chars', counted from the closest checkpoint before it */
+int32_t ecc_string_charsunitindex(eccstrbuffer_t* chars, int32_t offset)
+{
+    eccstrindex_t* index;
+    const eccstrcheckpoint_t* point;
+    uint32_t lower, upper, middle;
+
+    if(offset > chars->length)
+        offset = chars->length;
+
+    index = ecc_string_indexchars(chars);
+    if(!index)
+    {
+        if(chars->flags & ECC_CHARBUFFLAG_ASCIIONLY)
+            return offset;
+
+        return ecc_string_unitindex(ecc_strbuf_bytes(chars), chars->length, offset);
+    }
+
+    /* the last checkpoint at or before 'offset'; the first one is at 0 */
+    lower = 0;
+    upper = index->pointcount;
+    while(upper - lower > 1)
+    {
+        middle = lower + (upper - lower) / 2;
+        if(index->pointvals[middle].offset <= offset)
+            lower = middle;
+        else
+            upper = middle;
+    }
+    point = &index->pointvals[lower];
+
+    return point->unit + ecc_string_unitindex(ecc_strbuf_bytes(chars) + point->offset, chars->length - point->offset, offset - point->offset);
+}
+
 eccstrbox_t ecc_string_textatindex(const char* chars, int32_t length, int32_t position, int enableReverse)
 {
     eccstrbox_t text = ecc_strbox_make(chars, length), prev;
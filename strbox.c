@@ -8,6 +8,11 @@
 
 #include "ecc.h"
 
+#if defined(__SSE2__) && defined(__GNUC__)
+    #include <emmintrin.h>
+    #define ECC_STRBOX_SSE2 1
+#endif
+
 #define _textMake(name, litstr)               \
     static const char cstr_##name[] = litstr; \
     const eccstrbox_t name = { cstr_##name, sizeof(cstr_##name) - 1, 0 }
@@ -590,6 +595,112 @@ void ecc_strbox_advance(eccstrbox_t* text, int32_t units)
     }
 }
 
+/*
+// byte offset of the first 'search' within 'text', or -1. UTF-8 never starts a character inside another,
+// so any match found in the bytes is at a character; callers turn the offset into units once.
+// 16 positions at a time, those holding both the first and the last byte of 'search' are compared in full.
+*/
+int32_t ecc_strbox_find(eccstrbox_t text, eccstrbox_t search)
+{
+    const char* found;
+    int32_t offset = 0, last;
+
+    if(search.length > text.length)
+        return -1;
+    else if(search.length <= 1)
+    {
+        if(!search.length)
+            return 0;
+
+        found = (const char*)memchr(text.bytes, search.bytes[0], text.length);
+        return found ? (int32_t)(found - text.bytes) : -1;
+    }
+
+    last = text.length - search.length;
+
+#if ECC_STRBOX_SSE2
+    {
+        const __m128i first = _mm_set1_epi8(search.bytes[0]);
+        const __m128i final = _mm_set1_epi8(search.bytes[search.length - 1]);
+        __m128i head, tail;
+        uint32_t mask, bit;
+
+        for(; offset + 15 <= last; offset += 16)
+        {
+            head = _mm_loadu_si128((const __m128i*)(text.bytes + offset));
+            tail = _mm_loadu_si128((const __m128i*)(text.bytes + offset + search.length - 1));
+            mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, final)));
+            while(mask)
+            {
+                bit = __builtin_ctz(mask);
+                if(!memcmp(text.bytes + offset + bit + 1, search.bytes + 1, search.length - 2))
+                    return offset + bit;
+
+                mask &= mask - 1;
+            }
+        }
+    }
+#endif
+
+    while(offset <= last)
+    {
+        found = (const char*)memchr(text.bytes + offset, search.bytes[0], last - offset + 1);
+        if(!found)
+            break;
+
+        offset = (int32_t)(found - text.bytes);
+        if(found[search.length - 1] == search.bytes[search.length - 1] && !memcmp(found + 1, search.bytes + 1, search.length - 2))
+            return offset;
+
+        ++offset;
+    }
+    return -1;
+}
+
+/* byte offset of the last 'search' lying wholly within 'text', or -1 (see ecc_strbox_find) */
+int32_t ecc_strbox_findlast(eccstrbox_t text, eccstrbox_t search)
+{
+    int32_t offset;
+
+    if(search.length > text.length)
+        return -1;
+    else if(!search.length)
+        return text.length;
+
+    offset = text.length - search.length;
+
+#if ECC_STRBOX_SSE2
+    {
+        const __m128i first = _mm_set1_epi8(search.bytes[0]);
+        const __m128i final = _mm_set1_epi8(search.bytes[search.length - 1]);
+        __m128i head, tail;
+        uint32_t mask, bit;
+
+        /* the 16 positions ending at 'offset' */
+        for(; offset >= 15; offset -= 16)
+        {
+            head = _mm_loadu_si128((const __m128i*)(text.bytes + offset - 15));
+            tail = _mm_loadu_si128((const __m128i*)(text.bytes + offset - 15 + search.length - 1));
+            mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, final)));
+            while(mask)
+            {
+                bit = 31 - __builtin_clz(mask);
+                if(!memcmp(text.bytes + offset - 15 + bit, search.bytes, search.length))
+                    return offset - 15 + bit;
+
+                mask &= ~(UINT32_C(1) << bit);
+            }
+        }
+    }
+#endif
+
+    for(; offset >= 0; --offset)
+        if(text.bytes[offset] == search.bytes[0] && !memcmp(text.bytes + offset, search.bytes, search.length))
+            return offset;
+
+    return -1;
+}
+
 uint32_t ecc_strbox_toutf16length(eccstrbox_t text)
 {
     uint32_t windex;
@@ -0,0 +1,31 @@
+/*
+ * tail call benchmark: strict functions returning calls to other functions (see ecc_oper_tailcall).
+ * chains are kept under the maximum call depth so that builds without ECC_CONF_TAILCALLS run it too;
+ * pass a depth beyond it to see chains run in constant stack.
+ * usage: run tailbench.js [count] [depth]
+ */
+var count = +(arguments[0] || 1000000), depth = +(arguments[1] || 500);
+
+function even(n) { "use strict"; return n ? odd(n - 1) : true; }
+function odd(n) { "use strict"; return n ? even(n - 1) : false; }
+
+var machine = {
+    total: 0,
+    run: function (n) { "use strict"; return n ? this.add(n, 1) : this.total; },
+    add: function (n, k) { "use strict"; this.total += k; return this.run(n - 1); },
+};
+
+function apply(op, n, acc) { "use strict"; return n ? op(op, n - 1, acc + n) : acc; }
+
+var start = (new Date).getTime(), result = 0, times = [], i;
+for (i = 0; i < count; i += depth)
+    result += even(depth) ? 1 : 0;
+times.push((new Date).getTime() - start), start = (new Date).getTime();
+for (i = 0; i < count; i += depth)
+    result += machine.run(depth);
+times.push((new Date).getTime() - start), start = (new Date).getTime();
+for (i = 0; i < count; i += depth)
+    result += apply(apply, depth, 0);
+times.push((new Date).getTime() - start);
+
+println("even/odd " + times[0] + " ms, methods " + times[1] + " ms, apply " + times[2] + " ms (" + result + ")");
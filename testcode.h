@@ -284,6 +284,15 @@ static void ecc_unittest_testoperator (void)
 	test("10 ^ 3", "9", NULL);
 	test("10 | 3", "11", NULL);
 	test("var u = undefined; u += 123.;", "NaN", NULL);
+	test("function f(a, b) { return a + b } for (var i = 0; i < 20; ++i) f(i, i); [f(2147483647, 1), f('a', 1), f(1, 2)].join()", "2147483648,a1,3", NULL);
+	test("function f(a, b) { return a * b } for (var i = 0; i < 20; ++i) f(i, i); [f(65536, 65536), 1 / f(0, -1), f(6, 7)].join()", "4294967296,-Infinity,42", NULL);
+	test("function f(a, b) { return a >>> b } for (var i = 0; i < 20; ++i) f(i, 1); [f(-1, 0), f(-8, 28), f(8, 1)].join()", "4294967295,15,4", NULL);
+	test("function f(a, b) { return a << b ^ a } for (var i = 0; i < 20; ++i) f(i, 1); [f(1, 31), f(1.5, 2), f('3', 1)].join()", "-2147483647,5,5", NULL);
+	test("function f(a, b) { return a + b + 1 } for (var i = 0; i < 20; ++i) f(i, i); [f(2147483647, 0), f('a', 1), f(1, 2)].join()", "2147483648,a11,4", NULL);
+	test("function f(a, b) { var c = a + b; c = c + 1; return c < b ? 'less' : c } [f('x', 1), f(1, 2), f(2147483647, 0)].join()", "x11,4,2147483648", NULL);
+	test("function f(a, b) { var n = 0; if (a < b) n = n + 1; if (a >= b) n = n + 2; return n } [f(1, 2), f(NaN, 1), f('b', 'a'), f(-0, 0)].join()", "1,0,2,2", NULL);
+	test("function f() { var s = 'abc', o; return s.length + o.x } f()", "TypeError: cannot convert 'o' to object"
+	,    "                                                   ^        ");
 }
 
 static void ecc_unittest_testequality (void)
@@ -519,11 +528,21 @@ static void ecc_unittest_testfunction (void)
 	test("function f(n,a,b){ if (n > 0) return f(n - 1, b, a + b); else return a }; f(10, 0, 1)", "55", NULL);
 	test("function f(n,a,b){ if (arguments[0] > 0) return f(arguments[0] - 1, arguments[2], arguments[1] + arguments[2]); else return arguments[1] }; f(10, 0, 1)", "55", NULL);
 	test("var f = function exp(x){ if (x == 1) return x; else return exp(x - 1) * x; }; f(3)", "6", NULL);
+	test("function g(){ function f(n, a){ if (!n) return a; return f(n - 1, a + 1) } return f(10000, 0) } g()", "10000", NULL);
+	test("function even(n){ 'use strict'; return n ? odd(n - 1) : true } function odd(n){ 'use strict'; return n ? even(n - 1) : false } even(100001)", "false", NULL);
+	test("var o = { n: 0, f: function(k){ 'use strict'; if (!k) return this.n; this.n++; return this['f'](k - 1, arguments) } }; o.f(20000)", "20000", NULL);
+	test("function f(k){ 'use strict'; try { return k && f(k - 1) } catch (e) { return e } } String(f(5000)).slice(0, 10)", "RangeError", NULL);
 	test("function a(){ function b(){} return b }; var c = a(); c.prototype == c.prototype", "true", NULL);
 	test("function a(){ function b(){} return b }; var c = a(); c == c.prototype.constructor", "true", NULL);
 	test("function a(){ function b(){} return b }; var c = a(), d = a(); c == d", "false", NULL);
 	test("function a(){ function b(){} return b }; var c = a(), d = a(); c.prototype == d.prototype", "false", NULL);
+	test("function counter(){ var n = 0, t = 1; return function(){ return n += t } }; var a = counter(), b = counter(); a(); a(); b(); a() + ',' + b()", "3,2", NULL);
+	test("function f(x, y){ var z = y * 2; function g(){ x += 1 } g(); g(); return x + z } f(1, 10)", "23", NULL);
+	test("function a(x){ var u = 0; return function(y){ var v = 0; return function(z){ return x + y + z + u + v + 4 } } }; a(1)(2)(3)", "10", NULL);
+	test("function f(x, y){ var a = 1, b = 2, c = 3, d = 4, e = 5, g = 6, h = 7, i = 8, j = 9, k = 10, l = 11, m = 12; function inc(){ x += a } inc(); inc(); return function(z){ return x + z + m } } f(1, 10)(100)", "115", NULL);
 	test("function a(){ function b(){} return b }; var c = a(), d = a(); c.prototype.constructor == d.prototype.constructor", "false", NULL);
+	test("function f(a) { return arguments } var g = f((collect('young'), 1), { v: 5 }, [ 7, { z: 9 } ]), t = []; for (var i = 0; i < 3000; ++i) t[i % 50] = { w: i }; collect('young'); for (i = 0; i < 3000; ++i) t[i % 50] = { u: [i] }; JSON.stringify([].slice.call(g))", "[1,{\"v\":5},[7,{\"z\":9}]]", NULL);
+	test("function f(a, b, c) { return function(){ return [a, b, c] } } var g = f((collect('young'), 1), { v: 5 }, [ 7, { z: 9 } ]), t = []; for (var i = 0; i < 3000; ++i) t[i % 50] = { w: i }; collect('young'); for (i = 0; i < 3000; ++i) t[i % 50] = { u: [i] }; JSON.stringify(g())", "[1,{\"v\":5},[7,{\"z\":9}]]", NULL);
 }
 
 static void ecc_unittest_testloop (void)
@@ -553,6 +572,13 @@ static void ecc_unittest_testloop (void)
 	test("while (1) break abc;", "SyntaxError: label not found"
 	,    "                ^~~ ");
 	test("var a; do a = 1; while (false); a", "1", NULL);
+	test("var s = 0; for (var i = 0; i < 10; ++i) { try { if (i == 3) continue; s += i; if (i == 8) break; } finally { s += 100 } } s", "933", NULL);
+	test("var s = ''; a: for (var i = 0; i < 3; ++i) { switch (i) { case 1: continue a; default: s += i } s += ';' } s", "0;2;", NULL);
+	test("var s = 0, t = ''; for (var i = 0; i < 300; ++i) { s = s + i / 2; if (i % 100 == 7) t = t + i; } s + t", "224257107207", NULL);
+	test("function f(a, b) { return (a ^ b) << 3 >>> 1 | a & 7 } var h = 0; for (var i = 0; i < 500; i++) h = f(h, i) - 1.5; h", "2047820897.5", NULL);
+	test("var n = 0, i = 0; while (i < 400) { i = i + 1; if (i % 3 == 0) continue; var j = 0; while (true) { if (++j > 2) break; n = n + j } if (i > 350) break } n", "705", NULL);
+	test("var r; try { for (var i = 0; i < 300; ++i) if (i > 250) null.x; } catch (e) { r = i + ' ' + e } r", "251 TypeError: cannot convert 'null' to object", NULL);
+	test("function c(a, b) { return (a < b) + (a <= b) * 2 + (a > b) * 4 + (a >= b) * 8 + (a == b) * 16 + (a !== b) * 32 } var s = 0; for (var i = 0; i < 150; ++i) s += c(i % 3, 1) + c(NaN, i) + c('b', 'a' + i); s", "16650", NULL);
 }
 
 static void ecc_unittest_testthis (void)
@@ -687,6 +713,22 @@ static void ecc_unittest_testobject (void)
 	test("var a = [ 'abc', 'def' ]; Object.defineProperty(a, 1, {get: function(){ return this.length; }}); a.pop()", "2", NULL);
 	test("var a = []; Object.defineProperty(a, 2, {get: function(){}}); a.pop()", "TypeError: '2' is non-configurable"
 	,    "                                                              ^~~~~~~");
+	test("function F(){}; F.prototype.m = function(){ return 1 }; var o = new F, r = ''; for (var i = 0; i < 3; ++i) { r += o.m(); if (i == 1) o.m = function(){ return 2 } } r", "112", NULL);
+	test("function A(){}; A.prototype.f = function(){ return 'a' }; function B(){}; B.prototype = new A; var b = new B, r = ''; for (var i = 0; i < 3; ++i) { r += b.f(); if (i == 1) B.prototype.f = function(){ return 'b' } } r", "aab", NULL);
+	test("var a = [{x:1},{y:0,x:2},{z:0,y:0,x:3},{w:0,z:0,y:0,x:4},{v:0,x:5},{x:6}], s = 0; for (var i = 0; i < a.length; ++i) s += a[i].x; s", "21", NULL);
+	test("var o = {a:1,b:2}, r = ''; for (var i = 0; i < 3; ++i) { r += o.b; if (i == 0) delete o.b; if (i == 1) o.b = 3 } r", "2undefined3", NULL);
+	test("var p = { set x(v) { this.y = v } }, o = Object.create(p); for (var i = 0; i < 2; ++i) o.x = i; o.y + ',' + o.hasOwnProperty('x')", "1,false", NULL);
+	test("var o = {}; for (var i = 0; i < 40; ++i) o['k' + i] = i; var s = 0; for (var k in o) s += o[k]; s + ',' + o.k39 + ',' + Object.keys(o).length", "780,39,40", NULL);
+	test("var p = { a: 1, b: 2, c: 3 }; delete p.b; p.d = 4; p.a + ',' + p.b + ',' + p.c + ',' + p.d + ',' + ('b' in p)", "1,undefined,3,4,false", NULL);
+	test("function F(x) { this.x = x; this.y = x * 2 } var f = new F(2), g = new F(3); g.z = 1; f.y + g.y + JSON.stringify(f) + JSON.stringify(g)", "10{\"x\":2,\"y\":4}{\"x\":3,\"y\":6,\"z\":1}", NULL);
+	test("var o = {}, s = 0; for (var i = 0; i < 300; ++i) o['m' + i] = i; for (var i = 0; i < 300; i += 2) delete o['m' + i]; for (var i = 0; i < 300; ++i) s += o['m' + i] || 0; s + ',' + ('m2' in o) + ',' + ('m3' in o)", "22500,false,true", NULL);
+	test("var o = {}, r = ''; for (var i = 0; i < 50; ++i) o['n' + i] = i; delete o.n10; o.n10 = 60; o.last = 70; for (var k in o) if (k) r = k; r + o.n10 + JSON.stringify(o).slice(-28)", "last60\"n49\":49,\"n10\":60,\"last\":70}", NULL);
+	test("var o = { a: 1, b: 2 }; o.a = 5; for (var i = 0; i < 40; ++i) o['k' + i] = i; o.k3 = 33; for (; i < 500; ++i) o['k' + i] = i; o.a + ',' + o.k3 + ',' + Object.keys(o).slice(0, 2) + JSON.stringify(o).slice(0, 12)", "5,33,a,b{\"a\":5,\"b\":2", NULL);
+	test("var o = { list: [] }; collect('young'); o.list[0] = { v: 1 }; o.child = { v: 2 }; collect('young'); var r = o.list[0].v + o.child.v; o.s = 'ab'.concat('cd'); o.list.push(o.child); o.child = 0; collect('young'); collect('young'); r + o.s + o.list[1].v + o.list.length", "3abcd22", NULL);
+	test("function f(){ var a = { v: [1, 2] }, b = [a]; collect('young'); b.push({ w: 3 }); collect('young'); return b[0].v[1] + a.v.length + b[1].w } f()", "7", NULL);
+	test("var o = { a: [] }, n = 0, s = 0; while (!collect('step')) { o.a[n] = { v: ++n }; o['k' + n] = [n] } collect('full'); for (var i = 0; i < n; ++i) s += o.a[i].v + o['k' + (i + 1)][0]; n > 1 && s == n * (n + 1)", "true", NULL);
+	test("var o = { sh3: 1 }, n = collect('shapes'), m = (function(){ for (var i = 0, a = []; i < 500; ++i) { a[i] = {}; a[i]['sh' + i] = i; a[i].x = i } return collect('shapes') })(); collect('full'); var k = collect('shapes'), p = { sh3: 3 }; o.x = 2; p.x = 4; (m - n > 900) + ',' + (k <= n) + ',' + (o.sh3 + o.x + p.sh3 + p.x)", "true,true,10", NULL);
+	test("function b(n) { var l = null; for (var i = 0; i < n; ++i) l = { next: l }; return l } var k = []; k.push(b(100000)); k[0] = 0; var c = 0, l = b(10); while (l) { ++c; l = l.next } c", "10", NULL);
 }
 
 static void ecc_unittest_testerror (void)
@@ -854,6 +896,7 @@ static void ecc_unittest_testarray (void)
 	test("function f(x){return x<arguments[1]?-1: x>arguments[1]?+1: 0};var a=['araignée',,,,'zèbre'];a.sort(f)", "araignée,zèbre,,,", NULL);
 	test("function f(){return arguments[0]<arguments[1]?-1: arguments[0]>arguments[1]?+1: 0};var a=['araignée',,,,'zèbre'];a.sort(f)", "araignée,zèbre,,,", NULL);
 	test("var a = [], b = ''; a[34] = 34; Object.defineProperty(a, 12, {value: 12}); for (var i in a) b += i", "34", NULL);
+	test("var keep = [ (collect('young'), 1), { v: 5 }, [ 7, { z: 9 } ] ], t = []; for (var i = 0; i < 3000; ++i) t[i % 50] = { w: i }; collect('young'); for (i = 0; i < 3000; ++i) t[i % 50] = { u: [i] }; JSON.stringify(keep)", "[1,{\"v\":5},[7,{\"z\":9}]]", NULL);
 }
 
 static void ecc_unittest_testboolean (void)
@@ -1169,11 +1212,17 @@ static void ecc_unittest_teststring (void)
 	test("'あ𐐷𐐷せ'.lastIndexOf('𐐷')", "3", NULL);
 	test("'あ𐐷𐐷せ'.lastIndexOf('𐐷', 2)", "1", NULL);
 	test("'あ𐐷𐐷せ'.lastIndexOf('𐐷', 3)", "3", NULL);
+	test("var s = Array(50).join('aé𐐷-') + 'needle' + Array(50).join('-aé𐐷'); s.indexOf('needle') + ',' + s.indexOf('needle', 245) + ',' + s.lastIndexOf('needle') + ',' + s.lastIndexOf('needle', 244) + ',' + s.lastIndexOf('-aé', 300)", "245,245,245,-1,296", NULL);
+	test("var s = Array(40).join('x, y, ') + 'z'; s.split(', ').length + ',' + s.split(', ', 5).join('') + ',' + s.lastIndexOf('x') + ',' + s.indexOf('y, z')", "79,xyxyx,228,231", NULL);
 	test("'ab𐐷d'.substring(0, 4)", "ab𐐷", NULL);
 	test("'ab𐐷d'.substring(4)", "d", NULL);
 	test("'ab𐐷d'.substring(0, 3)", "ab\xED\xA0\x81", NULL);
 	test("'ab𐐷d'.substring(3)", "\xED\xB0\xB7""d", NULL);
 	test("'ab𐐷d'.substring(0, 3) + 'ab𐐷d'.substring(3)", "ab𐐷d", NULL);
+	test("var s = ''; for (var i = 0; i < 100; ++i) s += 'abcdefgh' + i; s.length + s.slice(-4)", "990gh99", NULL);
+	test("var s = Array(300).join('x') + 'ab𐐷d'.substring(0, 3); s += 'ab𐐷d'.substring(3); s.length + s.slice(-3)", "304𐐷d", NULL);
+	test("var x = Array(200).join('a'), y = Array(200).join('b'), s = (x + y) + (y + x); s == x + y + y + x && s.indexOf('ba')", "596", NULL);
+	test("var s = ''; for (var i = 0; i < 2000; ++i) s += 'x'; String(s.slice(0)); String(s.length); String(s.charAt(1)); var t = Array(2001).join('y'); s.slice(1).length + s.slice(-2) + s.indexOf('y') + s[1999]", "1999xx-1x", NULL);
 	test("'ab𐐷d'.slice(0, 4)", "ab𐐷", NULL);
 	test("'ab𐐷d'.slice(4)", "d", NULL);
 	test("'ab𐐷d'.slice(0, 3)", "ab\xED\xA0\x81", NULL);
@@ -1184,6 +1233,11 @@ static void ecc_unittest_teststring (void)
 	test("[].join.call('ab𐐷d')", "a,b,\xED\xA0\x81,\xED\xB0\xB7,d", NULL);
 	test("'ab𐐷d'.split('').join('')", "ab𐐷d", NULL);
 	test("'a\\0b'.charAt(2)", "b", NULL);
+	test("var s = Array(100).join('aé𐐷'); s.length + ',' + s.charCodeAt(300) + ',' + s.charCodeAt(302) + ',' + s.charCodeAt(303) + s.charAt(301) + s.substring(384, 388) + s.indexOf('a', 389)", "396,97,55297,56375éaé𐐷392", NULL);
+	test("var s = Array(21).join('0123456789'), t = s.substring(5, 150), u = t.slice(10, 100); t.length + ',' + u.length + ',' + u.slice(0, 3) + u.slice(-3) + (u == s.substring(15, 105))", "145,90,567234true", NULL);
+	test("var p = Array(4).join('abcdefghijklmnopqrstuvwxyz0123456789,').split(','); p.length + ',' + p[1].length + ',' + p[2].indexOf('xyz') + ',' + (p[0] + p[1]).trim().length", "4,36,23,72", NULL);
+	test("var m = /:(\\w{40,})$/.exec('key:' + Array(11).join('abcd')); m[1].length + m[1].slice(-2) + m.index + ('  ' + m[1] + ' ').trim().length", "40cd340", NULL);
+	test("var s = Array(100).join('abcd'); s.length + ',' + s.charCodeAt(200) + s.charAt(395) + s[393] + s.charAt(396)", "396,97db", NULL);
 	test("this.escapedText = function(){ return '\\uD801\\uDC37' }; escapedText()", "𐐷", NULL);
 	test("escapedText()", "𐐷", NULL);
 	test("'uuabc123abc'.replace(/a(bc)/, 'X')", "uuX123abc", NULL);
@@ -1310,6 +1364,7 @@ static void ecc_unittest_testjson (void)
 	test("JSON.parse('{\"abc\": [false,true,null]}').abc", "false,true,", NULL);
 	test("JSON.parse('{\"abc\": [0,1,2,3]}', function(k,v){ return typeof v == 'number'? v * 2: v }).abc", "0,2,4,6", NULL);
 	test("var r=''; JSON.parse('[1, 2, { \"a\": 4, \"b\": {\"c\": 6}}]', function(key, value) { r += key+','; return value; }); r", "0,1,a,c,b,2,,", NULL);
+	test("var s = [], o, i; for (i = 0; i < 40; ++i) s[i] = '\"k' + i + '\":' + i; o = JSON.parse('{' + s.join() + '}', function(k, v) { return typeof v == 'number'? 'n' + v: v }); for (i = 40; i < 240; ++i) o['k' + i] = i; [ o.k5, o.k39, 'k7' in o, o.k239 ].join()", "n5,n39,true,239", NULL);
 	test("JSON.stringify({ uno: 1, dos: { tres: 123 } }, null, '\t')", "{\n\t\"uno\": 1,\n\t\"dos\": {\n\t\t\"tres\": 123\n\t}\n}", NULL);
 	test("JSON.stringify({ uno: 1, dos: { tres: 123 } }, null, '  ')", "{\n  \"uno\": 1,\n  \"dos\": {\n    \"tres\": 123\n  }\n}", NULL);
 	test("JSON.stringify({ uno: 1, dos: { tres: 123 } }, null, 3)", "{\n   \"uno\": 1,\n   \"dos\": {\n      \"tres\": 123\n   }\n}", NULL);
@@ -1317,4 +1372,5 @@ static void ecc_unittest_testjson (void)
 	test("var r=''; JSON.stringify({ uno: 1, dos: { tres: 123 } }, function(key,value){ r+=key; return value }); r", "unodostres", NULL);
 	test("JSON.stringify({f:'M',w:4,t:'c',M:7}, function replacer(key,value){ return typeof value=='string'?undefined:value });", "{\"w\":4,\"M\":7}", NULL);
 	test("JSON.stringify({f:'M',w:4,t:'c',M:7}, ['w','M']);", "{\"w\":4,\"M\":7}", NULL);
+	test("var o = JSON.parse('{\"gcKey3\": 3}'), t, k; JSON.parse('{\"gcKey1\": 1, \"gcKey2\": 2}'); for (k in o) t = k; k = 0; collect('full'); JSON.stringify(JSON.parse('{\"gcKey4\": 4, \"gcKey5\": 5}')) + t + o[t]", "{\"gcKey4\":4,\"gcKey5\":5}gcKey33", NULL);
 }
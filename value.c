@@ -15,7 +15,7 @@
         .type = T, .check = 1 \
     }
 
-const eccvalue_t ECCValConstNone = { { 0 }, {}, (eccvaltype_t)0, 0, 0 };
+const eccvalue_t ECCValConstNone = { { 0 }, {}, (eccvaltype_t)0, 0, 0, 0 };
 const eccvalue_t ECCValConstUndefined = valueMake(ECC_VALTYPE_UNDEFINED);
 const eccvalue_t ECCValConstTrue = valueMake(ECC_VALTYPE_TRUE);
 const eccvalue_t ECCValConstFalse = valueMake(ECC_VALTYPE_FALSE);
@@ -164,6 +164,17 @@ eccvalue_t ecc_value_buffer(const char b[7], uint8_t units)
     return value;
 }
 
+/* 'length' bytes at 'bytes', within the string 'value': shared with it when that is a buffer (see ECC_CONF_SLICELENGTH) */
+eccvalue_t ecc_value_fromslice(const eccvalue_t* value, const char* bytes, int32_t length)
+{
+    if(length < 8)
+        return ecc_value_buffer(bytes, length);
+    else if(value->type == ECC_VALTYPE_CHARS)
+        return ecc_value_fromchars(ecc_strbuf_createslice(value->data.chars, (int32_t)(bytes - ecc_value_stringbytes(value)), length));
+
+    return ecc_value_fromchars(ecc_strbuf_createwithbytes(length, bytes));
+}
+
 eccvalue_t ecc_value_fromkey(eccindexkey_t key)
 {
     eccvalue_t v;
@@ -590,13 +601,13 @@ const char* ecc_value_stringbytes(const eccvalue_t* value)
     switch(value->type)
     {
         case ECC_VALTYPE_CHARS:
-            return value->data.chars->bytes;
+            return ecc_strbuf_bytes(value->data.chars);
 
         case ECC_VALTYPE_TEXT:
             return value->data.text->bytes;
 
         case ECC_VALTYPE_STRING:
-            return value->data.string->sbuf->bytes;
+            return ecc_strbuf_bytes(value->data.string->sbuf);
 
         case ECC_VALTYPE_BUFFER:
             return value->data.buffer;
@@ -612,13 +623,13 @@ eccstrbox_t ecc_value_textof(const eccvalue_t* value)
     switch(value->type)
     {
         case ECC_VALTYPE_CHARS:
-            return ecc_strbox_make(value->data.chars->bytes, value->data.chars->length);
+            return ecc_strbox_make(ecc_strbuf_bytes(value->data.chars), value->data.chars->length);
 
         case ECC_VALTYPE_TEXT:
             return *value->data.text;
 
         case ECC_VALTYPE_STRING:
-            return ecc_strbox_make(value->data.string->sbuf->bytes, value->data.string->sbuf->length);
+            return ecc_strbox_make(ecc_strbuf_bytes(value->data.string->sbuf), value->data.string->sbuf->length);
 
         case ECC_VALTYPE_KEY:
             return *ecc_keyidx_textof(value->data.key);
@@ -645,8 +656,11 @@ eccvalue_t ecc_value_toobject(ecccontext_t* context, eccvalue_t value)
         case ECC_VALTYPE_INTEGER:
             return ecc_value_number(ecc_number_create(value.data.integer));
 
-        case ECC_VALTYPE_TEXT:
         case ECC_VALTYPE_CHARS:
+            /* buffers are never written once made: the wrapper shares it, with a reference of its own */
+            return ecc_value_string(ecc_string_create(ecc_strbuf_flatten(value.data.chars)));
+
+        case ECC_VALTYPE_TEXT:
         case ECC_VALTYPE_BUFFER:
             return ecc_value_string(ecc_string_create(ecc_strbuf_createwithbytes(ecc_value_stringlength(&value), ecc_value_stringbytes(&value))));
 
@@ -817,6 +831,38 @@ eccvalue_t ecc_value_same(ecccontext_t* context, eccvalue_t a, eccvalue_t b)
     return ECCValConstFalse;
 }
 
+static eccstrbuffer_t* ecc_value_ropepart(eccvalue_t value)
+{
+    if(value.type == ECC_VALTYPE_CHARS)
+        return value.data.chars;
+
+    return ecc_strbuf_createwithbytes(ecc_value_stringlength(&value), ecc_value_stringbytes(&value));
+}
+
+/* a low surrogate heading 'value' may have to pair with the end of the left string, see ecc_strbuf_appendtext */
+static int ecc_value_ropecanjoin(eccvalue_t value)
+{
+    eccstrbuffer_t* chars;
+    const char* bytes;
+    int32_t length;
+
+    if(value.type == ECC_VALTYPE_CHARS)
+    {
+        chars = value.data.chars;
+        while(chars->flags & ECC_CHARBUFFLAG_ROPE)
+            chars = ((eccstrrope_t*)chars)->left;
+
+        bytes = ecc_strbuf_bytes(chars);
+        length = chars->length;
+    }
+    else
+    {
+        bytes = ecc_value_stringbytes(&value);
+        length = ecc_value_stringlength(&value);
+    }
+    return length < 2 || (uint8_t)bytes[0] != 0xED || (uint8_t)bytes[1] < 0xB0;
+}
+
 eccvalue_t ecc_value_add(ecccontext_t* context, eccvalue_t a, eccvalue_t b)
 {
     if(!ecc_value_isnumber(a) || !ecc_value_isnumber(b))
@@ -829,6 +875,20 @@ eccvalue_t ecc_value_add(ecccontext_t* context, eccvalue_t a, eccvalue_t b)
         {
             eccappbuf_t chars;
 
+            /* long results are joined lazily: repeated += then costs the appended part, not the whole string */
+            if(ecc_value_stringlength(&a) + ecc_value_stringlength(&b) >= ECC_CONF_ROPELENGTH)
+            {
+                a = ecc_value_tostring(context, a);
+                b = ecc_value_tostring(context, b);
+
+                if(!ecc_value_stringlength(&a))
+                    return b;
+                else if(!ecc_value_stringlength(&b))
+                    return a;
+                else if(ecc_value_ropecanjoin(b))
+                    return ecc_value_fromchars(ecc_strbuf_createrope(ecc_value_ropepart(a), ecc_value_ropepart(b)));
+            }
+
             ecc_strbuf_beginappend(&chars);
             ecc_strbuf_appendvalue(&chars, context, a);
             ecc_strbuf_appendvalue(&chars, context, b);